@@ -0,0 +1,713 @@
+//
+//  Bounds.hpp
+//  ForwardRenderer
+//
+//  bounding volumes over strided vertex positions. the box,
+//  centroid and extreme points come from one streaming pass,
+//  vectorised with SSE2, or AVX2 where the processor has it, and
+//  the Ritter sphere from a second. an exact Welzl sphere is
+//  available for offline use
+//
+
+#ifndef Bounds_hpp
+#define Bounds_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "Cpu.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define BOUNDS_SSE2 1
+#endif
+
+// built alongside the SSE2 kernels and picked at run time
+#if defined(BOUNDS_SSE2) && defined(CPU_X86)
+    #define BOUNDS_AVX2 1
+#endif
+
+#if defined(BOUNDS_AVX2)
+    #include <immintrin.h>
+#elif defined(BOUNDS_SSE2)
+    #include <emmintrin.h>
+    #include <xmmintrin.h>
+#endif
+
+namespace Bounds
+    {
+
+    //
+    //  Positions
+    //
+    //  float3 positions spaced stride bytes apart, so the kernels
+    //  run straight over Vertex arrays without a copy
+    //
+    struct Positions
+        {
+        const uint8_t* data   = nullptr;
+        size_t         count  = 0;
+        size_t         stride = sizeof(glm::vec3);
+
+        const float* operator [] (size_t i) const { return reinterpret_cast<const float*>(data + i * stride); }
+        glm::vec3    at          (size_t i) const { const float* p = (*this)[i]; return { p[0], p[1], p[2] }; }
+        };
+
+    template <typename T>
+    inline Positions positions (const T* items, size_t count)
+        { // Bounds :: positions
+        Positions result;
+        result.data   = count ? reinterpret_cast<const uint8_t*>(&items->position) : nullptr;
+        result.count  = count;
+        result.stride = sizeof(T);
+        return result;
+        } // Bounds :: positions
+
+    struct Sphere
+        {
+        glm::vec3 center = { 0.0f, 0.0f, 0.0f };
+        float     radius = 0.0f;
+        };
+
+    //
+    //  Extents
+    //
+    //  the first pass: box, centroid and, per axis, the first
+    //  position holding the minimum and the maximum
+    //
+    struct Extents
+        {
+        glm::vec3 min      = { 0.0f, 0.0f, 0.0f };
+        glm::vec3 max      = { 0.0f, 0.0f, 0.0f };
+        glm::vec3 centroid = { 0.0f, 0.0f, 0.0f };
+        uint32_t  minIndex[3] = { 0, 0, 0 };
+        uint32_t  maxIndex[3] = { 0, 0, 0 };
+        };
+
+    // sums are carried in float lanes this many positions at a
+    // time and then folded into doubles, so large meshes do not
+    // lose their centroid to rounding
+    static const size_t sumBlock = 1024;
+
+    //
+    //  extentsScalar
+    //
+    //  the reference the vectorised kernels are checked against
+    //
+    inline Extents extentsScalar (const Positions& positions)
+        { // Bounds :: extentsScalar
+
+        Extents result;
+        if (positions.count == 0)
+            return result;
+
+        float  lo[3], hi[3];
+        double sum[3] = { 0.0, 0.0, 0.0 };
+
+        for (int a = 0; a < 3; ++a)
+            lo[a] = hi[a] = positions[0][a];
+
+        for (size_t v = 0; v < positions.count; ++v)
+            { // for each position
+
+            const float* p = positions[v];
+
+            for (int a = 0; a < 3; ++a)
+                {
+                if (p[a] < lo[a]) { lo[a] = p[a]; result.minIndex[a] = (uint32_t)v; }
+                if (p[a] > hi[a]) { hi[a] = p[a]; result.maxIndex[a] = (uint32_t)v; }
+                sum[a] += p[a];
+                }
+
+            } // for each position
+
+        result.min      = { lo[0], lo[1], lo[2] };
+        result.max      = { hi[0], hi[1], hi[2] };
+        result.centroid = glm::vec3(sum[0], sum[1], sum[2]) / (float)positions.count;
+
+        return result;
+
+        } // Bounds :: extentsScalar
+
+    //
+    //  fold
+    //
+    //  merges extents found over a later stretch of positions,
+    //  keeping the earliest index on ties like the scalar pass
+    //
+    inline void fold (float lo[3], float hi[3], uint32_t loIndex[3], uint32_t hiIndex[3],
+                      const float otherLo[3], const float otherHi[3], const uint32_t otherLoIndex[3], const uint32_t otherHiIndex[3])
+        { // Bounds :: fold
+        for (int a = 0; a < 3; ++a)
+            {
+            if (otherLo[a] < lo[a] || (otherLo[a] == lo[a] && otherLoIndex[a] < loIndex[a])) { lo[a] = otherLo[a]; loIndex[a] = otherLoIndex[a]; }
+            if (otherHi[a] > hi[a] || (otherHi[a] == hi[a] && otherHiIndex[a] < hiIndex[a])) { hi[a] = otherHi[a]; hiIndex[a] = otherHiIndex[a]; }
+            }
+        } // Bounds :: fold
+
+    //
+    //  finish
+    //
+    //  runs the scalar pass over the tail the vector loop left
+    //  and assembles the result
+    //
+    inline Extents finish (const Positions& positions, size_t tail, float lo[3], float hi[3],
+                           uint32_t loIndex[3], uint32_t hiIndex[3], double sum[3])
+        { // Bounds :: finish
+
+        for (size_t v = tail; v < positions.count; ++v)
+            {
+            const float* p = positions[v];
+            for (int a = 0; a < 3; ++a)
+                {
+                if (p[a] < lo[a]) { lo[a] = p[a]; loIndex[a] = (uint32_t)v; }
+                if (p[a] > hi[a]) { hi[a] = p[a]; hiIndex[a] = (uint32_t)v; }
+                sum[a] += p[a];
+                }
+            }
+
+        Extents result;
+        result.min      = { lo[0], lo[1], lo[2] };
+        result.max      = { hi[0], hi[1], hi[2] };
+        result.centroid = glm::vec3(sum[0], sum[1], sum[2]) / (float)positions.count;
+
+        for (int a = 0; a < 3; ++a)
+            {
+            result.minIndex[a] = loIndex[a];
+            result.maxIndex[a] = hiIndex[a];
+            }
+
+        return result;
+
+        } // Bounds :: finish
+
+#if defined(BOUNDS_SSE2)
+
+    //
+    //  extentsSSE
+    //
+    //  one position per register, the fourth lane carrying
+    //  whatever follows it in memory and being ignored. the
+    //  last position is left to the scalar tail so the 16 byte
+    //  load never reads past the array
+    //
+    inline Extents extentsSSE (const Positions& positions)
+        { // Bounds :: extentsSSE
+
+        if (positions.count < 2)
+            return extentsScalar(positions);
+
+        const size_t vectorised = positions.count - 1;
+
+        __m128  lo    = _mm_loadu_ps(positions[0]);
+        __m128  hi    = lo;
+        __m128i loAt  = _mm_setzero_si128();
+        __m128i hiAt  = _mm_setzero_si128();
+        __m128i at    = _mm_setzero_si128();
+        __m128i one   = _mm_set1_epi32(1);
+
+        double sum[3] = { 0.0, 0.0, 0.0 };
+
+        for (size_t block = 0; block < vectorised; block += sumBlock)
+            { // for each block of positions
+
+            const size_t end   = std::min(vectorised, block + sumBlock);
+            __m128       total = _mm_setzero_ps();
+
+            for (size_t v = block; v < end; ++v)
+                {
+                __m128 p = _mm_loadu_ps(positions[v]);
+
+                __m128i below = _mm_castps_si128(_mm_cmplt_ps(p, lo));
+                __m128i above = _mm_castps_si128(_mm_cmpgt_ps(p, hi));
+
+                loAt = _mm_or_si128(_mm_and_si128(below, at), _mm_andnot_si128(below, loAt));
+                hiAt = _mm_or_si128(_mm_and_si128(above, at), _mm_andnot_si128(above, hiAt));
+
+                lo    = _mm_min_ps(lo, p);
+                hi    = _mm_max_ps(hi, p);
+                total = _mm_add_ps(total, p);
+                at    = _mm_add_epi32(at, one);
+                }
+
+            float lanes[4];
+            _mm_storeu_ps(lanes, total);
+            for (int a = 0; a < 3; ++a)
+                sum[a] += lanes[a];
+
+            } // for each block of positions
+
+        float    loLanes[4], hiLanes[4];
+        uint32_t loIndex[4], hiIndex[4];
+        _mm_storeu_ps(loLanes, lo);
+        _mm_storeu_ps(hiLanes, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(loIndex), loAt);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hiIndex), hiAt);
+
+        return finish(positions, vectorised, loLanes, hiLanes, loIndex, hiIndex, sum);
+
+        } // Bounds :: extentsSSE
+
+#endif
+
+#if defined(BOUNDS_AVX2)
+
+    //
+    //  extentsAVX2
+    //
+    //  two positions per register, the even ones in the low
+    //  half and the odd ones in the high half, folded together
+    //  at the end. only to be called where Cpu::avx2 allows
+    //
+    inline CPU_AVX2 Extents extentsAVX2 (const Positions& positions)
+        { // Bounds :: extentsAVX2
+
+        if (positions.count < 2)
+            return extentsScalar(positions);
+
+        // pairs stop short of the last position for the same
+        // reason as extentsSSE
+        const size_t vectorised = (positions.count - 1) & ~(size_t)1;
+
+        __m256  lo    = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(positions[0]));
+        __m256  hi    = lo;
+        __m256i loAt  = _mm256_setzero_si256();
+        __m256i hiAt  = _mm256_setzero_si256();
+        __m256i at    = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+        __m256i two   = _mm256_set1_epi32(2);
+
+        double sum[3] = { 0.0, 0.0, 0.0 };
+
+        for (size_t block = 0; block < vectorised; block += sumBlock)
+            { // for each block of positions
+
+            const size_t end   = std::min(vectorised, block + sumBlock);
+            __m256       total = _mm256_setzero_ps();
+
+            for (size_t v = block; v < end; v += 2)
+                {
+                __m256 p = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(positions[v])), _mm_loadu_ps(positions[v + 1]), 1);
+
+                __m256i below = _mm256_castps_si256(_mm256_cmp_ps(p, lo, _CMP_LT_OQ));
+                __m256i above = _mm256_castps_si256(_mm256_cmp_ps(p, hi, _CMP_GT_OQ));
+
+                loAt = _mm256_blendv_epi8(loAt, at, below);
+                hiAt = _mm256_blendv_epi8(hiAt, at, above);
+
+                lo    = _mm256_min_ps(lo, p);
+                hi    = _mm256_max_ps(hi, p);
+                total = _mm256_add_ps(total, p);
+                at    = _mm256_add_epi32(at, two);
+                }
+
+            float lanes[8];
+            _mm256_storeu_ps(lanes, total);
+            for (int a = 0; a < 3; ++a)
+                sum[a] += (double)lanes[a] + (double)lanes[a + 4];
+
+            } // for each block of positions
+
+        float    loLanes[8], hiLanes[8];
+        uint32_t loIndex[8], hiIndex[8];
+        _mm256_storeu_ps(loLanes, lo);
+        _mm256_storeu_ps(hiLanes, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(loIndex), loAt);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hiIndex), hiAt);
+
+        fold(loLanes, hiLanes, loIndex, hiIndex, loLanes + 4, hiLanes + 4, loIndex + 4, hiIndex + 4);
+
+        return finish(positions, vectorised, loLanes, hiLanes, loIndex, hiIndex, sum);
+
+        } // Bounds :: extentsAVX2
+
+#endif
+
+    //
+    //  extents
+    //
+    //  the widest kernel the processor runs
+    //
+    inline Extents extents (const Positions& positions)
+        { // Bounds :: extents
+#if defined(BOUNDS_AVX2)
+        if (Cpu::avx2())
+            return extentsAVX2(positions);
+#endif
+#if defined(BOUNDS_SSE2)
+        return extentsSSE(positions);
+#else
+        return extentsScalar(positions);
+#endif
+        } // Bounds :: extents
+
+    //
+    //  grow
+    //
+    //  Ritter's step, moving the sphere just far enough towards
+    //  a position outside it to take it in
+    //
+    inline void grow (Sphere& sphere, const glm::vec3& p)
+        { // Bounds :: grow
+        glm::vec3 d        = p - sphere.center;
+        float     distance = glm::length(d);
+        if (distance <= sphere.radius)
+            return;
+        float radius   = (sphere.radius + distance) * 0.5f;
+        sphere.center += d * ((radius - sphere.radius) / distance);
+        sphere.radius  = radius;
+        } // Bounds :: grow
+
+    //
+    //  Spheres
+    //
+    //  the second pass: the Ritter sphere, and the sphere about
+    //  the box centre reaching the furthest position
+    //
+    struct Spheres
+        {
+        Sphere ritter;
+        Sphere box;
+        };
+
+    //
+    //  seed
+    //
+    //  Ritter's starting sphere, spanning whichever pair of
+    //  extreme positions lies furthest apart
+    //
+    inline Sphere seed (const Positions& positions, const Extents& extents)
+        { // Bounds :: seed
+
+        Sphere sphere;
+        float  widest = -1.0f;
+
+        for (int a = 0; a < 3; ++a)
+            {
+            glm::vec3 lo = positions.at(extents.minIndex[a]);
+            glm::vec3 hi = positions.at(extents.maxIndex[a]);
+            float span = glm::length(hi - lo);
+
+            if (span > widest)
+                {
+                widest        = span;
+                sphere.center = (lo + hi) * 0.5f;
+                sphere.radius = span * 0.5f;
+                }
+            }
+
+        return sphere;
+
+        } // Bounds :: seed
+
+    //
+    //  spheresScalar
+    //
+    inline Spheres spheresScalar (const Positions& positions, const Extents& extents)
+        { // Bounds :: spheresScalar
+
+        Spheres result;
+        if (positions.count == 0)
+            return result;
+
+        result.ritter     = seed(positions, extents);
+        result.box.center = (extents.min + extents.max) * 0.5f;
+
+        float furthest = 0.0f;
+
+        for (size_t v = 0; v < positions.count; ++v)
+            {
+            glm::vec3 p = positions.at(v);
+            glm::vec3 d = p - result.box.center;
+            furthest = std::max(furthest, glm::dot(d, d));
+            grow(result.ritter, p);
+            }
+
+        result.box.radius = std::sqrt(furthest);
+
+        return result;
+
+        } // Bounds :: spheresScalar
+
+#if defined(BOUNDS_SSE2)
+
+    //
+    //  spheresSSE
+    //
+    //  tests four positions at once against the current Ritter
+    //  sphere, dropping to the scalar step only for groups with
+    //  a position outside it, which is rare once the seed spans
+    //  the mesh
+    //
+    inline Spheres spheresSSE (const Positions& positions, const Extents& extents)
+        { // Bounds :: spheresSSE
+
+        Spheres result;
+        if (positions.count == 0)
+            return result;
+
+        result.ritter     = seed(positions, extents);
+        result.box.center = (extents.min + extents.max) * 0.5f;
+
+        // groups stop short of the last position so the 16 byte
+        // loads stay inside the array
+        const size_t vectorised = (positions.count - 1) & ~(size_t)3;
+
+        const __m128 boxX = _mm_set1_ps(result.box.center.x);
+        const __m128 boxY = _mm_set1_ps(result.box.center.y);
+        const __m128 boxZ = _mm_set1_ps(result.box.center.z);
+
+        __m128 furthest = _mm_setzero_ps();
+        __m128 ritterX  = _mm_set1_ps(result.ritter.center.x);
+        __m128 ritterY  = _mm_set1_ps(result.ritter.center.y);
+        __m128 ritterZ  = _mm_set1_ps(result.ritter.center.z);
+        __m128 ritterR2 = _mm_set1_ps(result.ritter.radius * result.ritter.radius);
+
+        for (size_t v = 0; v < vectorised; v += 4)
+            { // for each group of four
+
+            __m128 x = _mm_loadu_ps(positions[v]);
+            __m128 y = _mm_loadu_ps(positions[v + 1]);
+            __m128 z = _mm_loadu_ps(positions[v + 2]);
+            __m128 w = _mm_loadu_ps(positions[v + 3]);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+
+            __m128 dx = _mm_sub_ps(x, boxX);
+            __m128 dy = _mm_sub_ps(y, boxY);
+            __m128 dz = _mm_sub_ps(z, boxZ);
+            furthest = _mm_max_ps(furthest, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+            dx = _mm_sub_ps(x, ritterX);
+            dy = _mm_sub_ps(y, ritterY);
+            dz = _mm_sub_ps(z, ritterZ);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            if (_mm_movemask_ps(_mm_cmpgt_ps(d2, ritterR2)) == 0)
+                continue;
+
+            for (size_t k = 0; k < 4; ++k)
+                grow(result.ritter, positions.at(v + k));
+
+            ritterX  = _mm_set1_ps(result.ritter.center.x);
+            ritterY  = _mm_set1_ps(result.ritter.center.y);
+            ritterZ  = _mm_set1_ps(result.ritter.center.z);
+            ritterR2 = _mm_set1_ps(result.ritter.radius * result.ritter.radius);
+
+            } // for each group of four
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, furthest);
+        float box2 = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+        for (size_t v = vectorised; v < positions.count; ++v)
+            {
+            glm::vec3 p = positions.at(v);
+            glm::vec3 d = p - result.box.center;
+            box2 = std::max(box2, glm::dot(d, d));
+            grow(result.ritter, p);
+            }
+
+        result.box.radius = std::sqrt(box2);
+
+        return result;
+
+        } // Bounds :: spheresSSE
+
+#endif
+
+    //
+    //  spheres
+    //
+    inline Spheres spheres (const Positions& positions, const Extents& extents)
+        { // Bounds :: spheres
+#if defined(BOUNDS_SSE2)
+        return spheresSSE(positions, extents);
+#else
+        return spheresScalar(positions, extents);
+#endif
+        } // Bounds :: spheres
+
+    //
+    //  tightest
+    //
+    //  whichever of the two pass sphere is smaller. Ritter's is
+    //  usually the tighter, but not for every shape
+    //
+    inline Sphere tightest (const Spheres& spheres)
+        { // Bounds :: tightest
+        return spheres.ritter.radius <= spheres.box.radius ? spheres.ritter : spheres.box;
+        } // Bounds :: tightest
+
+    //
+    //  circumscribe
+    //
+    //  the smallest spheres with two, three or four points on
+    //  their surface. degenerate triangles and tetrahedra fall
+    //  back to the smallest sphere over fewer of the points that
+    //  still holds them all
+    //
+    struct Ball
+        {
+        glm::dvec3 center = { 0.0, 0.0, 0.0 };
+        double     radius2 = 0.0;
+
+        bool contains (const glm::dvec3& p) const
+            {
+            glm::dvec3 d = p - center;
+            return glm::dot(d, d) <= radius2 * (1.0 + 1e-9) + 1e-18;
+            }
+        };
+
+    inline Ball circumscribe (const glm::dvec3& a, const glm::dvec3& b)
+        { // Bounds :: circumscribe
+        Ball ball;
+        ball.center  = (a + b) * 0.5;
+        ball.radius2 = glm::dot(b - ball.center, b - ball.center);
+        return ball;
+        } // Bounds :: circumscribe
+
+    inline Ball circumscribe (const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c)
+        { // Bounds :: circumscribe
+
+        glm::dvec3 ab = b - a;
+        glm::dvec3 ac = c - a;
+        glm::dvec3 n  = glm::cross(ab, ac);
+        double     nn = glm::dot(n, n);
+
+        if (nn <= 1e-24 * glm::dot(ab, ab) * glm::dot(ac, ac))
+            {
+            Ball candidates[3] = { circumscribe(a, b), circumscribe(a, c), circumscribe(b, c) };
+            Ball widest = candidates[0];
+            for (const Ball& candidate : candidates)
+                if (candidate.radius2 > widest.radius2)
+                    widest = candidate;
+            return widest;
+            }
+
+        glm::dvec3 offset = (glm::cross(n, ab) * glm::dot(ac, ac) + glm::cross(ac, n) * glm::dot(ab, ab)) / (2.0 * nn);
+
+        Ball ball;
+        ball.center  = a + offset;
+        ball.radius2 = glm::dot(offset, offset);
+        return ball;
+
+        } // Bounds :: circumscribe
+
+    inline Ball circumscribe (const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, const glm::dvec3& d)
+        { // Bounds :: circumscribe
+
+        glm::dvec3 ab = b - a;
+        glm::dvec3 ac = c - a;
+        glm::dvec3 ad = d - a;
+
+        // rows of the system 2 (p - a) . x = |p - a|^2, solved by
+        // Cramer's rule through the triple products
+        double determinant = glm::dot(ab, glm::cross(ac, ad));
+        double scale       = glm::length(ab) * glm::length(ac) * glm::length(ad);
+
+        if (std::abs(determinant) <= 1e-12 * scale)
+            {
+            Ball candidates[4] = { circumscribe(a, b, c), circumscribe(a, b, d), circumscribe(a, c, d), circumscribe(b, c, d) };
+            const glm::dvec3* points[4] = { &a, &b, &c, &d };
+
+            Ball best;
+            bool found = false;
+            for (const Ball& candidate : candidates)
+                {
+                bool holds = true;
+                for (const glm::dvec3* p : points)
+                    holds = holds && candidate.contains(*p);
+                if (holds && (!found || candidate.radius2 < best.radius2))
+                    {
+                    best  = candidate;
+                    found = true;
+                    }
+                }
+            return found ? best : candidates[0];
+            }
+
+        glm::dvec3 offset = (glm::cross(ac, ad) * glm::dot(ab, ab) +
+                             glm::cross(ad, ab) * glm::dot(ac, ac) +
+                             glm::cross(ab, ac) * glm::dot(ad, ad)) / (2.0 * determinant);
+
+        Ball ball;
+        ball.center  = a + offset;
+        ball.radius2 = glm::dot(offset, offset);
+        return ball;
+
+        } // Bounds :: circumscribe
+
+    //
+    //  welzl
+    //
+    //  the exact minimum bounding sphere. Welzl's recursion is
+    //  unrolled into its four levels of boundary points over a
+    //  shuffled copy of the positions, which keeps the expected
+    //  cost linear. a fixed seed keeps results reproducible
+    //
+    inline Sphere welzl (const Positions& positions)
+        { // Bounds :: welzl
+
+        Sphere result;
+        if (positions.count == 0)
+            return result;
+
+        std::vector<glm::dvec3> points (positions.count);
+        for (size_t v = 0; v < positions.count; ++v)
+            points[v] = glm::dvec3(positions.at(v));
+
+        std::mt19937 rng (0x5eed);
+        std::shuffle(points.begin(), points.end(), rng);
+
+        Ball ball;
+        ball.center = points[0];
+
+        for (size_t i = 1; i < points.size(); ++i)
+            {
+            if (ball.contains(points[i]))
+                continue;
+
+            ball.center  = points[i];
+            ball.radius2 = 0.0;
+
+            for (size_t j = 0; j < i; ++j)
+                {
+                if (ball.contains(points[j]))
+                    continue;
+
+                ball = circumscribe(points[i], points[j]);
+
+                for (size_t k = 0; k < j; ++k)
+                    {
+                    if (ball.contains(points[k]))
+                        continue;
+
+                    ball = circumscribe(points[i], points[j], points[k]);
+
+                    for (size_t l = 0; l < k; ++l)
+                        if (!ball.contains(points[l]))
+                            ball = circumscribe(points[i], points[j], points[k], points[l]);
+                    }
+                }
+            }
+
+        result.center = glm::vec3(ball.center);
+        result.radius = (float)std::sqrt(ball.radius2);
+
+        // float rounding of the centre can leave a surface point a
+        // hair outside, so the radius is widened to cover it
+        for (const glm::dvec3& p : points)
+            result.radius = std::max(result.radius, (float)glm::length(p - glm::dvec3(result.center)));
+
+        return result;
+
+        } // Bounds :: welzl
+
+    }
+
+#endif /* Bounds_hpp */
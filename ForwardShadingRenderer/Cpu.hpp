@@ -0,0 +1,83 @@
+//
+//  Cpu.hpp
+//  ForwardRenderer
+//
+//  what the processor we are running on supports, asked once
+//  at run time. the AVX2 kernels are compiled into every x86
+//  build and only called where it says so, since neither the
+//  MSVC nor the GCC builds target more than SSE2
+//
+
+#ifndef Cpu_hpp
+#define Cpu_hpp
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define CPU_X86 1
+#endif
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+//
+//  CPU_AVX2
+//
+//  compiles a function for AVX2 whatever the build targets.
+//  MSVC emits AVX2 intrinsics anywhere, GCC and Clang only in
+//  functions marked for it
+//
+#if defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define CPU_AVX2 __attribute__((target("avx2")))
+#else
+    #define CPU_AVX2
+#endif
+
+namespace Cpu
+    {
+
+    //
+    //  detectAVX2
+    //
+    //  whether the processor has AVX2 and the operating system
+    //  saves the ymm registers it needs across context switches
+    //
+    inline bool detectAVX2 ()
+        { // Cpu :: detectAVX2
+#if defined(CPU_X86) && defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx     = (info[2] & (1 << 28)) != 0;
+
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#else
+        return false;
+#endif
+        } // Cpu :: detectAVX2
+
+    //
+    //  avx2
+    //
+    //  detectAVX2, asked the first time and remembered
+    //
+    inline bool avx2 ()
+        { // Cpu :: avx2
+        static const bool supported = detectAVX2();
+        return supported;
+        } // Cpu :: avx2
+
+    }
+
+#endif /* Cpu_hpp */
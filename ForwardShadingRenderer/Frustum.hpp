@@ -0,0 +1,278 @@
+//
+//  Frustum.hpp
+//  ForwardRenderer
+//
+//  view frustum culling of bounding spheres on the cpu. the
+//  spheres are held a coordinate to an array, so the test runs
+//  eight at a time with AVX2 where the processor has it or four
+//  with SSE2, and the survivors are compacted into a list of their
+//  indices. the scalar pass is the reference the others match
+//
+
+#ifndef Frustum_hpp
+#define Frustum_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Cpu.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FRUSTUM_SSE2 1
+#endif
+
+// built alongside the SSE2 kernel and picked at run time
+#if defined(FRUSTUM_SSE2) && defined(CPU_X86)
+    #define FRUSTUM_AVX2 1
+#endif
+
+#if defined(FRUSTUM_AVX2)
+    #include <immintrin.h>
+#elif defined(FRUSTUM_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace Frustum
+    {
+
+    //
+    //  Planes
+    //
+    //  left, right, bottom, top, near and far, pointing inwards
+    //  and normalized, so a point's distance from each is in
+    //  world units
+    //
+    struct Planes
+        {
+        glm::vec4 planes[6];
+        };
+
+    //
+    //  planes
+    //
+    //  the planes of the volume a clip matrix, proj * view, maps
+    //  into view. the near plane is the -w one of a GL style
+    //  projection, which only keeps more than the device would
+    //
+    inline Planes planes (const glm::mat4& clip)
+        { // Frustum :: planes
+
+        Planes result;
+
+        for (uint32_t p = 0; p < 6; ++p)
+            {
+            const uint32_t axis = p / 2;
+            const float    sign = (p % 2) ? -1.0f : 1.0f;
+
+            glm::vec4 plane;
+            for (uint32_t c = 0; c < 4; ++c)
+                plane[c] = clip[c][3] + sign * clip[c][axis];
+
+            result.planes[p] = plane / glm::length(glm::vec3(plane));
+            }
+
+        return result;
+
+        } // Frustum :: planes
+
+    //
+    //  Spheres
+    //
+    //  centres and radii in separate arrays, one sphere to an
+    //  index in each
+    //
+    struct Spheres
+        {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+
+        size_t size   () const    { return radius.size(); }
+        void   resize (size_t n)  { x.resize(n); y.resize(n); z.resize(n); radius.resize(n); }
+        };
+
+    //
+    //  touches
+    //
+    //  whether sphere i reaches inside every plane. the sums run
+    //  in the order the vector kernels use, so all of them agree
+    //  to the bit
+    //
+    inline bool touches (const Spheres& spheres, const Planes& frustum, size_t i)
+        { // Frustum :: touches
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.planes)
+            {
+            float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w + spheres.radius[i];
+            inside = inside && distance >= 0.0f;
+            }
+        return inside;
+        } // Frustum :: touches
+
+    //
+    //  cullScalar
+    //
+    //  writes the index of every sphere touching the volume to
+    //  visible, which must have room for them all, and returns
+    //  how many there were. the reference for the vector kernels
+    //
+    inline size_t cullScalar (const Spheres& spheres, const Planes& frustum, uint32_t* visible)
+        { // Frustum :: cullScalar
+
+        size_t count = 0;
+
+        for (size_t i = 0; i < spheres.size(); ++i)
+            if (touches(spheres, frustum, i))
+                visible[count++] = (uint32_t)i;
+
+        return count;
+
+        } // Frustum :: cullScalar
+
+    //
+    //  compact
+    //
+    //  appends the lanes set in mask, writing every lane and
+    //  advancing over the ones culled. count never passes the
+    //  first lane, so the writes stay inside the list
+    //
+    inline size_t compact (uint32_t* visible, size_t count, uint32_t first, int mask, int lanes)
+        { // Frustum :: compact
+        for (int lane = 0; lane < lanes; ++lane)
+            {
+            visible[count] = first + (uint32_t)lane;
+            count += (mask >> lane) & 1;
+            }
+        return count;
+        } // Frustum :: compact
+
+    //
+    //  finish
+    //
+    //  runs the scalar test over the spheres the vector loop left
+    //
+    inline size_t finish (const Spheres& spheres, const Planes& frustum, size_t tail, uint32_t* visible, size_t count)
+        { // Frustum :: finish
+        for (size_t i = tail; i < spheres.size(); ++i)
+            if (touches(spheres, frustum, i))
+                visible[count++] = (uint32_t)i;
+        return count;
+        } // Frustum :: finish
+
+#if defined(FRUSTUM_SSE2)
+
+    //
+    //  cullSSE
+    //
+    //  four spheres per register, against each plane in turn
+    //
+    inline size_t cullSSE (const Spheres& spheres, const Planes& frustum, uint32_t* visible)
+        { // Frustum :: cullSSE
+
+        const size_t vectorised = spheres.size() & ~(size_t)3;
+        size_t       count      = 0;
+
+        for (size_t i = 0; i < vectorised; i += 4)
+            { // for each four spheres
+
+            __m128 x = _mm_loadu_ps(&spheres.x[i]);
+            __m128 y = _mm_loadu_ps(&spheres.y[i]);
+            __m128 z = _mm_loadu_ps(&spheres.z[i]);
+            __m128 r = _mm_loadu_ps(&spheres.radius[i]);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for (const glm::vec4& plane : frustum.planes)
+                {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(plane.x), x),
+                    _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+                    _mm_mul_ps(_mm_set1_ps(plane.z), z)),
+                    _mm_set1_ps(plane.w)),
+                    r);
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+                }
+
+            count = compact(visible, count, (uint32_t)i, _mm_movemask_ps(inside), 4);
+
+            } // for each four spheres
+
+        return finish(spheres, frustum, vectorised, visible, count);
+
+        } // Frustum :: cullSSE
+
+#endif
+
+#if defined(FRUSTUM_AVX2)
+
+    //
+    //  cullAVX2
+    //
+    //  eight spheres per register. the multiplies and adds are
+    //  kept apart rather than fused, to round as the others do.
+    //  only to be called where Cpu::avx2 allows
+    //
+    inline CPU_AVX2 size_t cullAVX2 (const Spheres& spheres, const Planes& frustum, uint32_t* visible)
+        { // Frustum :: cullAVX2
+
+        const size_t vectorised = spheres.size() & ~(size_t)7;
+        size_t       count      = 0;
+
+        for (size_t i = 0; i < vectorised; i += 8)
+            { // for each eight spheres
+
+            __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+            __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+            __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+            __m256 r = _mm256_loadu_ps(&spheres.radius[i]);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (const glm::vec4& plane : frustum.planes)
+                {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(plane.x), x),
+                    _mm256_mul_ps(_mm256_set1_ps(plane.y), y)),
+                    _mm256_mul_ps(_mm256_set1_ps(plane.z), z)),
+                    _mm256_set1_ps(plane.w)),
+                    r);
+
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+                }
+
+            count = compact(visible, count, (uint32_t)i, _mm256_movemask_ps(inside), 8);
+
+            } // for each eight spheres
+
+        return finish(spheres, frustum, vectorised, visible, count);
+
+        } // Frustum :: cullAVX2
+
+#endif
+
+    //
+    //  cull
+    //
+    //  the widest kernel the processor runs
+    //
+    inline size_t cull (const Spheres& spheres, const Planes& frustum, uint32_t* visible)
+        { // Frustum :: cull
+#if defined(FRUSTUM_AVX2)
+        if (Cpu::avx2())
+            return cullAVX2(spheres, frustum, visible);
+#endif
+#if defined(FRUSTUM_SSE2)
+        return cullSSE(spheres, frustum, visible);
+#else
+        return cullScalar(spheres, frustum, visible);
+#endif
+        } // Frustum :: cull
+
+    }
+
+#endif /* Frustum_hpp */
@@ -0,0 +1,255 @@
+//
+//  MappedFile.hpp
+//  ForwardRenderer
+//
+//  read-only memory mapping of files on disk so that
+//  loaders can read straight out of the page cache
+//
+
+#ifndef MappedFile_hpp
+#define MappedFile_hpp
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+struct MappedFile
+    { // MappedFile struct
+
+    //
+    //  hints describing how the mapping is about to be
+    //  read, forwarded to the kernel as madvise/prefetch
+    //
+    enum class Access
+        {
+        Normal,
+        Sequential,
+        Random,
+        WillNeed
+        };
+
+    MappedFile  () = default;
+    ~MappedFile () { close(); }
+
+    MappedFile  (const MappedFile&)            = delete;
+    MappedFile& operator= (const MappedFile&)  = delete;
+
+    MappedFile  (MappedFile&& other)            { *this = static_cast<MappedFile&&>(other); }
+    MappedFile& operator= (MappedFile&& other)
+        { // MappedFile :: operator=
+        if (this == &other) return *this;
+        close();
+        data = other.data; other.data = nullptr;
+        size = other.size; other.size = 0;
+    #ifdef _WIN32
+        file    = other.file;    other.file    = INVALID_HANDLE_VALUE;
+        mapping = other.mapping; other.mapping = nullptr;
+    #else
+        fd = other.fd; other.fd = -1;
+    #endif
+        return *this;
+        } // MappedFile :: operator=
+
+    //
+    //  open
+    //
+    //  maps the whole file at the given path read-only,
+    //  returning false if the file is missing or empty
+    //
+    inline bool open (const char* path, Access access = Access::Sequential);
+
+    //
+    //  advise
+    //
+    //  hints the kernel about how a byte range of the
+    //  mapping is going to be touched. ranges are rounded
+    //  out to page boundaries
+    //
+    inline void advise (size_t offset, size_t length, Access access) const;
+
+    //
+    //  close
+    //
+    //  unmaps the file, invalidating any pointers into it
+    //
+    inline void close ();
+
+    //
+    //  evict
+    //
+    //  asks the OS to drop any cached pages of the file at
+    //  the given path so the next read comes from disk. only
+    //  used for cold-cache measurements
+    //
+    inline static bool evict (const char* path);
+
+    bool isOpen () const { return data != nullptr; }
+
+    const uint8_t* data = nullptr;
+    size_t         size = 0;
+
+private:
+#ifdef _WIN32
+    HANDLE file    = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int    fd      = -1;
+#endif
+
+    }; // MappedFile struct
+
+bool MappedFile::open (const char* path, Access access)
+    { // MappedFile :: open
+
+    close();
+
+#ifdef _WIN32
+    DWORD flags = access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    // sharing delete lets another process replace or evict a
+    // cached file while we still have it mapped
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length) || length.QuadPart == 0)
+        { close(); return false; }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+        { close(); return false; }
+
+    data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    size = static_cast<size_t>(length.QuadPart);
+#else
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+        { close(); return false; }
+
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED)
+        { close(); return false; }
+
+    data = static_cast<const uint8_t*>(address);
+    size = static_cast<size_t>(info.st_size);
+#endif
+
+    if (data == nullptr)
+        { close(); return false; }
+
+    advise(0, size, access);
+    return true;
+
+    } // MappedFile :: open
+
+void MappedFile::advise (size_t offset, size_t length, Access access) const
+    { // MappedFile :: advise
+
+    if (data == nullptr || offset >= size)
+        return;
+    if (length > size - offset)
+        length = size - offset;
+
+#ifdef _WIN32
+    // windows has no per-range access pattern hint for views,
+    // the closest we have is asking for the range to be
+    // prefetched (windows 8 and up)
+    #if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if (access == Access::Sequential || access == Access::WillNeed)
+        {
+        WIN32_MEMORY_RANGE_ENTRY range;
+            range.VirtualAddress = const_cast<uint8_t*>(data + offset);
+            range.NumberOfBytes  = length;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+    #else
+    (void)access;
+    #endif
+#else
+    const size_t page  = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = offset & ~(page - 1);
+    const size_t end   = offset + length;
+
+    int advice = MADV_NORMAL;
+    if (access == Access::Sequential) advice = MADV_SEQUENTIAL;
+    if (access == Access::Random)     advice = MADV_RANDOM;
+    if (access == Access::WillNeed)   advice = MADV_WILLNEED;
+
+    madvise(const_cast<uint8_t*>(data + begin), end - begin, advice);
+
+    // sequential loads are about to read everything, so we
+    // start the readahead now rather than on first fault
+    if (access == Access::Sequential)
+        {
+        madvise(const_cast<uint8_t*>(data + begin), end - begin, MADV_WILLNEED);
+        #ifdef __linux__
+        readahead(fd, static_cast<off_t>(begin), end - begin);
+        #endif
+        }
+#endif
+
+    } // MappedFile :: advise
+
+void MappedFile::close ()
+    { // MappedFile :: close
+
+#ifdef _WIN32
+    if (data    != nullptr)              UnmapViewOfFile(data);
+    if (mapping != nullptr)              CloseHandle(mapping);
+    if (file    != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = nullptr;
+    file    = INVALID_HANDLE_VALUE;
+#else
+    if (data != nullptr) munmap(const_cast<uint8_t*>(data), size);
+    if (fd   >= 0)       ::close(fd);
+    fd = -1;
+#endif
+
+    data = nullptr;
+    size = 0;
+
+    } // MappedFile :: close
+
+bool MappedFile::evict (const char* path)
+    { // MappedFile :: evict
+
+#ifdef _WIN32
+    // opening a file unbuffered makes the cache manager
+    // flush and purge whatever it holds for that file
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    CloseHandle(handle);
+    return true;
+#else
+    int handle = ::open(path, O_RDONLY);
+    if (handle < 0)
+        return false;
+    fdatasync(handle);
+    #ifdef POSIX_FADV_DONTNEED
+    bool result = posix_fadvise(handle, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    #else
+    bool result = false;
+    #endif
+    ::close(handle);
+    return result;
+#endif
+
+    } // MappedFile :: evict
+
+#endif /* MappedFile_hpp */
@@ -0,0 +1,318 @@
+//
+//  MeshCache.hpp
+//  ForwardRenderer
+//
+//  a directory of processed .mesh files named by what they were
+//  built from, shared by every renderer process on the machine.
+//  entries are written under a private name and renamed into
+//  place, so readers only ever see whole files, and the least
+//  recently used are deleted once the directory outgrows its
+//  budget
+//
+
+#ifndef MeshCache_hpp
+#define MeshCache_hpp
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+#endif
+
+struct MeshCache
+    { // MeshCache struct
+
+    //
+    //  directory is created on first use. capacity is the
+    //  number of bytes the entries may take up between them
+    //
+    explicit MeshCache (std::string directory, uint64_t capacity = 256ull * 1024 * 1024) :
+        directory (std::move(directory)),
+        capacity  (capacity)
+        { }
+
+    //
+    //  entry
+    //
+    //  the path an entry for source bytes with the given hash,
+    //  processed with the given settings, lives at
+    //
+    inline std::string entry (uint64_t source, uint64_t settings) const;
+
+    //
+    //  touch
+    //
+    //  marks an entry as just used, which is what eviction
+    //  orders by
+    //
+    inline void touch (const std::string& path) const;
+
+    //
+    //  temporary
+    //
+    //  a name in the cache directory no other thread or
+    //  process will write to, for building an entry under
+    //
+    inline std::string temporary () const;
+
+    //
+    //  publish
+    //
+    //  atomically renames a finished temporary file to its
+    //  entry, replacing any copy a racing process put there.
+    //  the temporary is removed if that fails
+    //
+    inline bool publish (const std::string& temporary, const std::string& path) const;
+
+    //
+    //  remove
+    //
+    //  deletes an entry, typically one found to be corrupt
+    //
+    inline void remove (const std::string& path) const;
+
+    //
+    //  trim
+    //
+    //  deletes entries, least recently used first, until the
+    //  rest fit in capacity, keeping the one named in keep.
+    //  temporaries abandoned by a crashed writer are swept up
+    //  once they are an hour old. entries another process is
+    //  still mapping may refuse to go on windows, and are
+    //  simply skipped
+    //
+    inline void trim (const std::string& keep = std::string()) const;
+
+    const std::string directory;
+    const uint64_t    capacity;
+
+private:
+
+    struct File
+        {
+        std::string name;
+        uint64_t    size;
+        int64_t     modified; // nanoseconds since the epoch
+        };
+
+    inline bool              create () const;
+    inline std::vector<File> list   () const;
+
+    }; // MeshCache struct
+
+std::string MeshCache::entry (uint64_t source, uint64_t settings) const
+    { // MeshCache :: entry
+
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%016llx.mesh", (unsigned long long)source, (unsigned long long)settings);
+
+    return directory + "/" + name;
+
+    } // MeshCache :: entry
+
+void MeshCache::touch (const std::string& path) const
+    { // MeshCache :: touch
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(handle, nullptr, &now, &now);
+    CloseHandle(handle);
+#else
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+#endif
+
+    } // MeshCache :: touch
+
+std::string MeshCache::temporary () const
+    { // MeshCache :: temporary
+
+    static std::atomic<uint32_t> counter (0);
+
+#ifdef _WIN32
+    const unsigned long process = GetCurrentProcessId();
+#else
+    const unsigned long process = (unsigned long)getpid();
+#endif
+
+    char name[96];
+    snprintf(name, sizeof(name), "%lu-%zx-%u.tmp",
+             process,
+             std::hash<std::thread::id>()(std::this_thread::get_id()),
+             counter++);
+
+    create();
+    return directory + "/" + name;
+
+    } // MeshCache :: temporary
+
+bool MeshCache::publish (const std::string& temporary, const std::string& path) const
+    { // MeshCache :: publish
+
+#ifdef _WIN32
+    bool published = MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool published = rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+
+    if (!published)
+        std::remove(temporary.c_str());
+
+    return published;
+
+    } // MeshCache :: publish
+
+void MeshCache::remove (const std::string& path) const
+    { // MeshCache :: remove
+    std::remove(path.c_str());
+    } // MeshCache :: remove
+
+void MeshCache::trim (const std::string& keep) const
+    { // MeshCache :: trim
+
+    std::vector<File> files = list();
+
+    const int64_t now   = (int64_t)time(nullptr) * 1000000000ll;
+    uint64_t      total = 0;
+
+    std::vector<File> entries;
+    for (File& file : files)
+        {
+        const bool temporary = file.name.size() > 4 && file.name.compare(file.name.size() - 4, 4, ".tmp") == 0;
+
+        if (temporary && now - file.modified > 60 * 60 * 1000000000ll)
+            remove(directory + "/" + file.name);
+        else if (!temporary)
+            {
+            total += file.size;
+            entries.push_back(file);
+            }
+        }
+
+    if (total <= capacity)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [] (const File& a, const File& b) { return a.modified < b.modified; });
+
+    for (const File& file : entries)
+        { // for each entry, oldest first
+
+        if (total <= capacity)
+            break;
+
+        const std::string path = directory + "/" + file.name;
+        if (path == keep)
+            continue;
+
+        if (std::remove(path.c_str()) == 0)
+            total -= file.size;
+
+        } // for each entry, oldest first
+
+    } // MeshCache :: trim
+
+bool MeshCache::create () const
+    { // MeshCache :: create
+
+    // each missing component of the path is made in turn,
+    // tolerating ones another process made first
+    for (size_t slash = 1; slash != std::string::npos; )
+        {
+        slash = directory.find_first_of("/\\", slash);
+        std::string partial = directory.substr(0, slash);
+
+    #ifdef _WIN32
+        CreateDirectoryA(partial.c_str(), nullptr);
+    #else
+        mkdir(partial.c_str(), 0755);
+    #endif
+
+        if (slash != std::string::npos)
+            ++slash;
+        }
+
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(directory.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat info;
+    return stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+
+    } // MeshCache :: create
+
+std::vector<MeshCache::File> MeshCache::list () const
+    { // MeshCache :: list
+
+    std::vector<File> files;
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "/*").c_str(), &found);
+    if (search == INVALID_HANDLE_VALUE)
+        return files;
+
+    do  {
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        // file times count 100ns ticks from 1601 rather than 1970
+        const uint64_t ticks = (uint64_t)found.ftLastWriteTime.dwHighDateTime << 32 | found.ftLastWriteTime.dwLowDateTime;
+
+        files.push_back({ found.cFileName,
+                          (uint64_t)found.nFileSizeHigh << 32 | found.nFileSizeLow,
+                          ((int64_t)ticks - 116444736000000000ll) * 100 });
+        } while (FindNextFileA(search, &found));
+
+    FindClose(search);
+#else
+    DIR* folder = opendir(directory.c_str());
+    if (folder == nullptr)
+        return files;
+
+    while (dirent* item = readdir(folder))
+        {
+        struct stat info;
+        std::string path = directory + "/" + item->d_name;
+
+        if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+            continue;
+
+    #ifdef __APPLE__
+        const timespec& modified = info.st_mtimespec;
+    #else
+        const timespec& modified = info.st_mtim;
+    #endif
+
+        files.push_back({ item->d_name, (uint64_t)info.st_size, (int64_t)modified.tv_sec * 1000000000ll + modified.tv_nsec });
+        }
+
+    closedir(folder);
+#endif
+
+    return files;
+
+    } // MeshCache :: list
+
+#endif /* MeshCache_hpp */
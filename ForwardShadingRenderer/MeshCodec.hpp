@@ -0,0 +1,681 @@
+//
+//  MeshCodec.hpp
+//  ForwardRenderer
+//
+//  block compression for the large .mesh sections. each block
+//  is conditioned first, integers replaced by the zigzagged
+//  difference to their predecessor and the bytes of every
+//  element split into planes so that slowly changing bytes sit
+//  together, then packed with a small LZ77 coder in the style
+//  of LZ4. blocks are independent, so they decode in parallel
+//  from memory or one at a time from a stream into the
+//  destination, keeping the working set to a couple of blocks
+//
+
+#ifndef MeshCodec_hpp
+#define MeshCodec_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MESHCODEC_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#include "Parallel.hpp"
+
+namespace MeshCodec
+    {
+
+    enum Filter : uint16_t
+        {
+        eShuffle = 0, // byte planes only
+        eDelta   = 1  // 16 or 32 bit integers delta and zigzag coded, then byte planes
+        };
+
+    const uint32_t blockBytes = 64 * 1024;   // decoded bytes per block, rounded down to whole elements
+    const uint32_t maxBlock   = 1024 * 1024; // largest block a decoder accepts
+    const uint32_t stored     = 0x80000000u; // block header bit, payload was not compressible
+    const uint32_t maxRatio   = 255;         // most decoded bytes an encoded byte can stand for, a match length byte
+
+    //
+    //  an encoded stream is this header followed by the blocks,
+    //  each a uint32 payload size (or'd with stored) and then
+    //  the payload itself
+    //
+    struct StreamHeader
+        {
+        uint64_t size;   // decoded bytes
+        uint32_t block;  // decoded bytes per block, a multiple of stride
+        uint16_t stride;
+        uint16_t filter;
+        };
+
+    static_assert(sizeof(StreamHeader) == 16, "codec stream header must stay 16 bytes");
+
+    inline uint32_t read32 (const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+    inline uint64_t read64 (const uint8_t* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+    inline uint32_t trailingZeros (uint64_t v)
+        { // MeshCodec :: trailingZeros
+    #if defined(_MSC_VER)
+        unsigned long index; _BitScanForward64(&index, v); return (uint32_t)index;
+    #else
+        return (uint32_t)__builtin_ctzll(v);
+    #endif
+        } // MeshCodec :: trailingZeros
+
+    //
+    //  matchLength
+    //
+    //  how many bytes from a and b agree, stopping at limit,
+    //  compared a word at a time
+    //
+    inline size_t matchLength (const uint8_t* a, const uint8_t* b, const uint8_t* limit)
+        { // MeshCodec :: matchLength
+
+        const uint8_t* start = a;
+
+        while (a + sizeof(uint64_t) <= limit)
+            {
+            uint64_t diff = read64(a) ^ read64(b);
+            if (diff)
+                return (size_t)(a - start) + trailingZeros(diff) / 8;
+            a += sizeof(uint64_t);
+            b += sizeof(uint64_t);
+            }
+
+        while (a < limit && *a == *b)
+            { ++a; ++b; }
+
+        return (size_t)(a - start);
+
+        } // MeshCodec :: matchLength
+
+    //
+    //  compress
+    //
+    //  LZ77 over at most 64KB, as a run of sequences of a token
+    //  (literal count and match length, four bits each), any
+    //  extra length bytes, the literals, a 16 bit offset and
+    //  extra match length bytes. the last sequence is literals
+    //  only. returns the compressed size, or 0 if it would not
+    //  fit in capacity
+    //
+    inline size_t compress (const uint8_t* src, size_t size, uint8_t* dst, size_t capacity)
+        { // MeshCodec :: compress
+
+        const uint32_t hashBits = 13;
+        const size_t   minMatch = 4;
+
+        uint32_t table[1 << hashBits];
+        memset(table, 0, sizeof(table));
+
+        uint8_t*       op   = dst;
+        uint8_t* const oend = dst + capacity;
+
+        // matches stay clear of the last bytes so the final
+        // sequence always carries a few literals
+        const size_t matchLimit = size > 12 ? size - 12 : 0;
+        const uint8_t* const limit = src + (size > 5 ? size - 5 : 0);
+
+        size_t anchor = 0;
+        size_t ip     = 1;
+
+        auto length = [&] (size_t value)
+            {
+            for (; value >= 255; value -= 255)
+                *op++ = 255;
+            *op++ = (uint8_t)value;
+            };
+
+        while (ip < matchLimit)
+            { // for each position
+
+            const uint32_t sequence  = read32(src + ip);
+            const uint32_t hash      = (sequence * 2654435761u) >> (32 - hashBits);
+            size_t         candidate = table[hash];
+            table[hash] = (uint32_t)ip;
+
+            if (candidate >= ip || ip - candidate > 0xFFFF || read32(src + candidate) != sequence)
+                {
+                // step further through data that is not matching
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+                }
+
+            while (ip > anchor && candidate > 0 && src[ip - 1] == src[candidate - 1])
+                { --ip; --candidate; }
+
+            const size_t match    = minMatch + matchLength(src + ip + minMatch, src + candidate + minMatch, limit);
+            const size_t literals = ip - anchor;
+
+            if ((size_t)(oend - op) < 1 + literals + literals / 255 + 1 + 2 + match / 255 + 1)
+                return 0;
+
+            uint8_t* token = op++;
+            *token = (uint8_t)(std::min<size_t>(literals, 15) << 4 | std::min<size_t>(match - minMatch, 15));
+
+            if (literals >= 15)
+                length(literals - 15);
+
+            memcpy(op, src + anchor, literals);
+            op += literals;
+
+            const size_t offset = ip - candidate;
+            *op++ = (uint8_t)(offset);
+            *op++ = (uint8_t)(offset >> 8);
+
+            if (match - minMatch >= 15)
+                length(match - minMatch - 15);
+
+            ip    += match;
+            anchor = ip;
+
+            if (ip - 2 < matchLimit)
+                table[(read32(src + ip - 2) * 2654435761u) >> (32 - hashBits)] = (uint32_t)(ip - 2);
+
+            } // for each position
+
+        const size_t literals = size - anchor;
+        if ((size_t)(oend - op) < 1 + literals + literals / 255 + 1)
+            return 0;
+
+        *op++ = (uint8_t)(std::min<size_t>(literals, 15) << 4);
+        if (literals >= 15)
+            length(literals - 15);
+
+        memcpy(op, src + anchor, literals);
+        op += literals;
+
+        return (size_t)(op - dst);
+
+        } // MeshCodec :: compress
+
+    //
+    //  decompress
+    //
+    //  inverse of compress, checking every length and offset
+    //  against both buffers. true only if exactly expected
+    //  bytes came out
+    //
+    inline bool decompress (const uint8_t* src, size_t size, uint8_t* dst, size_t expected)
+        { // MeshCodec :: decompress
+
+        const uint8_t*       ip   = src;
+        const uint8_t* const iend = src + size;
+        uint8_t*             op   = dst;
+        uint8_t* const       oend = dst + expected;
+
+        auto length = [&] (size_t& value) -> bool
+            {
+            uint8_t byte;
+            do  {
+                if (ip >= iend)
+                    return false;
+                byte   = *ip++;
+                value += byte;
+                } while (byte == 255);
+            return true;
+            };
+
+        for (;;)
+            { // for each sequence
+
+            if (ip >= iend)
+                return false;
+
+            const uint8_t token = *ip++;
+
+            size_t literals = token >> 4;
+            if (literals == 15 && !length(literals))
+                return false;
+
+            if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op))
+                return false;
+
+            // short runs copy a fixed 16 bytes when both buffers
+            // have the room, which the compiler keeps inline
+            if (literals <= 16 && iend - ip >= 16 && oend - op >= 16)
+                memcpy(op, ip, 16);
+            else
+                memcpy(op, ip, literals);
+
+            op += literals;
+            ip += literals;
+
+            if (ip == iend)
+                return op == oend;
+
+            if (iend - ip < 2)
+                return false;
+
+            const size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+            ip += 2;
+
+            size_t match = token & 15;
+            if (match == 15 && !length(match))
+                return false;
+            match += 4;
+
+            if (offset == 0 || offset > (size_t)(op - dst) || match > (size_t)(oend - op))
+                return false;
+
+            const uint8_t* from = op - offset;
+
+            if (offset >= 16 && (size_t)(oend - op) >= match + 16)
+                {
+                for (size_t i = 0; i < match; i += 16)
+                    memcpy(op + i, from + i, 16);
+                }
+            else if (offset >= match)
+                memcpy(op, from, match);
+            else
+                {
+                // overlapping matches repeat the last offset bytes
+                for (size_t i = 0; i < match; ++i)
+                    op[i] = from[i];
+                }
+
+            op += match;
+
+            } // for each sequence
+
+        } // MeshCodec :: decompress
+
+    //
+    //  shuffle
+    //
+    //  splits count elements of stride bytes into stride planes,
+    //  the first holding byte 0 of every element and so on
+    //
+    inline void shuffle (const uint8_t* src, size_t count, size_t stride, uint8_t* dst)
+        { // MeshCodec :: shuffle
+        for (size_t b = 0; b < stride; ++b)
+            {
+            uint8_t* plane = dst + b * count;
+            for (size_t i = 0; i < count; ++i)
+                plane[i] = src[i * stride + b];
+            }
+        } // MeshCodec :: shuffle
+
+    //
+    //  unshuffle
+    //
+    //  interleaves the planes back into elements. this runs on
+    //  every decoded byte, so with SSE2 sixteen elements at a
+    //  time are rebuilt four planes (or two, for 16 bit indices)
+    //  at once with byte and word unpacks
+    //
+    inline void unshuffle (const uint8_t* src, size_t count, size_t stride, uint8_t* dst)
+        { // MeshCodec :: unshuffle
+
+        size_t i = 0;
+
+    #if defined(MESHCODEC_SSE2)
+        if (stride == 2)
+            for (; i + 16 <= count; i += 16)
+                {
+                __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + count + i));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2),      _mm_unpacklo_epi8(p0, p1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 16), _mm_unpackhi_epi8(p0, p1));
+                }
+
+        if (stride % 4 == 0)
+            for (; i + 16 <= count; i += 16)
+                for (size_t b = 0; b < stride; b += 4)
+                    { // for each four planes
+
+                    __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (b + 0) * count + i));
+                    __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (b + 1) * count + i));
+                    __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (b + 2) * count + i));
+                    __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (b + 3) * count + i));
+
+                    __m128i lo01 = _mm_unpacklo_epi8(p0, p1), hi01 = _mm_unpackhi_epi8(p0, p1);
+                    __m128i lo23 = _mm_unpacklo_epi8(p2, p3), hi23 = _mm_unpackhi_epi8(p2, p3);
+
+                    // one 32 bit word per element, in element order
+                    uint32_t words[16];
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(words + 0),  _mm_unpacklo_epi16(lo01, lo23));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(words + 4),  _mm_unpackhi_epi16(lo01, lo23));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(words + 8),  _mm_unpacklo_epi16(hi01, hi23));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(words + 12), _mm_unpackhi_epi16(hi01, hi23));
+
+                    for (size_t k = 0; k < 16; ++k)
+                        memcpy(dst + (i + k) * stride + b, &words[k], sizeof(uint32_t));
+
+                    } // for each four planes
+    #endif
+
+        for (; i < count; ++i)
+            for (size_t b = 0; b < stride; ++b)
+                dst[i * stride + b] = src[b * count + i];
+
+        } // MeshCodec :: unshuffle
+
+    //
+    //  delta
+    //
+    //  replaces each integer by the zigzagged difference to the
+    //  one before it, in place. neighbouring triangles share
+    //  vertices, so most differences are small
+    //
+    template <typename T>
+    inline void delta (uint8_t* data, size_t count)
+        { // MeshCodec :: delta
+        T previous = 0;
+        for (size_t i = 0; i < count; ++i)
+            {
+            T value; memcpy(&value, data + i * sizeof(T), sizeof(T));
+            T d = (T)(value - previous);
+            T z = (T)((T)(d << 1) ^ (T)(0 - (d >> (sizeof(T) * 8 - 1))));
+            memcpy(data + i * sizeof(T), &z, sizeof(T));
+            previous = value;
+            }
+        } // MeshCodec :: delta
+
+    template <typename T>
+    inline void undelta (uint8_t* data, size_t count)
+        { // MeshCodec :: undelta
+        T previous = 0;
+        for (size_t i = 0; i < count; ++i)
+            {
+            T z; memcpy(&z, data + i * sizeof(T), sizeof(T));
+            previous = (T)(previous + (T)((z >> 1) ^ (T)(0 - (z & 1))));
+            memcpy(data + i * sizeof(T), &previous, sizeof(T));
+            }
+        } // MeshCodec :: undelta
+
+    //
+    //  encodeBlock
+    //
+    //  appends one block of whole elements to the stream, as
+    //  compressed planes or, when that does not pay, stored
+    //
+    inline void encodeBlock (const uint8_t* data, size_t size, const StreamHeader& header, std::vector<uint8_t>& out)
+        { // MeshCodec :: encodeBlock
+
+        const size_t count = size / header.stride;
+
+        std::vector<uint8_t> conditioned (data, data + size);
+        std::vector<uint8_t> planes      (size);
+
+        if (header.filter == eDelta && header.stride == sizeof(uint32_t))
+            delta<uint32_t>(conditioned.data(), count);
+
+        if (header.filter == eDelta && header.stride == sizeof(uint16_t))
+            delta<uint16_t>(conditioned.data(), count);
+
+        shuffle(conditioned.data(), count, header.stride, planes.data());
+
+        const size_t offset = out.size();
+        out.resize(offset + sizeof(uint32_t) + size);
+
+        size_t packed = compress(planes.data(), size, out.data() + offset + sizeof(uint32_t), size - 1);
+
+        uint32_t blockHeader = (uint32_t)packed;
+        if (packed == 0)
+            {
+            memcpy(out.data() + offset + sizeof(uint32_t), planes.data(), size);
+            blockHeader = (uint32_t)size | stored;
+            packed      = size;
+            }
+
+        memcpy(out.data() + offset, &blockHeader, sizeof(uint32_t));
+        out.resize(offset + sizeof(uint32_t) + packed);
+
+        } // MeshCodec :: encodeBlock
+
+    //
+    //  decodeBlock
+    //
+    //  writes one block straight into out, using scratch (a
+    //  block in size) for the planes of a compressed payload
+    //
+    inline bool decodeBlock (const uint8_t* payload, uint32_t blockHeader, uint8_t* out, size_t size, const StreamHeader& header, uint8_t* scratch)
+        { // MeshCodec :: decodeBlock
+
+        const size_t packed = blockHeader & ~stored;
+        const size_t count  = size / header.stride;
+
+        const uint8_t* planes = payload;
+
+        if (blockHeader & stored)
+            {
+            if (packed != size)
+                return false;
+            }
+        else
+            {
+            if (!decompress(payload, packed, scratch, size))
+                return false;
+            planes = scratch;
+            }
+
+        unshuffle(planes, count, header.stride, out);
+
+        if (header.filter == eDelta && header.stride == sizeof(uint32_t))
+            undelta<uint32_t>(out, count);
+
+        if (header.filter == eDelta && header.stride == sizeof(uint16_t))
+            undelta<uint16_t>(out, count);
+
+        return true;
+
+        } // MeshCodec :: decodeBlock
+
+    //
+    //  encode
+    //
+    //  compresses count elements of stride bytes, the blocks
+    //  spread across all hardware threads
+    //
+    inline std::vector<uint8_t> encode (const void* data, size_t count, uint32_t stride, Filter filter)
+        { // MeshCodec :: encode
+
+        StreamHeader header;
+            header.size   = (uint64_t)count * stride;
+            header.block  = std::max<uint32_t>(1, blockBytes / stride) * stride;
+            header.stride = (uint16_t)stride;
+            header.filter = filter;
+
+        const uint8_t* bytes  = static_cast<const uint8_t*>(data);
+        const size_t   blocks = (size_t)((header.size + header.block - 1) / header.block);
+
+        std::vector<std::vector<uint8_t>> encoded (blocks);
+
+        Parallel::forRange(blocks, 4, [&] (size_t begin, size_t end, uint32_t)
+            {
+            for (size_t b = begin; b < end; ++b)
+                {
+                const size_t offset = b * header.block;
+                const size_t size   = (size_t)std::min<uint64_t>(header.block, header.size - offset);
+                encodeBlock(bytes + offset, size, header, encoded[b]);
+                }
+            });
+
+        size_t total = sizeof(StreamHeader);
+        for (const std::vector<uint8_t>& block : encoded)
+            total += block.size();
+
+        std::vector<uint8_t> out (total);
+        memcpy(out.data(), &header, sizeof(header));
+
+        size_t cursor = sizeof(header);
+        for (const std::vector<uint8_t>& block : encoded)
+            {
+            memcpy(out.data() + cursor, block.data(), block.size());
+            cursor += block.size();
+            }
+
+        return out;
+
+        } // MeshCodec :: encode
+
+    //
+    //  valid
+    //
+    //  checks a stream header describes capacity decoded bytes
+    //  in blocks a decoder is prepared to hold
+    //
+    inline bool valid (const StreamHeader& header, size_t capacity)
+        { // MeshCodec :: valid
+        return header.size   == capacity &&
+               header.stride != 0 &&
+               header.block  != 0 &&
+               header.block  <= maxBlock &&
+               header.block  %  header.stride == 0;
+        } // MeshCodec :: valid
+
+    //
+    //  decode
+    //
+    //  decodes a whole stream held in memory, such as a mapped
+    //  section, into destination. the block headers are walked
+    //  once to find each payload and the blocks then decode in
+    //  parallel
+    //
+    inline bool decode (const uint8_t* data, size_t size, void* destination, size_t capacity)
+        { // MeshCodec :: decode
+
+        StreamHeader header;
+        if (size < sizeof(header))
+            return false;
+
+        memcpy(&header, data, sizeof(header));
+        if (!valid(header, capacity))
+            return false;
+
+        const size_t blocks = (size_t)((header.size + header.block - 1) / header.block);
+
+        std::vector<size_t> offsets (blocks);
+        size_t cursor = sizeof(header);
+
+        for (size_t b = 0; b < blocks; ++b)
+            {
+            if (size - cursor < sizeof(uint32_t))
+                return false;
+
+            offsets[b] = cursor;
+            cursor    += sizeof(uint32_t) + (read32(data + cursor) & ~stored);
+
+            if (cursor > size)
+                return false;
+            }
+
+        uint8_t*          out = static_cast<uint8_t*>(destination);
+        std::atomic<bool> failed (false);
+
+        Parallel::forRange(blocks, 4, [&] (size_t begin, size_t end, uint32_t)
+            {
+            std::vector<uint8_t> scratch (header.block);
+
+            for (size_t b = begin; b < end; ++b)
+                {
+                const size_t offset = b * header.block;
+                const size_t length = (size_t)std::min<uint64_t>(header.block, header.size - offset);
+
+                if (!decodeBlock(data + offsets[b] + sizeof(uint32_t), read32(data + offsets[b]), out + offset, length, header, scratch.data()))
+                    failed = true;
+                }
+            });
+
+        return !failed;
+
+        } // MeshCodec :: decode
+
+    //
+    //  decode
+    //
+    //  decodes a stream pulled through read(buffer, max), which
+    //  returns how many bytes it placed (0 once exhausted). the
+    //  source is read in fixed chunks into a window a block or
+    //  so large and each block is decoded straight into
+    //  destination, so memory use does not grow with the data
+    //
+    template <typename Read>
+    inline bool decode (Read read, void* destination, size_t capacity)
+        { // MeshCodec :: decode
+
+        const size_t chunk = 64 * 1024;
+
+        std::vector<uint8_t> window;
+        size_t begin = 0;
+        size_t end   = 0;
+
+        // makes sure n bytes are waiting in the window
+        auto fill = [&] (size_t n) -> bool
+            {
+            if (end - begin >= n)
+                return true;
+
+            if (window.size() < n + chunk)
+                window.resize(n + chunk);
+
+            memmove(window.data(), window.data() + begin, end - begin);
+            end  -= begin;
+            begin = 0;
+
+            while (end < n)
+                {
+                size_t got = read(window.data() + end, chunk);
+                if (got == 0)
+                    return false;
+                end += got;
+                }
+
+            return true;
+            };
+
+        StreamHeader header;
+        if (!fill(sizeof(header)))
+            return false;
+
+        memcpy(&header, window.data() + begin, sizeof(header));
+        begin += sizeof(header);
+
+        if (!valid(header, capacity))
+            return false;
+
+        std::vector<uint8_t> scratch (header.block);
+        uint8_t* out = static_cast<uint8_t*>(destination);
+
+        for (uint64_t offset = 0; offset < header.size; offset += header.block)
+            { // for each block
+
+            const size_t length = (size_t)std::min<uint64_t>(header.block, header.size - offset);
+
+            if (!fill(sizeof(uint32_t)))
+                return false;
+
+            const uint32_t blockHeader = read32(window.data() + begin);
+            const size_t   packed      = blockHeader & ~stored;
+
+            if (packed > header.block || !fill(sizeof(uint32_t) + packed))
+                return false;
+
+            if (!decodeBlock(window.data() + begin + sizeof(uint32_t), blockHeader, out + offset, length, header, scratch.data()))
+                return false;
+
+            begin += sizeof(uint32_t) + packed;
+
+            } // for each block
+
+        return true;
+
+        } // MeshCodec :: decode
+
+    } // MeshCodec
+
+#endif /* MeshCodec_hpp */
@@ -0,0 +1,450 @@
+//
+//  MeshGenerator.hpp
+//  ForwardRenderer
+//
+//  procedural stand ins for the scanned meshes, built to an
+//  exact triangle count so frame time can be measured against
+//  geometry independently of the number of objects
+//
+
+#ifndef MeshGenerator_hpp
+#define MeshGenerator_hpp
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "VulkanVertex.hpp"
+#include "Parallel.hpp"
+
+struct MeshGenerator
+    { // MeshGenerator struct
+
+    enum Shape : uint32_t
+        {
+        eSphere = 0, // cube subdivided and pushed out onto a sphere
+        eGrid   = 1, // flat square, the only open shape
+        eTorus  = 2,
+        eBlob   = 3  // the sphere with noise pushing it in and out
+        };
+
+    // every shape fits in a sphere about this size, which
+    // is roughly that of the scans
+    static constexpr float radius = 2.0f;
+
+    //
+    //  parse
+    //
+    //  reads a shape from its name, sphere, grid, torus or blob
+    //
+    static inline bool parse (const std::string& name, Shape& shape);
+
+    //
+    //  measure
+    //
+    //  the number of vertices a shape takes to reach the given
+    //  triangle count. false when the budget is too small for
+    //  the shape, under 108 triangles for the sphere and blob
+    //  or 36 for the torus, or needs more vertices than 32 bit
+    //  indices can reach
+    //
+    static inline bool measure (Shape shape, uint64_t triangles, size_t& vertexCount);
+
+    //
+    //  generate
+    //
+    //  writes exactly the given number of triangles into arrays
+    //  sized by measure. the shapes are quad grids with a few
+    //  quads, spread evenly, fanned into four triangles about
+    //  their centre to make up the difference. a closed surface
+    //  always has an even number of triangles, so an odd budget
+    //  puts the last one inside the shape, where it is never
+    //  seen. colours are a flat grey, uvs cover 0 to 1 on each
+    //  face and ids are 0, ready to be batched
+    //
+    static inline void generate (Shape shape, uint64_t triangles, Vertex* vertices, uint32_t* indices, uint32_t seed = 0);
+
+    static inline bool generate (Shape shape, uint64_t triangles, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t seed = 0);
+
+private:
+
+    // how a budget is split into grids and fans
+    struct Plan
+        {
+        uint32_t patches = 0; // grids of cols x rows quads
+        uint32_t cols    = 0;
+        uint32_t rows    = 0;
+        uint64_t fans    = 0; // quads split into four triangles
+        bool     extra   = false; // one more triangle for an odd budget
+
+        uint64_t quads        () const { return (uint64_t)patches * cols * rows; }
+        uint64_t gridVertices () const { return (uint64_t)patches * (cols + 1) * (rows + 1); }
+        uint64_t extraVertices (Shape shape) const { return extra ? (shape == eGrid ? 1 : 3) : 0; }
+
+        // fans before quad q, so each quad can find its place
+        // in the index buffer on its own
+        uint64_t fansBefore (uint64_t q) const { return q * fans / quads(); }
+        };
+
+    static inline bool plan (Shape shape, uint64_t triangles, Plan& result);
+
+    //
+    //  the surface at a point of a patch, in half quad steps
+    //  so quad centres and edge midpoints land on whole numbers
+    //
+    static inline Vertex surface (Shape shape, uint32_t patch, uint32_t i2, uint32_t j2, const Plan& plan, uint32_t seed);
+
+    static inline float noise (glm::vec3 p, uint32_t seed);
+    static inline float displacement (glm::vec3 direction, uint32_t seed);
+
+    }; // MeshGenerator struct
+
+bool MeshGenerator::parse (const std::string& name, Shape& shape)
+    { // MeshGenerator :: parse
+
+    if      (name == "sphere") shape = eSphere;
+    else if (name == "grid")   shape = eGrid;
+    else if (name == "torus")  shape = eTorus;
+    else if (name == "blob")   shape = eBlob;
+    else return false;
+
+    return true;
+
+    } // MeshGenerator :: parse
+
+bool MeshGenerator::plan (Shape shape, uint64_t triangles, Plan& result)
+    { // MeshGenerator :: plan
+
+    Plan p;
+
+    // the grid is close to square and the torus twice as long
+    // around as through its tube, with the columns taking up as
+    // much of the budget as whole rows of them can. that leaves
+    // fewer fans than there are rows. the sphere's six cube
+    // faces have to stay square for their edges to meet, so it
+    // is the one shape small budgets can miss
+    if (shape == eGrid || shape == eTorus)
+        {
+        p.patches = 1;
+        p.rows    = (uint32_t)std::sqrt((double)(triangles / (shape == eGrid ? 2 : 4)));
+        p.cols    = p.rows ? (uint32_t)std::min<uint64_t>(triangles / (2 * p.rows), 0xFFFFFFFEull) : 0;
+        }
+    else
+        {
+        p.patches = 6;
+        p.cols    = (uint32_t)std::sqrt((double)(triangles / 12));
+        p.rows    = p.cols;
+        }
+
+    // a torus needs three rows around its tube to have any volume
+    if (p.quads() == 0 || (shape == eTorus && p.rows < 3))
+        return false;
+
+    const uint64_t missing = triangles - 2 * p.quads();
+
+    p.extra = (missing & 1) != 0;
+    p.fans  = missing / 2;
+
+    // quad 0 takes the grid's odd triangle, so it can never
+    // also be a fan, which holds while fans stay below quads
+    if (p.fans >= p.quads())
+        return false;
+
+    if (p.gridVertices() + p.fans + p.extraVertices(shape) > 0xFFFFFFFFull)
+        return false;
+
+    result = p;
+    return true;
+
+    } // MeshGenerator :: plan
+
+bool MeshGenerator::measure (Shape shape, uint64_t triangles, size_t& vertexCount)
+    { // MeshGenerator :: measure
+
+    Plan p;
+    if (!plan(shape, triangles, p))
+        return false;
+
+    vertexCount = (size_t)(p.gridVertices() + p.fans + p.extraVertices(shape));
+    return true;
+
+    } // MeshGenerator :: measure
+
+void MeshGenerator::generate (Shape shape, uint64_t triangles, Vertex* vertices, uint32_t* indices, uint32_t seed)
+    { // MeshGenerator :: generate
+
+    Plan p;
+    if (!plan(shape, triangles, p))
+        return;
+
+    const uint32_t stride    = p.cols + 1;
+    const uint64_t perPatch  = (uint64_t)stride * (p.rows + 1);
+    const uint64_t fanBase   = p.gridVertices();
+    const uint64_t extraBase = fanBase + p.fans;
+
+    auto corner = [&] (uint32_t patch, uint32_t i, uint32_t j)
+        {
+        return (uint32_t)(patch * perPatch + (uint64_t)j * stride + i);
+        };
+
+    // vertices first, a row of a patch at a time
+    const uint64_t vertexRows = (uint64_t)p.patches * (p.rows + 1);
+
+    Parallel::forRange((size_t)vertexRows, 64, [&] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t r = begin; r < end; ++r)
+            {
+            const uint32_t patch = (uint32_t)(r / (p.rows + 1));
+            const uint32_t j     = (uint32_t)(r % (p.rows + 1));
+
+            for (uint32_t i = 0; i <= p.cols; ++i)
+                vertices[corner(patch, i, j)] = surface(shape, patch, 2 * i, 2 * j, p, seed);
+            }
+        });
+
+    // then the quads, each writing its own triangles and fan
+    // centre, placed by how many of each came before it
+    const uint64_t quadRows = (uint64_t)p.patches * p.rows;
+
+    Parallel::forRange((size_t)quadRows, 64, [&] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t r = begin; r < end; ++r)
+            { // for each row of quads
+
+            const uint32_t patch = (uint32_t)(r / p.rows);
+            const uint32_t j     = (uint32_t)(r % p.rows);
+
+            for (uint32_t i = 0; i < p.cols; ++i)
+                { // for each quad
+
+                const uint64_t q      = (uint64_t)r * p.cols + i;
+                const uint64_t before = p.fansBefore(q);
+                const bool     fan    = p.fansBefore(q + 1) > before;
+
+                uint32_t* out = indices + 3 * (2 * q + 2 * before + (p.extra && shape == eGrid && q > 0 ? 1 : 0));
+
+                const uint32_t a = corner(patch, i,     j);
+                const uint32_t b = corner(patch, i + 1, j);
+                const uint32_t c = corner(patch, i + 1, j + 1);
+                const uint32_t d = corner(patch, i,     j + 1);
+
+                auto triangle = [&out] (uint32_t x, uint32_t y, uint32_t z)
+                    {
+                    out[0] = x; out[1] = y; out[2] = z;
+                    out += 3;
+                    };
+
+                if (fan)
+                    {
+                    const uint32_t m = (uint32_t)(fanBase + before);
+                    vertices[m] = surface(shape, patch, 2 * i + 1, 2 * j + 1, p, seed);
+
+                    triangle(a, b, m);
+                    triangle(b, c, m);
+                    triangle(c, d, m);
+                    triangle(d, a, m);
+                    }
+                else if (q == 0 && p.extra && shape == eGrid)
+                    {
+                    // the grid's odd triangle comes from splitting
+                    // the first quad at the middle of its outer edge
+                    const uint32_t m = (uint32_t)extraBase;
+                    vertices[m] = surface(shape, patch, 1, 0, p, seed);
+
+                    triangle(a, m, d);
+                    triangle(m, b, c);
+                    triangle(m, c, d);
+                    }
+                else
+                    {
+                    triangle(a, b, c);
+                    triangle(a, c, d);
+                    }
+
+                } // for each quad
+
+            } // for each row of quads
+        });
+
+    // a closed shape's odd triangle sits, tiny, somewhere the
+    // surface always hides, the middle of the sphere or the
+    // inside of the torus tube
+    if (p.extra && shape != eGrid)
+        {
+        const glm::vec3 inside = shape == eTorus ? glm::vec3(0.75f * radius, 0.0f, 0.0f) : glm::vec3(0.0f);
+        const float     size   = 0.001f * radius;
+
+        const glm::vec3 offsets[3] = { { 0.0f, 0.0f, 0.0f }, { size, 0.0f, 0.0f }, { 0.0f, size, 0.0f } };
+
+        for (uint32_t k = 0; k < 3; ++k)
+            {
+            Vertex& v = vertices[extraBase + k];
+                v.position = inside + offsets[k];
+                v.normal   = { 0.0f, 0.0f, 1.0f };
+                v.color    = { 0.64f, 0.64f, 0.64f };
+                v.uvs      = { 0.0f, 0.0f };
+                v.id       = 0;
+            }
+
+        uint32_t* out = indices + 3 * (triangles - 1);
+        out[0] = (uint32_t)extraBase;
+        out[1] = (uint32_t)extraBase + 1;
+        out[2] = (uint32_t)extraBase + 2;
+        }
+
+    } // MeshGenerator :: generate
+
+bool MeshGenerator::generate (Shape shape, uint64_t triangles, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t seed)
+    { // MeshGenerator :: generate
+
+    size_t vertexCount = 0;
+    if (!measure(shape, triangles, vertexCount))
+        return false;
+
+    vertices.resize(vertexCount);
+    indices.resize((size_t)(3 * triangles));
+
+    generate(shape, triangles, vertices.data(), indices.data(), seed);
+    return true;
+
+    } // MeshGenerator :: generate
+
+Vertex MeshGenerator::surface (Shape shape, uint32_t patch, uint32_t i2, uint32_t j2, const Plan& plan, uint32_t seed)
+    { // MeshGenerator :: surface
+
+    const float pi = 3.14159265358979f;
+
+    Vertex v;
+        v.color = { 0.64f, 0.64f, 0.64f };
+        v.uvs   = { (float)i2 / (float)(2 * plan.cols), (float)j2 / (float)(2 * plan.rows) };
+        v.id    = 0;
+
+    // -1 to 1 across the patch, worked out in integers so points
+    // mirrored about the middle come out exactly negated
+    const float s = (float)((int64_t)i2 - (int64_t)plan.cols) / (float)plan.cols;
+    const float t = (float)((int64_t)j2 - (int64_t)plan.rows) / (float)plan.rows;
+
+    if (shape == eGrid)
+        {
+        v.position = { radius * 0.7f * t, 0.0f, radius * 0.7f * s };
+        v.normal   = { 0.0f, 1.0f, 0.0f };
+        return v;
+        }
+
+    if (shape == eTorus)
+        {
+        // the seam is wrapped back to angle 0, so both sides of
+        // it are built from the very same numbers
+        const float theta = 2.0f * pi * (float)(i2 % (2 * plan.cols)) / (float)(2 * plan.cols);
+        const float phi   = 2.0f * pi * (float)(j2 % (2 * plan.rows)) / (float)(2 * plan.rows);
+
+        const float major = 0.75f * radius;
+        const float minor = 0.25f * radius;
+
+        v.normal   = { std::cos(phi) * std::cos(theta), std::cos(phi) * std::sin(theta), std::sin(phi) };
+        v.position = glm::vec3(major * std::cos(theta), major * std::sin(theta), 0.0f) + minor * v.normal;
+        return v;
+        }
+
+    // each cube face is a patch, its u and v axes crossing
+    // to its outward normal so every face winds the same way
+    static const glm::vec3 normals[6] = { {  1, 0, 0 }, { -1, 0, 0 }, { 0,  1, 0 }, { 0, -1, 0 }, { 0, 0,  1 }, { 0, 0, -1 } };
+    static const glm::vec3 us     [6] = { {  0, 1, 0 }, {  0, 0, 1 }, { 0,  0, 1 }, { 1,  0, 0 }, { 1, 0,  0 }, { 0, 1,  0 } };
+    static const glm::vec3 vs     [6] = { {  0, 0, 1 }, {  0, 1, 0 }, { 1,  0, 0 }, { 0,  0, 1 }, { 0, 1,  0 }, { 1, 0,  0 } };
+
+    // equal angle spacing evens out the quads towards the
+    // cube's corners. the edges are pinned to exactly one, so
+    // neighbouring faces meet without cracks
+    auto spread = [pi] (float x) { return x == 1.0f || x == -1.0f ? x : std::tan(x * pi * 0.25f); };
+
+    const glm::vec3 direction = glm::normalize(normals[patch] + spread(s) * us[patch] + spread(t) * vs[patch]);
+
+    if (shape == eSphere)
+        {
+        v.normal   = direction;
+        v.position = radius * direction;
+        return v;
+        }
+
+    // the blob's normal comes from differences taken about the
+    // direction alone, so vertices shared along face edges agree
+    const glm::vec3 helper   = std::abs(direction.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 tangent  = glm::normalize(glm::cross(helper, direction));
+    const glm::vec3 binormal = glm::cross(direction, tangent);
+
+    auto point = [seed] (glm::vec3 d)
+        {
+        d = glm::normalize(d);
+        return d * displacement(d, seed);
+        };
+
+    const float e = 1e-3f;
+
+    v.position = point(direction);
+
+    const glm::vec3 du = point(direction + e * tangent)  - v.position;
+    const glm::vec3 dv = point(direction + e * binormal) - v.position;
+    v.normal   = glm::normalize(glm::cross(du, dv));
+
+    if (glm::dot(v.normal, direction) < 0.0f)
+        v.normal = -v.normal;
+
+    return v;
+
+    } // MeshGenerator :: surface
+
+float MeshGenerator::noise (glm::vec3 p, uint32_t seed)
+    { // MeshGenerator :: noise
+
+    // value noise, a hashed value at each lattice point blended
+    // smoothly across the cell
+    auto lattice = [seed] (int32_t x, int32_t y, int32_t z)
+        {
+        uint32_t h = seed * 0x9E3779B1u ^ (uint32_t)x * 0x85EBCA6Bu ^ (uint32_t)y * 0xC2B2AE35u ^ (uint32_t)z * 0x27D4EB2Fu;
+        h ^= h >> 15; h *= 0x2C1B3C6Du;
+        h ^= h >> 12; h *= 0x297A2D39u;
+        h ^= h >> 15;
+        return (float)(h & 0xFFFFFF) / (float)0x7FFFFF - 1.0f;
+        };
+
+    const glm::vec3 cell = glm::floor(p);
+    const glm::vec3 f    = p - cell;
+    const glm::vec3 w    = f * f * (3.0f - 2.0f * f);
+
+    const int32_t x = (int32_t)cell.x, y = (int32_t)cell.y, z = (int32_t)cell.z;
+
+    const float x00 = glm::mix(lattice(x, y,     z),     lattice(x + 1, y,     z),     w.x);
+    const float x10 = glm::mix(lattice(x, y + 1, z),     lattice(x + 1, y + 1, z),     w.x);
+    const float x01 = glm::mix(lattice(x, y,     z + 1), lattice(x + 1, y,     z + 1), w.x);
+    const float x11 = glm::mix(lattice(x, y + 1, z + 1), lattice(x + 1, y + 1, z + 1), w.x);
+
+    return glm::mix(glm::mix(x00, x10, w.y), glm::mix(x01, x11, w.y), w.z);
+
+    } // MeshGenerator :: noise
+
+float MeshGenerator::displacement (glm::vec3 direction, uint32_t seed)
+    { // MeshGenerator :: displacement
+
+    // a few octaves, the largest moving the surface by up
+    // to a fifth of the radius and the rest adding detail
+    float sum       = 0.0f;
+    float amplitude = 0.2f;
+    float frequency = 1.5f;
+
+    for (uint32_t octave = 0; octave < 4; ++octave)
+        {
+        sum       += amplitude * noise(direction * frequency + glm::vec3(17.0f * octave), seed);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+        }
+
+    // kept inside the bounding radius like the other shapes
+    return radius * (1.0f + sum) / 1.4f;
+
+    } // MeshGenerator :: displacement
+
+#endif /* MeshGenerator_hpp */
@@ -16,6 +16,444 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <limits>
+#include <cstring>
+
+#include <glm/gtc/packing.hpp>
+
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+#include "Bounds.hpp"
+#include "TaskPool.hpp"
+#include "MeshCodec.hpp"
+#include "MeshCache.hpp"
+#include "MeshGenerator.hpp"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshSpan
+ *
+ *  read-only view over a contiguous run of elements that
+ *  we do not own, typically a section of a mapped file
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+template <typename T>
+struct MeshSpan
+    {
+    const T* data = nullptr;
+    size_t   size = 0;
+
+    const T* begin () const { return data; }
+    const T* end   () const { return data + size; }
+
+    const T& operator[] (size_t i) const { return data[i]; }
+
+    size_t bytes () const { return sizeof(T) * size; }
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshBounds
+ *
+ *  bounding volumes of a mesh in model space, stored in
+ *  v2 files so they are not recomputed on every start
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshBounds
+    {
+    glm::vec3 centroid = { 0.0f, 0.0f, 0.0f }; // average vertex position
+    glm::vec3 min      = { 0.0f, 0.0f, 0.0f }; // axis aligned box
+    glm::vec3 max      = { 0.0f, 0.0f, 0.0f };
+    glm::vec3 center   = { 0.0f, 0.0f, 0.0f }; // bounding sphere
+    float     radius   = 0.0f;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshQuantization
+ *
+ *  maps PackedVertex positions back into model space,
+ *  position = offset + quantized * scale. padded to vec4s
+ *  so it can be copied straight into a uniform buffer
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshQuantization
+    {
+    glm::vec4 offset = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec4 scale  = { 1.0f, 1.0f, 1.0f, 0.0f };
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshLOD
+ *
+ *  one simplified level of a mesh. its indices live in the
+ *  lod index section and reference the full vertex array.
+ *  error is the largest deviation the simplifier allowed,
+ *  as a fraction of the bounding sphere radius. in files
+ *  made progressive the level only uses the first
+ *  vertexCount vertices, elsewhere vertexCount is 0
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshLOD
+    {
+    uint32_t firstIndex  = 0;
+    uint32_t indexCount  = 0;
+    float    error       = 0.0f;
+    uint32_t vertexCount = 0;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  Meshlet
+ *
+ *  a cluster of at most maxVertices vertices and maxTriangles
+ *  triangles. its vertices index the mesh through the meshlet
+ *  vertex list and its triangles are byte triples into those.
+ *  the sphere and normal cone let a whole cluster be culled:
+ *  it faces away from an eye when
+ *  dot(normalize(coneApex - eye), coneAxis) >= coneCutoff
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct Meshlet
+    {
+    static const uint32_t maxVertices  = 64;
+    static const uint32_t maxTriangles = 124;
+    
+    uint32_t vertexOffset   = 0; // into the meshlet vertex list
+    uint32_t triangleOffset = 0; // into the meshlet triangle bytes, 4 byte aligned
+    uint32_t vertexCount    = 0;
+    uint32_t triangleCount  = 0;
+    
+    glm::vec3 center     = { 0.0f, 0.0f, 0.0f };
+    float     radius     = 0.0f;
+    glm::vec3 coneAxis   = { 0.0f, 0.0f, 0.0f };
+    float     coneCutoff = 1.0f; // 1 means the cone is too wide to ever cull
+    glm::vec3 coneApex   = { 0.0f, 0.0f, 0.0f };
+    float     reserved   = 0.0f;
+    };
+
+//
+//  worst case differences between a mesh and its packed
+//  form, positions in model units and normals in degrees
+//
+struct QuantizationError
+    {
+    float position = 0.0f;
+    float normal   = 0.0f;
+    float color    = 0.0f;
+    float uvs      = 0.0f;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshFormat
+ *
+ *  on-disk layout of the versioned .mesh container.
+ *
+ *  v1 files are two uint32 counts followed by the raw
+ *  vertex and index arrays. v2 files open with a header
+ *  and a table of sections, each aligned to a cache line
+ *  and carrying its own checksum:
+ *
+ *      Header
+ *      Section[sectionCount]
+ *      ... section payloads
+ *
+ *  v3 files are v2 files in which some sections are
+ *  flagged eCompressed and hold a MeshCodec stream. their
+ *  size is the encoded length and the checksum covers the
+ *  encoded bytes, while count and stride still describe
+ *  the decoded array.
+ *
+ *  progressive files are v2 files whose vertices are in
+ *  coarsest level first order, flagged eProgressive on
+ *  the index section. the small sections are laid out
+ *  ahead of the vertices and the full indices go last,
+ *  so reading front to back brings in each level whole
+ *  before the next
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+namespace MeshFormat
+    {
+    
+    const uint32_t magic     = 0x4853454D; // "MESH"
+    const uint16_t version   = 2;
+    const uint16_t compressedVersion = 3; // written when any section is compressed
+    const uint32_t pipeline  = 1; // bump whenever a MeshIO::optimize pass changes its output
+    const uint32_t alignment = 64;
+    
+    enum Section : uint32_t
+        {
+        eVertices = 1,  // Vertex[count]
+        eIndices  = 2,  // uint16_t[count] or uint32_t[count], see stride
+        eBounds   = 3,  // MeshBounds
+        eLODs     = 4,  // MeshLOD[count], coarsest last
+        eMeshlets = 5,  // Meshlet[count]
+        
+        ePackedVertices = 6, // PackedVertex[count]
+        eQuantization   = 7, // MeshQuantization
+        eLODIndices     = 8, // uint16_t or uint32_t[count], every level back to back
+        
+        eMeshletVertices  = 9,  // uint32_t[count], mesh vertex of each meshlet vertex
+        eMeshletTriangles = 10  // uint8_t[count], meshlet local corners
+        };
+    
+    // masks for picking which sections a loader wants
+    const uint32_t all = 0xFFFFFFFF;
+    inline uint32_t bit (Section section) { return 1u << section; }
+    
+    struct Header
+        {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t sectionCount;
+        uint32_t headerSize;   // sizeof(Header), for forwards compatibility
+        uint32_t sectionSize;  // sizeof(SectionEntry)
+        uint64_t fileSize;
+        uint64_t source;       // checksum of the file this one was derived from, or 0
+        };
+    
+    struct SectionEntry
+        {
+        uint32_t type;
+        uint32_t flags;
+        uint64_t offset;   // from the start of the file
+        uint64_t size;     // in bytes
+        uint32_t count;    // number of elements
+        uint32_t stride;   // size of each element
+        uint64_t checksum; // MeshIO::checksum of the payload
+        uint64_t reserved;
+        };
+    
+    // per section flags describing how a payload was conditioned
+    enum SectionFlags : uint32_t
+        {
+        eVertexCacheOptimized = 1 << 0, // indices ordered by MeshIO::optimizeVertexCache
+        eOverdrawOptimized    = 1 << 1, // clusters ordered by MeshIO::optimizeOverdraw
+        eVertexFetchOptimized = 1 << 2, // vertices renumbered by MeshIO::optimizeVertexFetch
+        eWelded               = 1 << 3, // duplicate vertices removed by MeshIO::weld
+        eLevelsOfDetail       = 1 << 4, // lod chain built by MeshIO::generateLevels
+        eMeshletsBuilt        = 1 << 5, // clusters built by MeshIO::buildMeshlets
+        eCompressed           = 1 << 6, // payload is a MeshCodec stream
+        eProgressive          = 1 << 7  // vertices ordered coarsest level first by MeshIO::makeProgressive
+        };
+    
+    static_assert(sizeof(Header)       == 32, "mesh header must stay 32 bytes");
+    static_assert(sizeof(SectionEntry) == 48, "mesh section entry must stay 48 bytes");
+    static_assert(sizeof(MeshBounds)   == 52, "mesh bounds must stay 52 bytes");
+    static_assert(sizeof(MeshQuantization) == 32, "mesh quantization must stay 32 bytes");
+    static_assert(sizeof(MeshLOD)      == 16, "mesh lod entry must stay 16 bytes");
+    static_assert(sizeof(Meshlet)      == 64, "meshlets must stay 64 bytes");
+    
+    } // MeshFormat
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshView
+ *
+ *  a .mesh file mapped into memory. the spans point into
+ *  the mapping and are only valid while the view lives
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshView
+    {
+    MappedFile         file;
+    MeshSpan<Vertex>   vertices;
+    MeshSpan<uint32_t> indices;
+    MeshSpan<uint16_t> indices16; // set instead of indices when the file stores 16 bit indices
+    
+    uint32_t           version   = 0;
+    bool               hasBounds = false;
+    MeshBounds         bounds;
+    
+    MeshSpan<PackedVertex> packed;   // only present in quantized files
+    MeshQuantization       quantization;
+    
+    MeshSpan<MeshLOD>      lods;     // only present once levels have been generated
+    MeshSpan<uint32_t>     lodIndices;
+    MeshSpan<uint16_t>     lodIndices16;
+    
+    MeshSpan<Meshlet>      meshlets; // only present once clusters have been built
+    MeshSpan<uint32_t>     meshletVertices;
+    MeshSpan<uint8_t>      meshletTriangles;
+    
+    MeshSpan<MeshFormat::SectionEntry> sections; // empty for v1 files
+    
+    std::vector<uint8_t> decoded; // backing for the spans of compressed sections or generated meshes
+    
+    uint32_t indexFlags = 0; // MeshFormat::SectionFlags of the index section
+    uint64_t source     = 0; // checksum of the file this was derived from
+    
+    // whichever index width the file holds
+    size_t      indexCount () const { return indices.size + indices16.size; }
+    size_t      indexBytes () const { return indices.bytes() + indices16.bytes(); }
+    const void* indexData  () const { return indices.size ? (const void*)indices.data : (const void*)indices16.data; }
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshAsset
+ *
+ *  everything a .mesh file can carry, held in memory
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshAsset
+    {
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+    
+    bool       hasBounds = false;
+    MeshBounds bounds;
+    
+    std::vector<PackedVertex> packed;
+    MeshQuantization          quantization;
+    
+    std::vector<MeshLOD>  lods;
+    std::vector<uint32_t> lodIndices;
+    
+    std::vector<Meshlet>  meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t>  meshletTriangles;
+    
+    uint32_t indexFlags = 0; // MeshFormat::SectionFlags of the indices
+    uint64_t source     = 0; // checksum of the file this was derived from
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshBatchItem
+ *
+ *  one object of a batch merged by MeshIO::merge. the
+ *  spans are only read, so many items may share a mesh.
+ *  first vertex and first index are filled in by the
+ *  merge with where the object landed
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshBatchItem
+    {
+    MeshSpan<Vertex>   vertices;
+    MeshSpan<uint32_t> indices;   // one of the two index spans is set
+    MeshSpan<uint16_t> indices16;
+    int32_t            id = 0;    // stamped on every vertex
+    
+    size_t firstVertex = 0;
+    size_t firstIndex  = 0;
+    
+    size_t indexCount () const { return indices.size + indices16.size; }
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  VertexCacheStats
+ *
+ *  results of simulating a post-transform vertex cache.
+ *  acmr is vertex shader invocations per triangle (0.5 is
+ *  ideal for large grids, 3 is no reuse at all) and atvr
+ *  is invocations per unique vertex (1 is ideal)
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct VertexCacheStats
+    {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  OverdrawStats
+ *
+ *  results of rasterizing a mesh on the cpu from a set of
+ *  viewpoints. overdraw is fragments shaded per covered
+ *  pixel with early depth testing, 1 being ideal
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct OverdrawStats
+    {
+    float    overdraw = 0.0f;
+    uint64_t covered  = 0;
+    uint64_t shaded   = 0;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  VertexFetchStats
+ *
+ *  results of simulating the cache lines pulled in by
+ *  vertex fetch. overfetch is bytes fetched over bytes of
+ *  vertices actually referenced, 1 being ideal
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct VertexFetchStats
+    {
+    float    overfetch = 0.0f;
+    uint64_t fetched   = 0;
+    uint64_t used      = 0;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  WeldStats
+ *
+ *  what MeshIO::weld removed. reduction is the fraction
+ *  of vertices that turned out to be duplicates
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct WeldStats
+    {
+    size_t verticesBefore  = 0;
+    size_t verticesAfter   = 0;
+    size_t trianglesBefore = 0;
+    size_t trianglesAfter  = 0; // fewer only when an epsilon collapses triangles
+    float  reduction       = 0.0f;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshOptimizeOptions
+ *
+ *  which conditioning passes MeshIO::optimize runs
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshOptimizeOptions
+    {
+    bool  weld              = true;
+    float weldEpsilon       = 0.0f;  // 0 only merges bitwise identical vertices
+    bool  vertexCache       = true;
+    bool  overdraw          = true;
+    bool  vertexFetch       = true;
+    float overdrawThreshold = 1.05f; // acmr we are willing to give up for overdraw
+    
+    bool               meshlets    = true;
+    bool               levels      = true;
+    std::vector<float> levelRatios = { 0.5f, 0.25f, 0.125f, 0.0625f }; // of the full triangle count
+    float              levelError  = 0.05f; // largest error any level may reach, fraction of the radius
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshChecksum
+ *
+ *  MeshIO::checksum fed in pieces of any size, for data
+ *  that streams past rather than sitting in one buffer
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshChecksum
+    {
+    uint64_t hash    = 0xCBF29CE484222325ull;
+    uint64_t size    = 0;
+    uint8_t  tail[8] = { };
+    
+    inline void     add   (const void* data, size_t size);
+    inline uint64_t value () const;
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshStream
+ *
+ *  a progressive .mesh file read in a level at a time,
+ *  coarsest first. the arrays are sized for the whole
+ *  mesh when the file is opened and fill in from the
+ *  front as it is refined, so anything holding on to
+ *  them sees each level land in place
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshStream
+    {
+    std::vector<Vertex>   vertices;  // read up to loaded, zero beyond
+    std::vector<uint32_t> indices;   // zero until the full level lands
+    std::vector<uint16_t> indices16; // set instead of indices when the file stores 16 bit indices
+    
+    bool       hasBounds = false;
+    MeshBounds bounds;
+    
+    std::vector<MeshLOD>  lods;
+    std::vector<uint32_t> lodIndices;
+    std::vector<uint16_t> lodIndices16;
+    
+    uint32_t indexFlags = 0;
+    
+    size_t   loaded = 0; // vertices read so far
+    uint32_t finest = 0; // finest level in memory, 0 the full mesh and l > 0 lods[l - 1]
+    
+    // spans over the arrays, for code written against mapped
+    // files. they stay valid while the stream lives
+    inline MeshView view () const;
+    
+    std::ifstream            file;
+    MeshFormat::SectionEntry vertexSection = { };
+    MeshFormat::SectionEntry indexSection  = { };
+    MeshChecksum             vertexHash;
+    };
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *  MeshIO Interface
@@ -24,174 +462,2997 @@
 struct MeshIO
     {
     
-    //
-    //  readMeshFile
-    //
-    //  populates the referenced arrays with the contents of the .mesh file
-    //  found at the given path on disk
-    //
-    static void readMeshFile  (const char* path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    //
+    //  readMeshFile
+    //
+    //  populates the referenced arrays with the contents of the .mesh file
+    //  found at the given path on disk
+    //
+    static void readMeshFile  (const char* path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    
+    //
+    //  mapMeshFile
+    //
+    //  maps the .mesh file found at the given path and points the
+    //  view's spans at its vertex and index sections without copying.
+    //  compressed sections are decoded, across all hardware threads,
+    //  into memory the view owns. returns false if the file is
+    //  missing, truncated, has a section table that does not add
+    //  up or misaligned payloads, or fails to decode
+    //
+    static bool mapMeshFile (const char* path, MeshView& view, MappedFile::Access access = MappedFile::Access::Sequential);
+    
+    //
+    //  pointSpan
+    //
+    //  points a span at count elements of a section's payload,
+    //  refusing when the payload is not aligned for them
+    //
+    template <typename T>
+    static bool pointSpan (MeshSpan<T>& span, const uint8_t* payload, uint32_t count)
+        { // MeshIO :: pointSpan
+        if (reinterpret_cast<uintptr_t>(payload) % alignof(T) != 0)
+            return false;
+        span = { reinterpret_cast<const T*>(payload), count };
+        return true;
+        } // MeshIO :: pointSpan
+    
+    //
+    //  writeMeshFile
+    //
+    //  creates a v2 .mesh file of the given model at the given path,
+    //  with its bounds precomputed
+    //
+    static void writeMeshFile (const char* path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    
+    //
+    //  readMeshAsset
+    //
+    //  reads only the requested sections (a mask of MeshFormat::bit)
+    //  of a v1, v2 or v3 .mesh file, seeking past the rest. when verify
+    //  is set each section read is checked against its stored checksum.
+    //  compressed sections stream through a block sized window and
+    //  decode straight into the asset's arrays. returns false if the
+    //  file is missing, truncated or corrupt
+    //
+    static bool readMeshAsset (const char* path, MeshAsset& asset, uint32_t sections = MeshFormat::all, bool verify = true);
+    
+    //
+    //  writeMeshAsset
+    //
+    //  writes the asset out as a v2 .mesh container. bounds are
+    //  computed first if the asset does not carry them. with
+    //  compress set the vertex, packed vertex, index and lod
+    //  index sections are stored as MeshCodec streams, giving
+    //  a v3 file, wherever that makes them smaller
+    //
+    static bool writeMeshAsset (const char* path, const MeshAsset& asset, bool compress = false);
+    
+    //
+    //  verify
+    //
+    //  recomputes the checksum of every section of a mapped v2
+    //  file and compares it with the table. v1 files always pass
+    //
+    static bool verify (const MeshView& view);
+    
+    //
+    //  checksum
+    //
+    //  64 bit FNV-1a style hash, folded a word at a time
+    //
+    static uint64_t checksum (const void* data, size_t size);
+    
+    //
+    //  computeBounds
+    //
+    //  centroid, axis aligned box and the tighter of the Ritter
+    //  sphere and the sphere around the box centre, in two passes
+    //  over the positions
+    //
+    static MeshBounds computeBounds (const Vertex* vertices, size_t count);
+    
+    //
+    //  quantize
+    //
+    //  converts full precision vertices into the compact PackedVertex
+    //  layout. positions are quantized across the vertices' bounding
+    //  box, returned as the parameters the shader decodes with
+    //
+    static MeshQuantization quantize (const Vertex* vertices, size_t count, std::vector<PackedVertex>& packed);
+    
+    //
+    //  dequantize
+    //
+    //  expands a packed vertex back to full precision, matching the
+    //  decode performed in object.vert
+    //
+    static Vertex dequantize (const PackedVertex& vertex, const MeshQuantization& quantization);
+    
+    //
+    //  quantizationError
+    //
+    //  measures the largest error introduced by quantize
+    //
+    static QuantizationError quantizationError
+            (const Vertex*           vertices,
+             const PackedVertex*     packed,
+             size_t                  count,
+             const MeshQuantization& quantization);
+    
+    //
+    //  weld
+    //
+    //  merges vertices whose attributes are identical, hashing the
+    //  full attribute tuple. with an epsilon, positions and normals
+    //  are first snapped to a grid of that size, which merges most
+    //  near duplicates (pairs straddling a grid line are missed).
+    //  the first occurrence of each vertex is kept, in the original
+    //  order, and triangles that collapse are dropped. runs across
+    //  all hardware threads for large inputs
+    //
+    static WeldStats weld
+            (std::vector<uint32_t>     &indices,
+             std::vector<Vertex>       &vertices,
+             float                      epsilon = 0.0f,
+             std::vector<PackedVertex> *packed  = nullptr);
+    
+    //
+    //  optimizeVertexCache
+    //
+    //  reorders triangles so that vertices are reused while they are
+    //  still in the gpu's post-transform cache, using the linear-speed
+    //  method described by Tom Forsyth. the set of triangles and their
+    //  winding are unchanged
+    //
+    static void optimizeVertexCache (std::vector<uint32_t>& indices, size_t vertexCount);
+    
+    //
+    //  analyzeVertexCache
+    //
+    //  simulates a post-transform cache of the given size over the
+    //  index buffer, either fifo (most hardware) or lru
+    //
+    static VertexCacheStats analyzeVertexCache
+            (const uint32_t* indices,
+             size_t          count,
+             size_t          vertexCount,
+             uint32_t        cacheSize = 16,
+             bool            fifo      = true);
+    
+    //
+    //  optimizeOverdraw
+    //
+    //  splits vertex cache ordered indices into clusters wherever the
+    //  simulated cache is cold, or where cutting costs less than the
+    //  threshold (1.05 allows acmr to rise by 5%). the clusters are then
+    //  sorted so that outward facing geometry, which is most likely to
+    //  occlude the rest of the mesh, is drawn first
+    //
+    static void optimizeOverdraw
+            (std::vector<uint32_t>     &indices,
+             const std::vector<Vertex> &vertices,
+             float                      threshold = 1.05f);
+    
+    //
+    //  analyzeOverdraw
+    //
+    //  rasterizes the mesh orthographically from evenly spread
+    //  directions with back face culling and early depth testing
+    //
+    static OverdrawStats analyzeOverdraw
+            (const std::vector<Vertex>   &vertices,
+             const std::vector<uint32_t> &indices,
+             uint32_t                     views      = 8,
+             uint32_t                     resolution = 256);
+    
+    //
+    //  optimizeVertexFetch
+    //
+    //  renumbers the vertices into the order the indices first
+    //  use them, so fetches walk forwards through the buffer.
+    //  unreferenced vertices are dropped. the remap is applied
+    //  to packed too when present, and the table (old to new,
+    //  ~0u for dropped) is returned. triangle order is untouched
+    //  so run it last, and per mesh before MeshIO::merge so each
+    //  object keeps a contiguous vertex range
+    //
+    static std::vector<uint32_t> optimizeVertexFetch
+            (std::vector<uint32_t>     &indices,
+             std::vector<Vertex>       &vertices,
+             std::vector<PackedVertex> *packed = nullptr);
+    
+    //
+    //  analyzeVertexFetch
+    //
+    //  runs the index buffer through a small fifo cache of
+    //  64 byte lines over a vertex buffer with the given stride
+    //
+    static VertexFetchStats analyzeVertexFetch
+            (const uint32_t* indices,
+             size_t          count,
+             size_t          vertexCount,
+             size_t          vertexSize,
+             size_t          cacheBytes = 16 * 1024);
+    
+    //
+    //  simplify
+    //
+    //  reduces a mesh towards targetIndexCount by collapsing edges in
+    //  order of quadric error (garland & heckbert) plus a weighted
+    //  difference in normal, colour and uvs, stopping early rather
+    //  than exceeding targetError. vertices on open borders or uv/normal
+    //  seams never move. the output indexes the original vertex array,
+    //  so every level can share one vertex buffer. returns the error
+    //  reached as a fraction of the bounding sphere radius
+    //
+    static float simplify
+            (const std::vector<Vertex>   &vertices,
+             const std::vector<uint32_t> &indices,
+             size_t                       targetIndexCount,
+             float                        targetError,
+             std::vector<uint32_t>       &output,
+             float                        attributeWeight = 0.1f);
+    
+    //
+    //  generateLevels
+    //
+    //  fills the asset's lod chain, simplifying the full mesh to each
+    //  ratio in turn and cache optimising the result. the chain stops
+    //  at the first level that can not get meaningfully smaller within
+    //  maxError
+    //
+    static void generateLevels
+            (MeshAsset                &asset,
+             const std::vector<float> &ratios,
+             float                     maxError);
+    
+    //
+    //  buildMeshlets
+    //
+    //  splits the asset's indices, in their current order, into
+    //  meshlets no larger than Meshlet::maxVertices/maxTriangles and
+    //  computes each one's bounding sphere and normal cone. run it
+    //  after the vertex cache pass so the clusters come out compact
+    //
+    static void buildMeshlets (MeshAsset& asset);
+    
+    //
+    //  makeProgressive
+    //
+    //  renumbers the vertices so the coarsest level uses only the
+    //  first few, each finer level adds a run after them and the
+    //  full mesh the rest, recording each level's vertex count.
+    //  within a run vertices stay in first use order. the asset
+    //  needs a lod chain, returns false and leaves it alone when
+    //  it has none
+    //
+    static bool makeProgressive (MeshAsset& asset);
+    
+    //
+    //  meshletBackfacing
+    //
+    //  true when every triangle of the meshlet faces away from
+    //  an eye at the given model space position
+    //
+    static bool meshletBackfacing (const Meshlet& meshlet, const glm::vec3& eye);
+    
+    //
+    //  optimize
+    //
+    //  runs the load time conditioning passes over an asset
+    //
+    static void optimize (MeshAsset& asset, const MeshOptimizeOptions& options = MeshOptimizeOptions());
+    
+    //
+    //  fingerprint
+    //
+    //  hash of the pipeline version and every option that changes
+    //  what optimize produces, half of a cache key
+    //
+    static uint64_t fingerprint (const MeshOptimizeOptions& options);
+    
+    //
+    //  mapOptimizedMeshFile
+    //
+    //  maps the optimized form of the .mesh at the given path out of
+    //  the cache, keyed by the checksum of its bytes and the options'
+    //  fingerprint. on a miss, or when the entry fails its checksums,
+    //  the mesh is optimized and published to the cache first. falls
+    //  back on the original if the cache can not be written
+    //
+    static bool mapOptimizedMeshFile (const char* path, MeshView& view, const MeshCache& cache, const MeshOptimizeOptions& options = MeshOptimizeOptions());
+    
+    //
+    //  loadMesh
+    //
+    //  maps the .mesh at the given path on a pool worker, through
+    //  mapOptimizedMeshFile when given a cache, and hands the view
+    //  back through the future. a view with version 0 means the
+    //  file could not be loaded
+    //
+    static std::future<MeshView> loadMesh (TaskPool& pool, const std::string& path, const MeshCache* cache);
+    
+    //
+    //  openMeshStream
+    //
+    //  reads the header, bounds and lod chain of a progressive
+    //  .mesh and the vertices its coarsest level needs, sizing
+    //  the stream for the rest. any other file is read whole,
+    //  leaving the stream complete. returns false if the file is
+    //  missing, truncated or corrupt
+    //
+    static bool openMeshStream (const char* path, MeshStream& stream);
+    
+    //
+    //  refineMeshStream
+    //
+    //  reads the next finer level into the stream, the vertices
+    //  it adds and, for the full mesh, the indices. the vertex
+    //  checksum can only be checked once they have all arrived,
+    //  so a corrupt file is caught on the last step. returns
+    //  false on a failed read, leaving the stream as it was
+    //
+    static bool refineMeshStream (MeshStream& stream);
+    
+    //
+    //  loadMeshStream
+    //
+    //  opens the stream on a pool worker and hands back a view
+    //  of its coarsest level, as loadMesh does for whole files
+    //
+    static std::future<MeshView> loadMeshStream (TaskPool& pool, const std::string& path, MeshStream& stream);
+    
+    //
+    //  generateMesh
+    //
+    //  builds a procedural shape of exactly the given number of
+    //  triangles on a pool worker, in a view like any loaded file
+    //  but with no file behind it. version 0 again means failure,
+    //  here a budget the shape can not meet
+    //
+    static std::future<MeshView> generateMesh (TaskPool& pool, MeshGenerator::Shape shape, uint64_t triangles, uint32_t seed = 0);
+    
+    //
+    //  uses the method found in graphics gems to estimate a bounding
+    //  sphere radius for the given mesh, see Bounds::spheres
+    //
+    static float estimateBounds (const std::vector<Vertex>& vertices);
+    
+    //
+    //  returns the average of the vertex positions
+    //
+    static glm::vec3 centroid (const std::vector<Vertex>& vertices);
+    
+    //
+    //  colours the vertices with the given r g b colour
+    //
+    inline static void paint (std::vector<Vertex>& vertices, float r, float g, float b);
+
+    //
+    //  assigns each vertex to the given object id
+    //
+    inline static void assign (std::vector<Vertex>& vertices, uint32_t id);
+
+    //
+    //  assigns the vertices from first onwards to the given object id
+    //
+    inline static void assign (std::vector<Vertex>& vertices, uint32_t id, size_t first);
+        
+    //
+    //  merge
+    //
+    //  merges the second mesh into the first for batching purposes.
+    //  the second mesh's vertices are appended as one block, so meshes
+    //  run through optimizeVertexFetch beforehand stay in fetch order
+    //  and each object keeps a contiguous range
+    //
+    static void merge
+            (std::vector<Vertex>         &aVertices,
+             std::vector<uint32_t>       &aIndices,
+             const std::vector<Vertex>   &bVertices,
+             const std::vector<uint32_t> &bIndices);
+
+    //
+    //  merges a mesh held in (possibly mapped) memory into the first
+    //
+    static void merge
+            (std::vector<Vertex>         &aVertices,
+             std::vector<uint32_t>       &aIndices,
+             const MeshSpan<Vertex>      &bVertices,
+             const MeshSpan<uint32_t>    &bIndices);
+    
+    static void merge
+            (std::vector<Vertex>         &aVertices,
+             std::vector<uint32_t>       &aIndices,
+             const MeshSpan<Vertex>      &bVertices,
+             const MeshSpan<uint16_t>    &bIndices);
+    
+    //
+    //  merges a whole batch onto the back of the first mesh. the
+    //  final sizes are known up front so the arrays grow once, and
+    //  the copy, id stamping and index rebasing are split across
+    //  threads in one pass
+    //
+    static void merge
+            (std::vector<Vertex>         &aVertices,
+             std::vector<uint32_t>       &aIndices,
+             std::vector<MeshBatchItem>  &items);
+    
+    //
+    //  splitStreams
+    //
+    //  separates interleaved vertices into a tightly packed
+    //  position stream, carrying the object id, and a stream of
+    //  the remaining attributes, for binding as two buffers
+    //
+    static void splitStreams
+            (const Vertex*                  vertices,
+             size_t                         count,
+             std::vector<VertexPosition>   &positions,
+             std::vector<VertexAttributes> &attributes);
+    
+    //
+    //  narrowIndices
+    //
+    //  appends indices rebased against base to a 16 bit list,
+    //  returning false and leaving the output alone if any of
+    //  them fall outside 0 - 65,535 from base
+    //
+    static bool narrowIndices
+            (const uint32_t*        indices,
+             size_t                 count,
+             uint32_t               base,
+             std::vector<uint16_t> &output);
+        
+    //
+    //  atlas
+    //
+    //  takes a batched scene and assignes atlased texture coordinates
+    //  to each object in the scene for a given number of objects and
+    //  square atlas resolution
+    //
+    static void atlas (std::vector<Vertex>& vertices, uint32_t n, float w);
+    static void atlas (Vertex* vertices, size_t count, uint32_t n, float w);
+
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshIO Implementation
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+void MeshIO::readMeshFile (const char* path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    { // MeshIO :: readMeshFile
+    
+    MeshAsset asset;
+    
+    // both file versions go through the same reader, we
+    // just skip over anything other than the geometry
+    if (!readMeshAsset(path, asset, MeshFormat::bit(MeshFormat::eVertices) | MeshFormat::bit(MeshFormat::eIndices)))
+        {
+        vertices.clear();
+        indices.clear();
+        return;
+        }
+    
+    vertices.swap(asset.vertices);
+    indices.swap(asset.indices);
+    
+    } // MeshIO :: readMeshFile
+
+bool MeshIO::mapMeshFile (const char* path, MeshView& view, MappedFile::Access access)
+    { // MeshIO :: mapMeshFile
+    
+    view.vertices  = { };
+    view.indices   = { };
+    view.indices16 = { };
+    view.sections  = { };
+    view.packed     = { };
+    view.lods         = { };
+    view.lodIndices   = { };
+    view.lodIndices16 = { };
+    view.meshlets         = { };
+    view.meshletVertices  = { };
+    view.meshletTriangles = { };
+    std::vector<uint8_t>().swap(view.decoded);
+    view.hasBounds  = false;
+    view.version    = 0;
+    view.indexFlags = 0;
+    view.source     = 0;
+    
+    if (!view.file.open(path, access))
+        return false;
+    
+    const uint8_t* bytes = view.file.data;
+    const size_t   size  = view.file.size;
+    
+    MeshFormat::Header header = { };
+    if (size >= sizeof(header))
+        memcpy(&header, bytes, sizeof(header));
+    
+    if (header.magic == MeshFormat::magic && header.version >= MeshFormat::version)
+        { // v2 container
+        
+        const size_t tableSize = (size_t)header.sectionCount * sizeof(MeshFormat::SectionEntry);
+        if (header.headerSize < sizeof(header) || (uint64_t)header.headerSize + tableSize > size || header.sectionSize != sizeof(MeshFormat::SectionEntry))
+            { view.file.close(); return false; }
+        
+        // the table sits directly after the header which keeps
+        // it 8 byte aligned in the mapping, unless a writer padded
+        // the header to something else
+        if (!pointSpan(view.sections, bytes + header.headerSize, header.sectionCount))
+            { view.file.close(); return false; }
+        
+        // every section has to lie within the file, a raw one has
+        // to hold exactly the elements it claims and a compressed
+        // one no more than its bytes can decode to, as in
+        // readMeshAsset, before anything is allocated or pointed at
+        for (const MeshFormat::SectionEntry& section : view.sections)
+            {
+            const uint64_t length   = (uint64_t)section.count * section.stride;
+            const bool     outside  = section.offset > size || section.size > size - section.offset;
+            const bool     mismatch = (section.flags & MeshFormat::eCompressed) ? length > section.size * MeshCodec::maxRatio : length != section.size;
+            
+            if (outside || mismatch)
+                { view.file.close(); return false; }
+            }
+        
+        // compressed sections share one allocation, each
+        // starting on an aligned boundary within it
+        uint64_t decodedSize = 0;
+        for (const MeshFormat::SectionEntry& section : view.sections)
+            if (section.flags & MeshFormat::eCompressed)
+                decodedSize += ((uint64_t)section.count * section.stride + MeshFormat::alignment - 1) & ~(uint64_t)(MeshFormat::alignment - 1);
+        
+        view.decoded.resize((size_t)decodedSize);
+        uint64_t decodedCursor = 0;
+        
+        for (const MeshFormat::SectionEntry& section : view.sections)
+            { // for each section
+            
+            const uint8_t* payload = bytes + section.offset;
+            
+            if (section.flags & MeshFormat::eCompressed)
+                {
+                uint8_t*     destination = view.decoded.data() + decodedCursor;
+                const size_t length      = (size_t)section.count * section.stride;
+                
+                if (!MeshCodec::decode(payload, (size_t)section.size, destination, length))
+                    { view.file.close(); return false; }
+                
+                payload        = destination;
+                decodedCursor += (length + MeshFormat::alignment - 1) & ~(uint64_t)(MeshFormat::alignment - 1);
+                }
+            
+            if (section.type == MeshFormat::eVertices && section.stride == sizeof(Vertex))
+                if (!pointSpan(view.vertices, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eIndices && section.stride == sizeof(uint32_t))
+                {
+                if (!pointSpan(view.indices, payload, section.count)) { view.file.close(); return false; }
+                view.indexFlags = section.flags & ~MeshFormat::eCompressed;
+                }
+            
+            if (section.type == MeshFormat::eIndices && section.stride == sizeof(uint16_t))
+                {
+                if (!pointSpan(view.indices16, payload, section.count)) { view.file.close(); return false; }
+                view.indexFlags = section.flags & ~MeshFormat::eCompressed;
+                }
+            
+            if (section.type == MeshFormat::eBounds && section.size == sizeof(MeshBounds))
+                {
+                memcpy(&view.bounds, payload, sizeof(MeshBounds));
+                view.hasBounds = true;
+                }
+            
+            if (section.type == MeshFormat::ePackedVertices && section.stride == sizeof(PackedVertex))
+                if (!pointSpan(view.packed, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eQuantization && section.size == sizeof(MeshQuantization))
+                memcpy(&view.quantization, payload, sizeof(MeshQuantization));
+            
+            if (section.type == MeshFormat::eLODs && section.stride == sizeof(MeshLOD))
+                if (!pointSpan(view.lods, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eLODIndices && section.stride == sizeof(uint32_t))
+                if (!pointSpan(view.lodIndices, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eLODIndices && section.stride == sizeof(uint16_t))
+                if (!pointSpan(view.lodIndices16, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eMeshlets && section.stride == sizeof(Meshlet))
+                if (!pointSpan(view.meshlets, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eMeshletVertices && section.stride == sizeof(uint32_t))
+                if (!pointSpan(view.meshletVertices, payload, section.count)) { view.file.close(); return false; }
+            
+            if (section.type == MeshFormat::eMeshletTriangles && section.stride == sizeof(uint8_t))
+                view.meshletTriangles = { payload, section.count };
+            
+            } // for each section
+        
+        view.version = header.version;
+        view.source  = header.source;
+        return true;
+        
+        } // v2 container
+    
+    // otherwise we expect the v1 layout, two counts followed
+    // by the raw vertex and index blobs
+    if (size < sizeof(uint32_t) * 2)
+        { view.file.close(); return false; }
+    
+    uint32_t v; memcpy(&v, bytes, sizeof(uint32_t));
+    uint32_t f; memcpy(&f, bytes + sizeof(uint32_t), sizeof(uint32_t));
+    
+    const size_t vOffset = sizeof(uint32_t) * 2;
+    const size_t fOffset = vOffset + sizeof(Vertex) * (size_t)v;
+    
+    if (fOffset + sizeof(uint32_t) * (size_t)f > size)
+        { view.file.close(); return false; }
+    
+    // both sections sit on 4 byte boundaries in the file and the
+    // mapping itself is page aligned, so we can point straight at them
+    view.vertices = { reinterpret_cast<const Vertex*>  (bytes + vOffset), v };
+    view.indices  = { reinterpret_cast<const uint32_t*>(bytes + fOffset), f };
+    view.version  = 1;
+    
+    return true;
+    
+    } // MeshIO :: mapMeshFile
+
+void MeshIO::writeMeshFile (const char* path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+    { // MeshIO :: writeMeshFile
+    
+    MeshAsset asset;
+        asset.vertices = vertices;
+        asset.indices  = indices;
+    
+    writeMeshAsset(path, asset);
+        
+    } // MeshIO :: writeMeshFile
+
+bool MeshIO::readMeshAsset (const char* path, MeshAsset& asset, uint32_t sections, bool verify)
+    { // MeshIO :: readMeshAsset
+    
+    std::ifstream input (path, std::ios::binary | std::ios::ate);
+    if (!input.is_open())
+        return false;
+    
+    const uint64_t size = (uint64_t)input.tellg();
+    input.seekg(0);
+    
+    asset = MeshAsset();
+    
+    MeshFormat::Header header = { };
+    if (size >= sizeof(header))
+        input.read((char*)&header, sizeof(header));
+    
+    if (header.magic != MeshFormat::magic || header.version < MeshFormat::version)
+        { // v1 file
+        
+        input.seekg(0);
+        
+        // first we read in the sizes of our arrays and check
+        // they agree with the size of the file
+        uint32_t v = 0; input.read((char*)&v, sizeof(uint32_t));
+        uint32_t f = 0; input.read((char*)&f, sizeof(uint32_t));
+        
+        if (!input || sizeof(uint32_t) * 2 + sizeof(Vertex) * (uint64_t)v + sizeof(uint32_t) * (uint64_t)f > size)
+            return false;
+        
+        // then we pull in the geometry data
+        if (sections & MeshFormat::bit(MeshFormat::eVertices))
+            {
+            asset.vertices.resize(v);
+            input.read((char*)asset.vertices.data(), sizeof(Vertex) * v);
+            }
+        else input.seekg(sizeof(Vertex) * (uint64_t)v, std::ios::cur);
+        
+        if (sections & MeshFormat::bit(MeshFormat::eIndices))
+            {
+            asset.indices.resize(f);
+            input.read((char*)asset.indices.data(), sizeof(uint32_t) * f);
+            }
+        
+        return (bool)input;
+        
+        } // v1 file
+    
+    if (header.sectionSize != sizeof(MeshFormat::SectionEntry))
+        return false;
+    
+    asset.source = header.source;
+    
+    std::vector<MeshFormat::SectionEntry> table (header.sectionCount);
+    input.seekg(header.headerSize);
+    input.read((char*)table.data(), sizeof(MeshFormat::SectionEntry) * table.size());
+    
+    if (!input)
+        return false;
+    
+    for (const MeshFormat::SectionEntry& section : table)
+        { // for each section
+        
+        if (section.type >= 32 || !(sections & MeshFormat::bit((MeshFormat::Section)section.type)))
+            continue;
+        
+        if (section.offset > size || section.size > size - section.offset)
+            return false;
+        
+        // a raw section holds exactly the elements it claims, and a
+        // compressed one no more than its bytes can decode to, which
+        // keeps what we allocate for either in proportion to the file
+        const uint64_t length     = (uint64_t)section.count * section.stride;
+        const bool     compressed = (section.flags & MeshFormat::eCompressed) != 0;
+        
+        if (compressed ? length > section.size * MeshCodec::maxRatio : length != section.size)
+            return false;
+        
+        void* destination = nullptr;
+        
+        // 16 bit indices are widened after the read, so they
+        // land in a scratch buffer first
+        std::vector<uint16_t>  narrow;
+        std::vector<uint32_t>* widen = nullptr;
+        
+        if (section.type == MeshFormat::eVertices && section.stride == sizeof(Vertex))
+            {
+            asset.vertices.resize(section.count);
+            destination = asset.vertices.data();
+            }
+        
+        if (section.type == MeshFormat::eIndices && section.stride == sizeof(uint32_t))
+            {
+            asset.indices.resize(section.count);
+            asset.indexFlags = section.flags & ~MeshFormat::eCompressed;
+            destination = asset.indices.data();
+            }
+        
+        if (section.type == MeshFormat::eIndices && section.stride == sizeof(uint16_t))
+            {
+            narrow.resize(section.count);
+            asset.indexFlags = section.flags & ~MeshFormat::eCompressed;
+            destination = narrow.data();
+            widen = &asset.indices;
+            }
+        
+        if (section.type == MeshFormat::eLODs && section.stride == sizeof(MeshLOD))
+            {
+            asset.lods.resize(section.count);
+            destination = asset.lods.data();
+            }
+        
+        if (section.type == MeshFormat::eLODIndices && section.stride == sizeof(uint32_t))
+            {
+            asset.lodIndices.resize(section.count);
+            destination = asset.lodIndices.data();
+            }
+        
+        if (section.type == MeshFormat::eLODIndices && section.stride == sizeof(uint16_t))
+            {
+            narrow.resize(section.count);
+            destination = narrow.data();
+            widen = &asset.lodIndices;
+            }
+        
+        if (section.type == MeshFormat::eMeshlets && section.stride == sizeof(Meshlet))
+            {
+            asset.meshlets.resize(section.count);
+            destination = asset.meshlets.data();
+            }
+        
+        if (section.type == MeshFormat::eMeshletVertices && section.stride == sizeof(uint32_t))
+            {
+            asset.meshletVertices.resize(section.count);
+            destination = asset.meshletVertices.data();
+            }
+        
+        if (section.type == MeshFormat::eMeshletTriangles && section.stride == sizeof(uint8_t))
+            {
+            asset.meshletTriangles.resize(section.count);
+            destination = asset.meshletTriangles.data();
+            }
+        
+        if (section.type == MeshFormat::eBounds && section.size == sizeof(MeshBounds))
+            {
+            asset.hasBounds = true;
+            destination = &asset.bounds;
+            }
+        
+        if (section.type == MeshFormat::ePackedVertices && section.stride == sizeof(PackedVertex))
+            {
+            asset.packed.resize(section.count);
+            destination = asset.packed.data();
+            }
+        
+        if (section.type == MeshFormat::eQuantization && section.size == sizeof(MeshQuantization))
+            destination = &asset.quantization;
+        
+        // sections we do not understand are skipped, which lets
+        // newer writers add to the table without breaking us
+        if (destination == nullptr)
+            continue;
+        
+        input.seekg(section.offset);
+        
+        if (compressed)
+            { // compressed section
+            
+            // the encoded bytes are hashed as they stream
+            // past, so only a window of them is ever held
+            MeshChecksum hash;
+            uint64_t     remaining = section.size;
+            
+            bool decoded = MeshCodec::decode([&] (void* buffer, size_t max) -> size_t
+                {
+                input.read((char*)buffer, (std::streamsize)std::min<uint64_t>(max, remaining));
+                
+                const size_t got = (size_t)input.gcount();
+                hash.add(buffer, got);
+                remaining -= got;
+                
+                return got;
+                }, destination, (size_t)length);
+            
+            if (!decoded || remaining != 0)
+                return false;
+            
+            if (verify && hash.value() != section.checksum)
+                return false;
+            
+            } // compressed section
+        else
+            { // raw section
+            
+            input.read((char*)destination, section.size);
+            
+            if (!input)
+                return false;
+            
+            if (verify && checksum(destination, section.size) != section.checksum)
+                return false;
+            
+            } // raw section
+        
+        if (widen != nullptr)
+            widen->assign(narrow.begin(), narrow.end());
+        
+        } // for each section
+    
+    return true;
+    
+    } // MeshIO :: readMeshAsset
+
+bool MeshIO::writeMeshAsset (const char* path, const MeshAsset& asset, bool compress)
+    { // MeshIO :: writeMeshAsset
+    
+    MeshBounds bounds = asset.hasBounds ?
+        asset.bounds :
+        computeBounds(asset.vertices.data(), asset.vertices.size());
+    
+    struct Payload
+        {
+        MeshFormat::Section type;
+        const void*         data;
+        uint32_t            count;
+        uint32_t            stride;
+        uint32_t            flags;
+        };
+    
+    // indices are stored at 16 bits whenever they all fit,
+    // which is the case for any mesh under 65,536 vertices
+    std::vector<uint16_t> narrow;
+    bool small = narrowIndices(asset.indices.data(), asset.indices.size(), 0, narrow);
+    
+    std::vector<Payload> payloads =
+        {
+        { MeshFormat::eVertices, asset.vertices.data(), (uint32_t)asset.vertices.size(), sizeof(Vertex),     0                },
+        { MeshFormat::eIndices,  asset.indices.data(),  (uint32_t)asset.indices.size(),  sizeof(uint32_t),   asset.indexFlags },
+        { MeshFormat::eBounds,   &bounds,               1,                                sizeof(MeshBounds), 0                }
+        };
+    
+    if (small)
+        {
+        payloads[1].data   = narrow.data();
+        payloads[1].stride = sizeof(uint16_t);
+        }
+    
+    std::vector<uint16_t> narrowLevels;
+    bool smallLevels = narrowIndices(asset.lodIndices.data(), asset.lodIndices.size(), 0, narrowLevels);
+    
+    if (!asset.lods.empty())
+        {
+        payloads.push_back({ MeshFormat::eLODs,       asset.lods.data(),       (uint32_t)asset.lods.size(),       sizeof(MeshLOD),  0 });
+        payloads.push_back({ MeshFormat::eLODIndices, asset.lodIndices.data(), (uint32_t)asset.lodIndices.size(), sizeof(uint32_t), 0 });
+        
+        if (smallLevels)
+            {
+            payloads.back().data   = narrowLevels.data();
+            payloads.back().stride = sizeof(uint16_t);
+            }
+        }
+    
+    if (!asset.meshlets.empty())
+        {
+        payloads.push_back({ MeshFormat::eMeshlets,         asset.meshlets.data(),         (uint32_t)asset.meshlets.size(),         sizeof(Meshlet),  0 });
+        payloads.push_back({ MeshFormat::eMeshletVertices,  asset.meshletVertices.data(),  (uint32_t)asset.meshletVertices.size(),  sizeof(uint32_t), 0 });
+        payloads.push_back({ MeshFormat::eMeshletTriangles, asset.meshletTriangles.data(), (uint32_t)asset.meshletTriangles.size(), sizeof(uint8_t),  0 });
+        }
+    
+    if (!asset.packed.empty())
+        {
+        payloads.push_back({ MeshFormat::ePackedVertices, asset.packed.data(),   (uint32_t)asset.packed.size(), sizeof(PackedVertex),     0 });
+        payloads.push_back({ MeshFormat::eQuantization,   &asset.quantization,   1,                             sizeof(MeshQuantization), 0 });
+        }
+    
+    // a progressive file is read front to back a level at a
+    // time, so whatever the coarsest level needs goes ahead of
+    // the vertices, and the full indices after them
+    const bool progressive = (asset.indexFlags & MeshFormat::eProgressive) != 0;
+    
+    if (progressive)
+        {
+        auto rank = [] (const Payload& payload)
+            {
+            switch (payload.type)
+                {
+                case MeshFormat::eBounds:     return 0;
+                case MeshFormat::eLODs:       return 1;
+                case MeshFormat::eLODIndices: return 2;
+                case MeshFormat::eVertices:   return 3;
+                case MeshFormat::eIndices:    return 4;
+                default:                      return 5;
+                }
+            };
+        
+        std::stable_sort(payloads.begin(), payloads.end(), [&rank] (const Payload& a, const Payload& b) { return rank(a) < rank(b); });
+        }
+    
+    // the large arrays are swapped for their encoded form
+    // wherever that comes out smaller. indices are delta
+    // coded, everything else only split into byte planes.
+    // the sections a progressive file streams stay raw so
+    // any prefix of them can be read on its own
+    std::vector<std::vector<uint8_t>> encoded (payloads.size());
+    bool compressed = false;
+    
+    for (size_t i = 0; compress && i < payloads.size(); ++i)
+        { // for each section
+        
+        const MeshFormat::Section type = payloads[i].type;
+        
+        if (type != MeshFormat::eVertices && type != MeshFormat::ePackedVertices &&
+            type != MeshFormat::eIndices  && type != MeshFormat::eLODIndices)
+            continue;
+        
+        if (progressive && (type == MeshFormat::eVertices || type == MeshFormat::eIndices))
+            continue;
+        
+        const MeshCodec::Filter filter = (type == MeshFormat::eIndices || type == MeshFormat::eLODIndices) ?
+            MeshCodec::eDelta :
+            MeshCodec::eShuffle;
+        
+        encoded[i] = MeshCodec::encode(payloads[i].data, payloads[i].count, payloads[i].stride, filter);
+        
+        if (encoded[i].size() >= (uint64_t)payloads[i].count * payloads[i].stride)
+            {
+            encoded[i].clear();
+            continue;
+            }
+        
+        payloads[i].data   = encoded[i].data();
+        payloads[i].flags |= MeshFormat::eCompressed;
+        compressed = true;
+        
+        } // for each section
+    
+    // lay the sections out one after another behind the
+    // table, each starting on an aligned boundary
+    MeshFormat::Header header = { };
+        header.magic        = MeshFormat::magic;
+        header.version      = compressed ? MeshFormat::compressedVersion : MeshFormat::version;
+        header.sectionCount = (uint16_t)payloads.size();
+        header.headerSize   = sizeof(MeshFormat::Header);
+        header.sectionSize  = sizeof(MeshFormat::SectionEntry);
+        header.source       = asset.source;
+    
+    std::vector<MeshFormat::SectionEntry> table (payloads.size());
+    uint64_t cursor = sizeof(MeshFormat::Header) + sizeof(MeshFormat::SectionEntry) * table.size();
+    
+    for (size_t i = 0; i < payloads.size(); ++i)
+        { // for each section
+        
+        cursor = (cursor + MeshFormat::alignment - 1) & ~(uint64_t)(MeshFormat::alignment - 1);
+        
+        table[i]          = { };
+        table[i].type     = payloads[i].type;
+        table[i].flags    = payloads[i].flags;
+        table[i].offset   = cursor;
+        table[i].count    = payloads[i].count;
+        table[i].stride   = payloads[i].stride;
+        table[i].size     = (payloads[i].flags & MeshFormat::eCompressed) ?
+            encoded[i].size() :
+            (uint64_t)payloads[i].count * payloads[i].stride;
+        table[i].checksum = checksum(payloads[i].data, table[i].size);
+        
+        cursor += table[i].size;
+        
+        } // for each section
+    
+    header.fileSize = cursor;
+    
+    std::ofstream output (path, std::ios::binary);
+    if (!output.is_open())
+        return false;
+    
+    output.write((char*)&header, sizeof(header));
+    output.write((char*)table.data(), sizeof(MeshFormat::SectionEntry) * table.size());
+    
+    const char padding[MeshFormat::alignment] = { };
+    uint64_t written = sizeof(MeshFormat::Header) + sizeof(MeshFormat::SectionEntry) * table.size();
+    
+    for (size_t i = 0; i < payloads.size(); ++i)
+        { // for each section
+        output.write(padding, table[i].offset - written);
+        output.write((const char*)payloads[i].data, table[i].size);
+        written = table[i].offset + table[i].size;
+        } // for each section
+    
+    output.close();
+    
+    return (bool)output;
+    
+    } // MeshIO :: writeMeshAsset
+
+bool MeshIO::verify (const MeshView& view)
+    { // MeshIO :: verify
+    
+    for (const MeshFormat::SectionEntry& section : view.sections)
+        if (checksum(view.file.data + section.offset, section.size) != section.checksum)
+            return false;
+    
+    return true;
+    
+    } // MeshIO :: verify
+
+uint64_t MeshIO::checksum (const void* data, size_t size)
+    { // MeshIO :: checksum
+    
+    MeshChecksum hash;
+    hash.add(data, size);
+    
+    return hash.value();
+    
+    } // MeshIO :: checksum
+
+void MeshChecksum::add (const void* data, size_t count)
+    { // MeshChecksum :: add
+    
+    const uint64_t prime = 0x100000001B3ull;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    
+    // bytes left over from the last piece are topped up
+    // to a whole word first, so the result never depends
+    // on how the data was split
+    size_t pending = (size_t)(size % sizeof(uint64_t));
+    size += count;
+    
+    size_t i = 0;
+    if (pending)
+        {
+        size_t take = std::min(count, sizeof(uint64_t) - pending);
+        memcpy(tail + pending, bytes, take);
+        i = take;
+        
+        if (pending + take < sizeof(uint64_t))
+            return;
+        
+        uint64_t word; memcpy(&word, tail, sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+        }
+    
+    // mixing whole words keeps this close to memory speed
+    // on the multi megabyte vertex sections
+    for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t))
+        {
+        uint64_t word; memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+        }
+    
+    memcpy(tail, bytes + i, count - i);
+    
+    } // MeshChecksum :: add
+
+uint64_t MeshChecksum::value () const
+    { // MeshChecksum :: value
+    
+    const uint64_t prime = 0x100000001B3ull;
+    uint64_t       value = hash;
+    
+    for (size_t i = 0; i < (size_t)(size % sizeof(uint64_t)); ++i)
+        value = (value ^ tail[i]) * prime;
+    
+    return value ^ size;
+    
+    } // MeshChecksum :: value
+
+MeshBounds MeshIO::computeBounds (const Vertex* vertices, size_t count)
+    { // MeshIO :: computeBounds
+    
+    MeshBounds bounds;
+    if (count == 0)
+        return bounds;
+    
+    Bounds::Positions positions = Bounds::positions(vertices, count);
+    Bounds::Extents   extents   = Bounds::extents(positions);
+    Bounds::Sphere    sphere    = Bounds::tightest(Bounds::spheres(positions, extents));
+    
+    bounds.centroid = extents.centroid;
+    bounds.min      = extents.min;
+    bounds.max      = extents.max;
+    bounds.center   = sphere.center;
+    bounds.radius   = sphere.radius;
+    
+    return bounds;
+    
+    } // MeshIO :: computeBounds
+
+MeshQuantization MeshIO::quantize (const Vertex* vertices, size_t count, std::vector<PackedVertex>& packed)
+    { // MeshIO :: quantize
+    
+    MeshBounds bounds = computeBounds(vertices, count);
+    
+    // a flat axis would otherwise divide by zero, any scale
+    // works there since every vertex quantizes to 0
+    glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3(1e-6f));
+    
+    MeshQuantization quantization;
+        quantization.offset = glm::vec4(bounds.min, 0.0f);
+        quantization.scale  = glm::vec4(extent / 65535.0f, 0.0f);
+    
+    packed.resize(count);
+    
+    for (size_t v = 0; v < count; ++v)
+        { // for each vertex
+        
+        const Vertex& in  = vertices[v];
+        PackedVertex& out = packed[v];
+        
+        glm::vec3 p = glm::round(glm::clamp((in.position - bounds.min) / extent, 0.0f, 1.0f) * 65535.0f);
+        out.position[0] = (uint16_t)p.x;
+        out.position[1] = (uint16_t)p.y;
+        out.position[2] = (uint16_t)p.z;
+        out.position[3] = (uint16_t)in.id;
+        
+        // octahedral encoding, project onto the octahedron and
+        // fold the lower hemisphere over the upper one
+        glm::vec3 n = in.normal / std::max(std::abs(in.normal.x) + std::abs(in.normal.y) + std::abs(in.normal.z), 1e-20f);
+        glm::vec2 e = { n.x, n.y };
+        if (n.z < 0.0f)
+            e = { (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                  (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f) };
+        out.normal[0] = (int16_t)std::round(glm::clamp(e.x, -1.0f, 1.0f) * 32767.0f);
+        out.normal[1] = (int16_t)std::round(glm::clamp(e.y, -1.0f, 1.0f) * 32767.0f);
+        
+        glm::vec3 c = glm::round(glm::clamp(in.color, 0.0f, 1.0f) * 255.0f);
+        out.color[0] = (uint8_t)c.r;
+        out.color[1] = (uint8_t)c.g;
+        out.color[2] = (uint8_t)c.b;
+        out.color[3] = 255;
+        
+        out.uvs[0] = glm::packHalf1x16(in.uvs.x);
+        out.uvs[1] = glm::packHalf1x16(in.uvs.y);
+        
+        } // for each vertex
+    
+    return quantization;
+    
+    } // MeshIO :: quantize
+
+Vertex MeshIO::dequantize (const PackedVertex& vertex, const MeshQuantization& quantization)
+    { // MeshIO :: dequantize
+    
+    Vertex out;
+    
+    out.position = glm::vec3(quantization.offset) + glm::vec3(
+            vertex.position[0],
+            vertex.position[1],
+            vertex.position[2]) * glm::vec3(quantization.scale);
+    
+    glm::vec2 e = glm::clamp(glm::vec2(vertex.normal[0], vertex.normal[1]) / 32767.0f, -1.0f, 1.0f);
+    glm::vec3 n = { e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y) };
+    if (n.z < 0.0f)
+        {
+        float x = n.x;
+        n.x = (1.0f - std::abs(n.y)) * (x   >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::abs(x))   * (n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+    out.normal = glm::normalize(n);
+    
+    out.color = glm::vec3(vertex.color[0], vertex.color[1], vertex.color[2]) / 255.0f;
+    out.uvs   = { glm::unpackHalf1x16(vertex.uvs[0]), glm::unpackHalf1x16(vertex.uvs[1]) };
+    out.id    = vertex.position[3];
+    
+    return out;
+    
+    } // MeshIO :: dequantize
+
+QuantizationError MeshIO::quantizationError
+        (const Vertex*           vertices,
+         const PackedVertex*     packed,
+         size_t                  count,
+         const MeshQuantization& quantization)
+    { // MeshIO :: quantizationError
+    
+    QuantizationError error;
+    
+    for (size_t v = 0; v < count; ++v)
+        { // for each vertex
+        
+        Vertex decoded = dequantize(packed[v], quantization);
+        
+        float cosine = glm::dot(glm::normalize(vertices[v].normal), decoded.normal);
+        float angle  = glm::degrees(std::acos(glm::clamp(cosine, -1.0f, 1.0f)));
+        
+        glm::vec3 dc = glm::abs(vertices[v].color - decoded.color);
+        glm::vec2 du = glm::abs(vertices[v].uvs   - decoded.uvs);
+        
+        error.position = std::max(error.position, glm::length(vertices[v].position - decoded.position));
+        error.normal   = std::max(error.normal,   angle);
+        error.color    = std::max(error.color,    std::max(dc.r, std::max(dc.g, dc.b)));
+        error.uvs      = std::max(error.uvs,      std::max(du.x, du.y));
+        
+        } // for each vertex
+    
+    return error;
+    
+    } // MeshIO :: quantizationError
+
+WeldStats MeshIO::weld
+        (std::vector<uint32_t>     &indices,
+         std::vector<Vertex>       &vertices,
+         float                      epsilon,
+         std::vector<PackedVertex> *packed)
+    { // MeshIO :: weld
+    
+    WeldStats stats;
+        stats.verticesBefore  = vertices.size();
+        stats.trianglesBefore = indices.size() / 3;
+    
+    const size_t count = vertices.size();
+    const size_t grain = 1 << 16;
+    
+    // every attribute goes into the key as its raw bits, apart
+    // from positions and normals which are snapped when welding
+    // with an epsilon
+    struct Key
+        {
+        uint32_t words[12];
+        };
+    
+    static_assert(sizeof(Vertex) == sizeof(Key), "weld keys cover every attribute of a vertex");
+    
+    // keys are rebuilt when compared rather than stored, which
+    // saves a second copy of the vertex array on large inputs
+    auto makeKey = [&] (size_t v)
+        {
+        Key key;
+        memcpy(&key, &vertices[v], sizeof(Key));
+        
+        if (epsilon > 0.0f)
+            {
+            const float* position = &vertices[v].position.x;
+            const float* normal   = &vertices[v].normal.x;
+            for (int k = 0; k < 3; ++k)
+                {
+                key.words[0 + k] = (uint32_t)(int32_t)std::floor(position[k] / epsilon + 0.5f);
+                key.words[3 + k] = (uint32_t)(int32_t)std::floor(normal[k]   / epsilon + 0.5f);
+                }
+            }
+        
+        return key;
+        };
+    
+    std::vector<uint64_t> hashes (count);
+    
+    Parallel::forRange(count, grain, [&] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t v = begin; v < end; ++v)
+            {
+            Key key = makeKey(v);
+            hashes[v] = checksum(&key, sizeof(Key));
+            }
+        });
+    
+    // vertices are split into buckets by the top of their hash
+    // so each worker can dedupe its own bucket without locking
+    const uint32_t buckets = Parallel::workers(count, grain);
+    
+    std::vector<size_t> bucketStart (buckets + 1, 0);
+    for (size_t v = 0; v < count; ++v)
+        bucketStart[(hashes[v] >> 32) % buckets + 1]++;
+    for (uint32_t b = 0; b < buckets; ++b)
+        bucketStart[b + 1] += bucketStart[b];
+    
+    // listed in index order within each bucket, so the earliest
+    // duplicate is always the one that becomes canonical
+    std::vector<uint32_t> order  (count);
+    std::vector<size_t>   cursor (bucketStart.begin(), bucketStart.end() - 1);
+    for (size_t v = 0; v < count; ++v)
+        order[cursor[(hashes[v] >> 32) % buckets]++] = (uint32_t)v;
+    
+    std::vector<uint32_t> canonical (count);
+    
+    Parallel::forRange(buckets, 1, [&] (size_t first, size_t last, uint32_t)
+        { // for each bucket
+        
+        for (size_t bucket = first; bucket < last; ++bucket)
+            {
+            // open addressing at under half load
+            size_t capacity = 1;
+            while (capacity < (bucketStart[bucket + 1] - bucketStart[bucket]) * 2)
+                capacity <<= 1;
+            
+            // slots carry a tag from the hash so most mismatches
+            // are rejected without touching the vertices
+            struct Slot
+                {
+                uint32_t vertex;
+                uint32_t tag;
+                };
+            
+            const uint32_t empty = ~0u;
+            std::vector<Slot> table (capacity, Slot { empty, 0 });
+            
+            for (size_t o = bucketStart[bucket]; o < bucketStart[bucket + 1]; ++o)
+                { // for each vertex in the bucket
+                
+                uint32_t v   = order[o];
+                uint32_t tag = (uint32_t)(hashes[v] >> 32);
+                size_t   slot = (size_t)hashes[v] & (capacity - 1);
+                
+                Key key = makeKey(v);
+                
+                while (table[slot].vertex != empty)
+                    {
+                    if (table[slot].tag == tag)
+                        {
+                        Key other = makeKey(table[slot].vertex);
+                        if (memcmp(&other, &key, sizeof(Key)) == 0)
+                            break;
+                        }
+                    slot = (slot + 1) & (capacity - 1);
+                    }
+                
+                if (table[slot].vertex == empty)
+                    table[slot] = { v, tag };
+                
+                canonical[v] = table[slot].vertex;
+                
+                } // for each vertex in the bucket
+            }
+        
+        }); // for each bucket
+    
+    // compacting keeps the surviving vertices in their original order
+    std::vector<uint32_t> remap (count);
+    uint32_t next = 0;
+    
+    for (size_t v = 0; v < count; ++v)
+        {
+        if (canonical[v] == v)
+            {
+            vertices[next] = vertices[v];
+            if (packed != nullptr && packed->size() == count)
+                (*packed)[next] = (*packed)[v];
+            remap[v] = next++;
+            }
+        else remap[v] = remap[canonical[v]];
+        }
+    
+    vertices.resize(next);
+    if (packed != nullptr && packed->size() == count)
+        packed->resize(next);
+    
+    Parallel::forRange(indices.size(), grain, [&] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t i = begin; i < end; ++i)
+            indices[i] = remap[indices[i]];
+        });
+    
+    // snapping can fold a small triangle onto a line or point
+    if (epsilon > 0.0f)
+        {
+        size_t kept = 0;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+            {
+            uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+            if (a == b || b == c || a == c)
+                continue;
+            indices[kept++] = a;
+            indices[kept++] = b;
+            indices[kept++] = c;
+            }
+        indices.resize(kept);
+        }
+    
+    stats.verticesAfter  = vertices.size();
+    stats.trianglesAfter = indices.size() / 3;
+    stats.reduction      = stats.verticesBefore ? 1.0f - (float)stats.verticesAfter / (float)stats.verticesBefore : 0.0f;
+    
+    return stats;
+    
+    } // MeshIO :: weld
+
+void MeshIO::optimizeVertexCache (std::vector<uint32_t>& indices, size_t vertexCount)
+    { // MeshIO :: optimizeVertexCache
+    
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+    
+    // scoring parameters from the original write up, the cache
+    // being modelled is larger than the real one on purpose
+    const int32_t cacheSize         = 32;
+    const float   cacheDecayPower   = 1.5f;
+    const float   lastTriangleScore = 0.75f;
+    const float   valenceBoostScale = 2.0f;
+    const float   valenceBoostPower = 0.5f;
+    
+    // the scores only depend on cache position and remaining
+    // valence, so both are tabulated up front
+    float cacheScores[cacheSize];
+    for (int32_t i = 0; i < cacheSize; ++i)
+        {
+        if (i < 3) cacheScores[i] = lastTriangleScore;
+        else       cacheScores[i] = std::pow(1.0f - (float)(i - 3) / (float)(cacheSize - 3), cacheDecayPower);
+        }
+    
+    const uint32_t maxValence = 64;
+    float valenceScores[maxValence];
+    for (uint32_t i = 1; i < maxValence; ++i)
+        valenceScores[i] = valenceBoostScale * std::pow((float)i, -valenceBoostPower);
+    valenceScores[0] = 0.0f;
+    
+    // build vertex to triangle adjacency as a flat list
+    std::vector<uint32_t> valence (vertexCount, 0);
+    for (uint32_t index : indices)
+        valence[index]++;
+    
+    std::vector<uint32_t> adjacencyOffsets (vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+    
+    std::vector<uint32_t> adjacency (indices.size());
+    std::vector<uint32_t> cursor (adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (size_t k = 0; k < 3; ++k)
+            adjacency[cursor[indices[t * 3 + k]]++] = (uint32_t)t;
+    
+    // live state, remaining valence counts down as
+    // triangles using the vertex are emitted
+    std::vector<int32_t> cachePosition (vertexCount, -1);
+    std::vector<float>   vertexScore   (vertexCount, 0.0f);
+    std::vector<float>   triangleScore (triangleCount, 0.0f);
+    std::vector<uint8_t> emitted       (triangleCount, 0);
+    
+    auto score = [&] (uint32_t v)
+        {
+        uint32_t remaining = valence[v];
+        if (remaining == 0)
+            return -1.0f;
+        float result = cachePosition[v] >= 0 ? cacheScores[cachePosition[v]] : 0.0f;
+        return result + valenceScores[std::min(remaining, maxValence - 1)];
+        };
+    
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = score((uint32_t)v);
+    
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] =
+            vertexScore[indices[t * 3 + 0]] +
+            vertexScore[indices[t * 3 + 1]] +
+            vertexScore[indices[t * 3 + 2]];
+    
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next;
+    cache.reserve(cacheSize + 3);
+    next.reserve(cacheSize + 3);
+    
+    size_t scan = 0;
+    int64_t best = -1;
+    
+    while (output.size() < indices.size())
+        { // while triangles remain
+        
+        // when nothing in the cache has anything left to give
+        // we fall back to the highest scoring remaining triangle
+        if (best < 0)
+            {
+            float bestScore = -1.0f;
+            for (size_t t = scan; t < triangleCount; ++t)
+                if (!emitted[t] && triangleScore[t] > bestScore)
+                    { bestScore = triangleScore[t]; best = (int64_t)t; }
+            while (scan < triangleCount && emitted[scan])
+                ++scan;
+            }
+        
+        const uint32_t* triangle = &indices[(size_t)best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[(size_t)best] = 1;
+        
+        // the emitted triangle's vertices move to the front of the
+        // cache and lose a use, the rest shuffle down behind them
+        next.clear();
+        for (size_t k = 0; k < 3; ++k)
+            {
+            uint32_t v = triangle[k];
+            next.push_back(v);
+            
+            uint32_t* first = &adjacency[adjacencyOffsets[v]];
+            uint32_t* last  = first + valence[v];
+            *std::find(first, last, (uint32_t)best) = *(last - 1);
+            valence[v]--;
+            }
+        for (uint32_t v : cache)
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                next.push_back(v);
+        
+        for (size_t i = 0; i < next.size(); ++i)
+            cachePosition[next[i]] = i < (size_t)cacheSize ? (int32_t)i : -1;
+        
+        // rescore everything that moved and the triangles around
+        // it, remembering the best candidate as we go
+        best = -1;
+        float bestScore = -1.0f;
+        
+        for (uint32_t v : next)
+            vertexScore[v] = score(v);
+        
+        for (uint32_t v : next)
+            for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + valence[v]; ++a)
+                {
+                uint32_t t = adjacency[a];
+                triangleScore[t] =
+                    vertexScore[indices[t * 3 + 0]] +
+                    vertexScore[indices[t * 3 + 1]] +
+                    vertexScore[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore)
+                    { bestScore = triangleScore[t]; best = t; }
+                }
+        
+        if (next.size() > (size_t)cacheSize)
+            next.resize(cacheSize);
+        cache.swap(next);
+        
+        } // while triangles remain
+    
+    indices.swap(output);
+    
+    } // MeshIO :: optimizeVertexCache
+
+VertexCacheStats MeshIO::analyzeVertexCache
+        (const uint32_t* indices,
+         size_t          count,
+         size_t          vertexCount,
+         uint32_t        cacheSize,
+         bool            fifo)
+    { // MeshIO :: analyzeVertexCache
+    
+    VertexCacheStats stats;
+    if (count < 3 || cacheSize == 0)
+        return stats;
+    
+    std::vector<uint8_t> used (vertexCount, 0);
+    
+    uint64_t misses = 0;
+    size_t   unique = 0;
+    
+    // for fifo each vertex only needs to remember when it was
+    // inserted, it is a hit while fewer than cacheSize other
+    // insertions have happened since
+    std::vector<uint64_t> stamp;
+    uint64_t clock = cacheSize + 1;
+    
+    // lru hits reorder the cache, so we keep it explicitly
+    // with the most recently used vertex at the front
+    std::vector<uint32_t> lru;
+    
+    if (fifo) stamp.assign(vertexCount, 0);
+    else      lru.reserve(cacheSize + 1);
+    
+    for (size_t i = 0; i < count; ++i)
+        { // for each index
+        
+        uint32_t v = indices[i];
+        
+        if (!used[v]) { used[v] = 1; unique++; }
+        
+        if (fifo)
+            {
+            if (clock - stamp[v] > cacheSize)
+                {
+                misses++;
+                stamp[v] = clock++;
+                }
+            continue;
+            }
+        
+        std::vector<uint32_t>::iterator hit = std::find(lru.begin(), lru.end(), v);
+        if (hit == lru.end())
+            {
+            misses++;
+            lru.insert(lru.begin(), v);
+            if (lru.size() > cacheSize)
+                lru.pop_back();
+            }
+        else std::rotate(lru.begin(), hit, hit + 1);
+        
+        } // for each index
+    
+    stats.acmr = (float)misses / (float)(count / 3);
+    stats.atvr = unique ? (float)misses / (float)unique : 0.0f;
+    
+    return stats;
+    
+    } // MeshIO :: analyzeVertexCache
+
+void MeshIO::optimizeOverdraw
+        (std::vector<uint32_t>     &indices,
+         const std::vector<Vertex> &vertices,
+         float                      threshold)
+    { // MeshIO :: optimizeOverdraw
+    
+    const size_t   triangleCount = indices.size() / 3;
+    const uint32_t cacheSize     = 16;
+    
+    if (triangleCount == 0)
+        return;
+    
+    // walk the triangles through a fifo cache, recording how
+    // many vertices each one had to transform
+    std::vector<uint8_t>  misses (triangleCount, 0);
+    std::vector<uint64_t> stamp  (vertices.size(), 0);
+    uint64_t clock = cacheSize + 1;
+    
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (size_t k = 0; k < 3; ++k)
+            {
+            uint32_t v = indices[t * 3 + k];
+            if (clock - stamp[v] > cacheSize)
+                {
+                misses[t]++;
+                stamp[v] = clock++;
+                }
+            }
+    
+    // hard boundaries sit where the cache was completely cold, so
+    // moving those runs around costs nothing extra
+    std::vector<size_t> hard;
+    for (size_t t = 0; t < triangleCount; ++t)
+        if (t == 0 || misses[t] == 3)
+            hard.push_back(t);
+    hard.push_back(triangleCount);
+    
+    // soft boundaries split the hard runs further wherever the run
+    // so far is already no worse than threshold times the whole run
+    std::vector<size_t> clusters;
+    const size_t minimumCluster = 64;
+    
+    for (size_t h = 0; h + 1 < hard.size(); ++h)
+        { // for each hard run
+        
+        size_t first = hard[h];
+        size_t last  = hard[h + 1];
+        
+        uint32_t runMisses = 0;
+        for (size_t t = first; t < last; ++t)
+            runMisses += misses[t];
+        
+        float target = threshold * (float)runMisses / (float)(last - first);
+        
+        clusters.push_back(first);
+        
+        uint32_t clusterMisses = 0;
+        size_t   clusterStart  = first;
+        
+        for (size_t t = first; t < last; ++t)
+            {
+            clusterMisses += misses[t];
+            size_t length = t + 1 - clusterStart;
+            
+            if (length >= minimumCluster && t + 1 < last && (float)clusterMisses / (float)length <= target)
+                {
+                clusters.push_back(t + 1);
+                clusterStart  = t + 1;
+                clusterMisses = 0;
+                }
+            }
+        
+        } // for each hard run
+    
+    clusters.push_back(triangleCount);
+    
+    glm::vec3 meshCentroid = centroid(vertices);
+    
+    // score each cluster by how far it faces away from the centre
+    // of the mesh, using its area weighted centroid and normal
+    struct Cluster
+        {
+        size_t first;
+        size_t last;
+        float  score;
+        };
+    
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size() - 1);
+    
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+        { // for each cluster
+        
+        glm::vec3 center = { 0.0f, 0.0f, 0.0f };
+        glm::vec3 normal = { 0.0f, 0.0f, 0.0f };
+        float     area   = 0.0f;
+        
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+            {
+            const glm::vec3& a = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+            
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float     w = glm::length(n) * 0.5f;
+            
+            center += (a + b + d) * (w / 3.0f);
+            normal += n;
+            area   += w;
+            }
+        
+        float score = 0.0f;
+        if (area > 0.0f && glm::length(normal) > 0.0f)
+            score = glm::dot(center / area - meshCentroid, glm::normalize(normal));
+        
+        sorted.push_back({ clusters[c], clusters[c + 1], score });
+        
+        } // for each cluster
+    
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [] (const Cluster& a, const Cluster& b) { return a.score > b.score; });
+    
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    
+    for (const Cluster& cluster : sorted)
+        output.insert(output.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.last * 3);
+    
+    indices.swap(output);
+    
+    } // MeshIO :: optimizeOverdraw
+
+OverdrawStats MeshIO::analyzeOverdraw
+        (const std::vector<Vertex>   &vertices,
+         const std::vector<uint32_t> &indices,
+         uint32_t                     views,
+         uint32_t                     resolution)
+    { // MeshIO :: analyzeOverdraw
+    
+    OverdrawStats stats;
+    if (vertices.empty() || indices.size() < 3 || resolution == 0)
+        return stats;
+    
+    MeshBounds bounds = computeBounds(vertices.data(), vertices.size());
+    float      scale  = (float)resolution * 0.5f / std::max(bounds.radius, 1e-6f);
+    
+    std::vector<float>     depth    (resolution * resolution);
+    std::vector<glm::vec3> projected(vertices.size());
+    
+    for (uint32_t view = 0; view < views; ++view)
+        { // for each viewpoint
+        
+        // spread the view directions over the sphere with a
+        // fibonacci spiral so every side gets looked at
+        float y     = 1.0f - 2.0f * ((float)view + 0.5f) / (float)views;
+        float ring  = std::sqrt(std::max(0.0f, 1.0f - y * y));
+        float angle = 2.39996323f * (float)view;
+        
+        glm::vec3 forward = { std::cos(angle) * ring, y, std::sin(angle) * ring };
+        glm::vec3 helper  = std::abs(forward.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 right   = glm::normalize(glm::cross(helper, forward));
+        glm::vec3 up      = glm::cross(right, forward); // left handed, z into the screen
+        
+        for (size_t v = 0; v < vertices.size(); ++v)
+            {
+            glm::vec3 p = vertices[v].position - bounds.center;
+            projected[v] = {
+                (glm::dot(p, right) * scale) + resolution * 0.5f,
+                (glm::dot(p, up)    * scale) + resolution * 0.5f,
+                 glm::dot(p, forward) };
+            }
+        
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+        
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+            { // for each triangle
+            
+            const glm::vec3& a = projected[indices[t + 0]];
+            const glm::vec3& b = projected[indices[t + 1]];
+            const glm::vec3& c = projected[indices[t + 2]];
+            
+            // counter clockwise triangles face the viewer, which
+            // is the winding the pipeline keeps
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area <= 0.0f)
+                continue;
+            
+            int32_t minX = std::max(0,                      (int32_t)std::floor(std::min(a.x, std::min(b.x, c.x))));
+            int32_t minY = std::max(0,                      (int32_t)std::floor(std::min(a.y, std::min(b.y, c.y))));
+            int32_t maxX = std::min((int32_t)resolution - 1, (int32_t)std::ceil (std::max(a.x, std::max(b.x, c.x))));
+            int32_t maxY = std::min((int32_t)resolution - 1, (int32_t)std::ceil (std::max(a.y, std::max(b.y, c.y))));
+            
+            for (int32_t py = minY; py <= maxY; ++py)
+                for (int32_t px = minX; px <= maxX; ++px)
+                    { // for each pixel centre in the box
+                    
+                    float x = (float)px + 0.5f;
+                    float y = (float)py + 0.5f;
+                    
+                    float w0 = (c.x - b.x) * (y - b.y) - (c.y - b.y) * (x - b.x);
+                    float w1 = (a.x - c.x) * (y - c.y) - (a.y - c.y) * (x - c.x);
+                    float w2 = (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+                    
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        continue;
+                    
+                    float  z = (w0 * a.z + w1 * b.z + w2 * c.z) / area;
+                    float& d = depth[py * resolution + px];
+                    
+                    if (z < d)
+                        {
+                        if (d == std::numeric_limits<float>::max())
+                            stats.covered++;
+                        stats.shaded++;
+                        d = z;
+                        }
+                    
+                    } // for each pixel centre in the box
+            
+            } // for each triangle
+        
+        } // for each viewpoint
+    
+    stats.overdraw = stats.covered ? (float)stats.shaded / (float)stats.covered : 0.0f;
+    
+    return stats;
+    
+    } // MeshIO :: analyzeOverdraw
+
+std::vector<uint32_t> MeshIO::optimizeVertexFetch
+        (std::vector<uint32_t>     &indices,
+         std::vector<Vertex>       &vertices,
+         std::vector<PackedVertex> *packed)
+    { // MeshIO :: optimizeVertexFetch
+    
+    const uint32_t unused = ~0u;
+    
+    std::vector<uint32_t> remap (vertices.size(), unused);
+    uint32_t next = 0;
+    
+    for (uint32_t& index : indices)
+        {
+        if (remap[index] == unused)
+            remap[index] = next++;
+        index = remap[index];
+        }
+    
+    std::vector<Vertex> reordered (next);
+    for (size_t v = 0; v < vertices.size(); ++v)
+        if (remap[v] != unused)
+            reordered[remap[v]] = vertices[v];
+    vertices.swap(reordered);
+    
+    if (packed != nullptr && packed->size() == remap.size())
+        {
+        std::vector<PackedVertex> reorderedPacked (next);
+        for (size_t v = 0; v < packed->size(); ++v)
+            if (remap[v] != unused)
+                reorderedPacked[remap[v]] = (*packed)[v];
+        packed->swap(reorderedPacked);
+        }
+    
+    return remap;
+    
+    } // MeshIO :: optimizeVertexFetch
+
+VertexFetchStats MeshIO::analyzeVertexFetch
+        (const uint32_t* indices,
+         size_t          count,
+         size_t          vertexCount,
+         size_t          vertexSize,
+         size_t          cacheBytes)
+    { // MeshIO :: analyzeVertexFetch
+    
+    VertexFetchStats stats;
+    if (count == 0 || vertexSize == 0)
+        return stats;
+    
+    const size_t   lineSize  = 64;
+    const uint64_t cacheSize = std::max<size_t>(cacheBytes / lineSize, 1);
+    
+    // same fifo stamping as analyzeVertexCache, but over the
+    // cache lines each vertex straddles rather than vertices
+    std::vector<uint64_t> stamp ((vertexCount * vertexSize + lineSize - 1) / lineSize, 0);
+    std::vector<uint8_t>  used  (vertexCount, 0);
+    uint64_t clock  = cacheSize + 1;
+    uint64_t lines  = 0;
+    uint64_t unique = 0;
+    
+    for (size_t i = 0; i < count; ++i)
+        { // for each index
+        
+        uint32_t v = indices[i];
+        
+        if (!used[v]) { used[v] = 1; unique++; }
+        
+        size_t first = (v * vertexSize) / lineSize;
+        size_t last  = (v * vertexSize + vertexSize - 1) / lineSize;
+        
+        for (size_t line = first; line <= last; ++line)
+            if (clock - stamp[line] > cacheSize)
+                {
+                lines++;
+                stamp[line] = clock++;
+                }
+        
+        } // for each index
+    
+    stats.fetched   = lines * lineSize;
+    stats.used      = unique * vertexSize;
+    stats.overfetch = stats.used ? (float)stats.fetched / (float)stats.used : 0.0f;
+    
+    return stats;
+    
+    } // MeshIO :: analyzeVertexFetch
+
+float MeshIO::simplify
+        (const std::vector<Vertex>   &vertices,
+         const std::vector<uint32_t> &indices,
+         size_t                       targetIndexCount,
+         float                        targetError,
+         std::vector<uint32_t>       &output,
+         float                        attributeWeight)
+    { // MeshIO :: simplify
+    
+    output = indices;
+    
+    const size_t count = vertices.size();
+    if (count == 0 || indices.size() <= targetIndexCount)
+        return 0.0f;
+    
+    // everything is measured relative to the bounding sphere so
+    // errors mean the same thing whatever the scale of the model
+    MeshBounds bounds = computeBounds(vertices.data(), count);
+    const float scale = bounds.radius > 0.0f ? 1.0f / bounds.radius : 1.0f;
+    
+    std::vector<glm::dvec3> positions (count);
+    for (size_t v = 0; v < count; ++v)
+        positions[v] = glm::dvec3((vertices[v].position - bounds.center) * scale);
+    
+    // vertices sharing a position are seams, where splitting the
+    // attributes means neither copy can move without tearing
+    std::vector<uint32_t> byPosition (count);
+    for (size_t v = 0; v < count; ++v)
+        byPosition[v] = (uint32_t)v;
+    
+    auto positionLess = [&] (uint32_t a, uint32_t b)
+        {
+        return memcmp(&vertices[a].position, &vertices[b].position, sizeof(glm::vec3)) < 0;
+        };
+    std::sort(byPosition.begin(), byPosition.end(), positionLess);
+    
+    std::vector<uint32_t> positionId (count);
+    std::vector<uint8_t>  locked     (count, 0);
+    
+    for (size_t i = 0; i < count; )
+        {
+        size_t j = i + 1;
+        while (j < count && !positionLess(byPosition[i], byPosition[j]))
+            ++j;
+        for (size_t k = i; k < j; ++k)
+            {
+            positionId[byPosition[k]] = byPosition[i];
+            locked[byPosition[k]]     = (j - i) > 1;
+            }
+        i = j;
+        }
+    
+    // an edge with no twin running the other way, between the same
+    // positions, lies on an open border
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        for (size_t k = 0; k < 3; ++k)
+            {
+            uint64_t a = positionId[indices[t + k]];
+            uint64_t b = positionId[indices[t + (k + 1) % 3]];
+            edges.push_back((a << 32) | b);
+            }
+    std::sort(edges.begin(), edges.end());
+    
+    for (uint64_t edge : edges)
+        {
+        uint64_t twin = (edge << 32) | (edge >> 32);
+        if (!std::binary_search(edges.begin(), edges.end(), twin))
+            {
+            locked[edge >> 32]        = 1;
+            locked[edge & 0xFFFFFFFF] = 1;
+            }
+        }
+    
+    for (size_t v = 0; v < count; ++v)
+        if (locked[positionId[v]])
+            locked[v] = 1;
+    
+    // each vertex starts with the area weighted planes of the
+    // triangles around it
+    struct Quadric
+        {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0  = 0, b1  = 0, b2  = 0, c   = 0;
+        double w   = 0;
+        
+        void add (const Quadric& q)
+            {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0  += q.b0;  b1  += q.b1;  b2  += q.b2;  c   += q.c;   w   += q.w;
+            }
+        
+        double error (const glm::dvec3& p) const
+            {
+            double e = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+                     + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+                     + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return w > 0.0 ? std::max(e, 0.0) / w : 0.0;
+            }
+        };
+    
+    std::vector<Quadric> quadrics (count);
+    
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        { // for each triangle
+        
+        const glm::dvec3& p0 = positions[indices[t + 0]];
+        const glm::dvec3& p1 = positions[indices[t + 1]];
+        const glm::dvec3& p2 = positions[indices[t + 2]];
+        
+        glm::dvec3 n    = glm::cross(p1 - p0, p2 - p0);
+        double     area = glm::length(n);
+        if (area <= 0.0)
+            continue;
+        
+        n /= area;
+        double d = -glm::dot(n, p0);
+        
+        Quadric q;
+            q.a00 = n.x * n.x * area; q.a01 = n.x * n.y * area; q.a02 = n.x * n.z * area;
+            q.a11 = n.y * n.y * area; q.a12 = n.y * n.z * area; q.a22 = n.z * n.z * area;
+            q.b0  = n.x * d * area;   q.b1  = n.y * d * area;   q.b2  = n.z * d * area;
+            q.c   = d * d * area;
+            q.w   = area;
+        
+        for (size_t k = 0; k < 3; ++k)
+            quadrics[indices[t + k]].add(q);
+        
+        } // for each triangle
+    
+    auto attributeError = [&] (uint32_t a, uint32_t b)
+        {
+        const Vertex& va = vertices[a];
+        const Vertex& vb = vertices[b];
+        glm::vec3 n = va.normal - vb.normal;
+        glm::vec3 c = va.color  - vb.color;
+        glm::vec2 u = va.uvs    - vb.uvs;
+        return (double)attributeWeight * attributeWeight *
+               (double)(glm::dot(n, n) + glm::dot(c, c) + glm::dot(u, u));
+        };
+    
+    const double limit = (double)targetError * targetError;
+    double       worst = 0.0;
+    
+    struct Collapse
+        {
+        uint32_t from;
+        uint32_t to;
+        double   cost;
+        };
+    
+    std::vector<uint32_t> adjacencyStart (count + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> best;
+    std::vector<uint32_t> collapse (count);
+    std::vector<uint8_t>  touched  (count);
+    double                slack = 1.5;
+    
+    while (output.size() > targetIndexCount)
+        { // for each pass
+        
+        // triangles around each vertex, rebuilt every pass since the
+        // collapses below only ever see the mesh as it was at the start
+        std::fill(adjacencyStart.begin(), adjacencyStart.end(), 0);
+        for (uint32_t index : output)
+            adjacencyStart[index + 1]++;
+        for (size_t v = 0; v < count; ++v)
+            adjacencyStart[v + 1] += adjacencyStart[v];
+        
+        adjacency.resize(output.size());
+        std::vector<uint32_t> cursor (adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t i = 0; i < output.size(); ++i)
+            adjacency[cursor[output[i]]++] = (uint32_t)(i / 3);
+        
+        // the cheapest way to get rid of each vertex
+        best.clear();
+        std::vector<double> cheapest (count, std::numeric_limits<double>::max());
+        std::vector<uint32_t> target (count, ~0u);
+        
+        for (size_t t = 0; t + 2 < output.size(); t += 3)
+            for (size_t k = 0; k < 3; ++k)
+                for (size_t direction = 0; direction < 2; ++direction)
+                    {
+                    uint32_t from = output[t + (direction ? k : (k + 1) % 3)];
+                    uint32_t to   = output[t + (direction ? (k + 1) % 3 : k)];
+                    
+                    if (locked[from])
+                        continue;
+                    
+                    double cost = quadrics[from].error(positions[to]) + attributeError(from, to);
+                    if (cost < cheapest[from])
+                        {
+                        cheapest[from] = cost;
+                        target[from]   = to;
+                        }
+                    }
+        
+        for (size_t v = 0; v < count; ++v)
+            if (target[v] != ~0u && cheapest[v] <= limit)
+                best.push_back({ (uint32_t)v, target[v], cheapest[v] });
+        
+        if (best.empty())
+            break;
+        
+        std::sort(best.begin(), best.end(), [] (const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+        
+        for (size_t v = 0; v < count; ++v)
+            collapse[v] = (uint32_t)v;
+        std::fill(touched.begin(), touched.end(), 0);
+        
+        size_t triangles = output.size() / 3;
+        size_t goal      = targetIndexCount / 3;
+        size_t applied   = 0;
+        
+        // each collapse removes about two triangles. only taking what
+        // this pass needs, with some slack for the ones that will be
+        // rejected, stops one pass from spending the whole error budget
+        size_t needed    = std::max<size_t>((triangles - goal) / 2, 1);
+        double passLimit = best[std::min(needed, best.size()) - 1].cost * slack;
+        
+        for (const Collapse& candidate : best)
+            { // for each candidate, cheapest first
+            
+            if (triangles <= goal || candidate.cost > passLimit)
+                break;
+            
+            uint32_t from = candidate.from;
+            uint32_t to   = candidate.to;
+            
+            if (touched[from] || touched[to])
+                continue;
+            
+            // moving a corner must not flip any surviving triangle
+            bool   flips   = false;
+            size_t removed = 0;
+            
+            for (uint32_t a = adjacencyStart[from]; a < adjacencyStart[from + 1] && !flips; ++a)
+                {
+                const uint32_t* triangle = &output[(size_t)adjacency[a] * 3];
+                
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                    {
+                    removed++;
+                    continue;
+                    }
+                
+                glm::dvec3 before[3], after[3];
+                for (size_t k = 0; k < 3; ++k)
+                    {
+                    before[k] = positions[triangle[k]];
+                    after[k]  = triangle[k] == from ? positions[to] : before[k];
+                    }
+                
+                glm::dvec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::dvec3 n1 = glm::cross(after[1]  - after[0],  after[2]  - after[0]);
+                
+                if (glm::dot(n0, n1) <= 0.25 * glm::length(n0) * glm::length(n1))
+                    flips = true;
+                }
+            
+            if (flips)
+                continue;
+            
+            collapse[from] = to;
+            quadrics[to].add(quadrics[from]);
+            worst = std::max(worst, candidate.cost);
+            
+            // everything around the collapse is frozen for the
+            // rest of the pass so adjacency stays truthful
+            for (uint32_t a = adjacencyStart[from]; a < adjacencyStart[from + 1]; ++a)
+                for (size_t k = 0; k < 3; ++k)
+                    touched[output[(size_t)adjacency[a] * 3 + k]] = 1;
+            
+            triangles -= removed;
+            applied++;
+            
+            } // for each candidate, cheapest first
+        
+        // if everything that cheap was rejected we widen the net,
+        // giving up only once every candidate has been tried
+        if (applied == 0)
+            {
+            if (passLimit >= best.back().cost)
+                break;
+            slack *= 4.0;
+            continue;
+            }
+        
+        slack = 1.5;
+        
+        // rewrite and drop the triangles that collapsed away
+        size_t kept = 0;
+        for (size_t t = 0; t + 2 < output.size(); t += 3)
+            {
+            uint32_t a = collapse[output[t]], b = collapse[output[t + 1]], c = collapse[output[t + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            output[kept++] = a;
+            output[kept++] = b;
+            output[kept++] = c;
+            }
+        output.resize(kept);
+        
+        } // for each pass
+    
+    return (float)std::sqrt(worst);
     
-    //
-    //  writeMeshFile
-    //
-    //  creates a .mesh file of the given model at the given path
-    //
-    static void writeMeshFile (const char* path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    } // MeshIO :: simplify
+
+void MeshIO::generateLevels
+        (MeshAsset                &asset,
+         const std::vector<float> &ratios,
+         float                     maxError)
+    { // MeshIO :: generateLevels
     
-    //
-    //  uses the method found in graphics gems to estimate a bounding
-    //  sphere radius for the given mesh
-    //
-    static float estimateBounds (const std::vector<Vertex>& vertices);
+    asset.lods.clear();
+    asset.lodIndices.clear();
     
-    //
-    //  returns the average of the vertex positions
-    //
-    static glm::vec3 centroid (const std::vector<Vertex>& vertices);
+    size_t previous = asset.indices.size();
     
-    //
-    //  colours the vertices with the given r g b colour
-    //
-    inline static void paint (std::vector<Vertex>& vertices, float r, float g, float b);
+    for (float ratio : ratios)
+        { // for each level
+        
+        size_t target = (size_t)((float)(asset.indices.size() / 3) * ratio) * 3;
+        
+        // simplifying from the full mesh every time keeps each
+        // level's error measured against the original surface
+        std::vector<uint32_t> level;
+        float error = simplify(asset.vertices, asset.indices, target, maxError, level);
+        
+        if (level.size() > previous * 9 / 10)
+            break;
+        
+        optimizeVertexCache(level, asset.vertices.size());
+        
+        MeshLOD lod;
+            lod.firstIndex = (uint32_t)asset.lodIndices.size();
+            lod.indexCount = (uint32_t)level.size();
+            lod.error      = error;
+        
+        asset.lods.push_back(lod);
+        asset.lodIndices.insert(asset.lodIndices.end(), level.begin(), level.end());
+        
+        previous = level.size();
+        
+        } // for each level
+    
+    } // MeshIO :: generateLevels
 
-    //
-    //  assigns each vertex to the given object id
-    //
-    inline static void assign (std::vector<Vertex>& vertices, uint32_t id);
+void MeshIO::buildMeshlets (MeshAsset& asset)
+    { // MeshIO :: buildMeshlets
+    
+    asset.meshlets.clear();
+    asset.meshletVertices.clear();
+    asset.meshletTriangles.clear();
+    
+    const std::vector<Vertex>&   vertices = asset.vertices;
+    const std::vector<uint32_t>& indices  = asset.indices;
+    
+    // where each mesh vertex sits in the meshlet being built
+    const uint8_t unused = 0xFF;
+    std::vector<uint8_t> local (vertices.size(), unused);
+    
+    Meshlet meshlet;
+    
+    auto finish = [&] ()
+        { // finish the current meshlet
         
-    //
-    //  merge
-    //
-    //  merges the second mesh into the first for batching purposes
-    //
-    static void merge
-            (std::vector<Vertex>         &aVertices,
-             std::vector<uint32_t>       &aIndices,
-             const std::vector<Vertex>   &bVertices,
-             const std::vector<uint32_t> &bIndices);
+        if (meshlet.triangleCount == 0)
+            return;
         
-    //
-    //  atlas
-    //
-    //  takes a batched scene and assignes atlased texture coordinates
-    //  to each object in the scene for a given number of objects and
-    //  square atlas resolution
-    //
-    static void atlas (std::vector<Vertex>& vertices, uint32_t n, float w);
+        const uint32_t* members = &asset.meshletVertices[meshlet.vertexOffset];
+        const uint8_t*  corners = &asset.meshletTriangles[meshlet.triangleOffset];
+        
+        // sphere around the centre of the box
+        glm::vec3 lo = vertices[members[0]].position;
+        glm::vec3 hi = lo;
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+            {
+            lo = glm::min(lo, vertices[members[v]].position);
+            hi = glm::max(hi, vertices[members[v]].position);
+            }
+        
+        meshlet.center = (lo + hi) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[members[v]].position - meshlet.center));
+        
+        // the cone axis is the average facing, and its width
+        // is set by the triangle furthest from it
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> points;
+        glm::vec3 axis = { 0.0f, 0.0f, 0.0f };
+        
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+            {
+            const glm::vec3& a = vertices[members[corners[t * 3 + 0]]].position;
+            const glm::vec3& b = vertices[members[corners[t * 3 + 1]]].position;
+            const glm::vec3& c = vertices[members[corners[t * 3 + 2]]].position;
+            
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float     l = glm::length(n);
+            if (l <= 0.0f)
+                continue;
+            
+            normals.push_back(n / l);
+            points.push_back(a);
+            axis += n / l;
+            }
+        
+        meshlet.coneAxis   = glm::length(axis) > 0.0f ? glm::normalize(axis) : glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.coneCutoff = 1.0f;
+        meshlet.coneApex   = meshlet.center;
+        
+        float minimum = 1.0f;
+        for (const glm::vec3& n : normals)
+            minimum = std::min(minimum, glm::dot(n, meshlet.coneAxis));
+        
+        // past about 84 degrees from the axis the cone can not
+        // cull anything useful, so it is left wide open
+        if (!normals.empty() && minimum > 0.1f)
+            {
+            meshlet.coneCutoff = std::sqrt(1.0f - minimum * minimum);
+            
+            // the apex is the point on the axis, behind the
+            // meshlet, that lies behind every triangle's plane
+            float furthest = 0.0f;
+            for (size_t t = 0; t < normals.size(); ++t)
+                {
+                float t0 = glm::dot(meshlet.center - points[t], normals[t]) / glm::dot(meshlet.coneAxis, normals[t]);
+                furthest = std::max(furthest, t0);
+                }
+            
+            meshlet.coneApex = meshlet.center - meshlet.coneAxis * furthest;
+            }
+        
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+            local[members[v]] = unused;
+        
+        asset.meshlets.push_back(meshlet);
+        
+        // the next meshlet's triangles start on a 4 byte boundary
+        while (asset.meshletTriangles.size() % 4)
+            asset.meshletTriangles.push_back(0);
+        
+        meshlet                = Meshlet();
+        meshlet.vertexOffset   = (uint32_t)asset.meshletVertices.size();
+        meshlet.triangleOffset = (uint32_t)asset.meshletTriangles.size();
+        
+        }; // finish the current meshlet
+    
+    const size_t triangleCount = indices.size() / 3;
+    
+    // triangles around each vertex so meshlets can grow
+    // across the surface rather than along the index order
+    std::vector<uint32_t> adjacencyStart (vertices.size() + 1, 0);
+    for (uint32_t index : indices)
+        adjacencyStart[index + 1]++;
+    for (size_t v = 0; v < vertices.size(); ++v)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    
+    std::vector<uint32_t> adjacency (indices.size());
+    std::vector<uint32_t> cursor (adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[cursor[indices[i]]++] = (uint32_t)(i / 3);
+    
+    std::vector<glm::vec3> facing (triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+        {
+        glm::vec3 n = glm::cross(
+            vertices[indices[t * 3 + 1]].position - vertices[indices[t * 3]].position,
+            vertices[indices[t * 3 + 2]].position - vertices[indices[t * 3]].position);
+        facing[t] = glm::length(n) > 0.0f ? glm::normalize(n) : n;
+        }
+    
+    std::vector<uint8_t> emitted (triangleCount, 0);
+    glm::vec3 axis = { 0.0f, 0.0f, 0.0f };
+    size_t    seed = 0;
+    
+    for (size_t placed = 0; placed < triangleCount; ++placed)
+        { // for each triangle placed
+        
+        // the best neighbour adds the fewest new vertices, with
+        // ties going to whichever faces most like the meshlet so
+        // far, which keeps the normal cones narrow
+        uint32_t best      = ~0u;
+        uint32_t bestExtra = 4;
+        float    bestDot   = -2.0f;
+        
+        for (uint32_t m = 0; m < meshlet.vertexCount; ++m)
+            {
+            uint32_t v = asset.meshletVertices[meshlet.vertexOffset + m];
+            
+            for (uint32_t a = adjacencyStart[v]; a < adjacencyStart[v + 1]; ++a)
+                {
+                uint32_t t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                
+                uint32_t extra = 0;
+                for (size_t k = 0; k < 3; ++k)
+                    if (local[indices[t * 3 + k]] == unused)
+                        extra++;
+                
+                float agreement = glm::dot(facing[t], axis);
+                
+                if (extra < bestExtra || (extra == bestExtra && agreement > bestDot))
+                    {
+                    best      = t;
+                    bestExtra = extra;
+                    bestDot   = agreement;
+                    }
+                }
+            }
+        
+        if (best != ~0u && (meshlet.vertexCount + bestExtra > Meshlet::maxVertices || meshlet.triangleCount + 1 > Meshlet::maxTriangles))
+            best = ~0u;
+        
+        // with nowhere left to grow, the next meshlet starts
+        // from the first triangle still waiting in index order
+        if (best == ~0u)
+            {
+            finish();
+            axis = { 0.0f, 0.0f, 0.0f };
+            
+            while (emitted[seed])
+                ++seed;
+            best = (uint32_t)seed;
+            }
+        
+        emitted[best] = 1;
+        axis += facing[best];
+        
+        for (size_t k = 0; k < 3; ++k)
+            {
+            uint32_t v = indices[best * 3 + k];
+            if (local[v] == unused)
+                {
+                local[v] = (uint8_t)meshlet.vertexCount++;
+                asset.meshletVertices.push_back(v);
+                }
+            asset.meshletTriangles.push_back(local[v]);
+            }
+        
+        meshlet.triangleCount++;
+        
+        } // for each triangle placed
+    
+    finish();
+    
+    } // MeshIO :: buildMeshlets
 
-    };
+bool MeshIO::makeProgressive (MeshAsset& asset)
+    { // MeshIO :: makeProgressive
+    
+    if (asset.lods.empty())
+        return false;
+    
+    const uint32_t unused = ~0u;
+    
+    std::vector<uint32_t> remap (asset.vertices.size(), unused);
+    uint32_t next = 0;
+    
+    auto number = [&] (const uint32_t* indices, size_t count)
+        {
+        for (size_t i = 0; i < count; ++i)
+            if (remap[indices[i]] == unused)
+                remap[indices[i]] = next++;
+        };
+    
+    // the lods run coarsest last, so they are walked backwards
+    for (size_t l = asset.lods.size(); l-- > 0; )
+        {
+        MeshLOD& lod = asset.lods[l];
+        number(asset.lodIndices.data() + lod.firstIndex, lod.indexCount);
+        lod.vertexCount = next;
+        }
+    
+    number(asset.indices.data(), asset.indices.size());
+    
+    // vertices no triangle uses are kept, at the very end
+    for (uint32_t& index : remap)
+        if (index == unused)
+            index = next++;
+    
+    std::vector<Vertex> reordered (asset.vertices.size());
+    for (size_t v = 0; v < asset.vertices.size(); ++v)
+        reordered[remap[v]] = asset.vertices[v];
+    asset.vertices.swap(reordered);
+    
+    if (asset.packed.size() == remap.size())
+        {
+        std::vector<PackedVertex> reorderedPacked (asset.packed.size());
+        for (size_t v = 0; v < asset.packed.size(); ++v)
+            reorderedPacked[remap[v]] = asset.packed[v];
+        asset.packed.swap(reorderedPacked);
+        }
+    
+    for (uint32_t& index : asset.indices)         index = remap[index];
+    for (uint32_t& index : asset.lodIndices)      index = remap[index];
+    for (uint32_t& index : asset.meshletVertices) index = remap[index];
+    
+    asset.indexFlags |= MeshFormat::eProgressive;
+    
+    return true;
+    
+    } // MeshIO :: makeProgressive
 
-/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
- *  MeshIO Implementation
- *
- * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-void MeshIO::readMeshFile (const char* path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
-    { // MeshIO :: readMeshFile
+bool MeshIO::meshletBackfacing (const Meshlet& meshlet, const glm::vec3& eye)
+    { // MeshIO :: meshletBackfacing
     
-    std::ifstream input (path, std::ios::binary);
+    glm::vec3 view = meshlet.coneApex - eye;
+    float     length = glm::length(view);
+    
+    return length > 0.0f && glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * length;
+    
+    } // MeshIO :: meshletBackfacing
 
-    // first we read in the sizes of our arrays and allocate
-    // accordinly in advance
-    uint32_t v; input.read((char*)&v, sizeof(uint32_t)); vertices.resize(v);
-    uint32_t f; input.read((char*)&f, sizeof(uint32_t)); indices.resize(f);
+void MeshIO::optimize (MeshAsset& asset, const MeshOptimizeOptions& options)
+    { // MeshIO :: optimize
     
-    // then we pull in the geometry data
-    input.read((char*)vertices.data(), sizeof(Vertex) * v);
-    input.read((char*)indices.data(), sizeof(uint32_t) * f);
+    // welding renumbers vertices, so it goes before anything
+    // that depends on their order
+    if (options.weld && !(asset.indexFlags & MeshFormat::eWelded))
+        {
+        WeldStats stats = weld(asset.indices, asset.vertices, options.weldEpsilon, asset.packed.empty() ? nullptr : &asset.packed);
+        asset.indexFlags |= MeshFormat::eWelded;
+        
+        if (stats.verticesAfter != stats.verticesBefore)
+            asset.indexFlags &= ~(MeshFormat::eVertexFetchOptimized | MeshFormat::eLevelsOfDetail | MeshFormat::eMeshletsBuilt | MeshFormat::eProgressive);
+        if (stats.trianglesAfter != stats.trianglesBefore)
+            asset.indexFlags &= ~(MeshFormat::eVertexCacheOptimized | MeshFormat::eOverdrawOptimized);
+        }
     
-    input.close();
+    if (options.vertexCache && !(asset.indexFlags & MeshFormat::eVertexCacheOptimized))
+        {
+        optimizeVertexCache(asset.indices, asset.vertices.size());
+        asset.indexFlags |= MeshFormat::eVertexCacheOptimized;
+        asset.indexFlags &= ~MeshFormat::eMeshletsBuilt;
+        }
     
-    } // MeshIO :: readMeshFile
+    // clustering relies on the cache order, so this has
+    // to follow the vertex cache pass
+    if (options.overdraw && !(asset.indexFlags & MeshFormat::eOverdrawOptimized))
+        {
+        optimizeOverdraw(asset.indices, asset.vertices, options.overdrawThreshold);
+        asset.indexFlags |= MeshFormat::eOverdrawOptimized;
+        asset.indexFlags &= ~MeshFormat::eMeshletsBuilt;
+        }
+    
+    if (options.vertexFetch && !(asset.indexFlags & MeshFormat::eVertexFetchOptimized))
+        {
+        optimizeVertexFetch(asset.indices, asset.vertices, asset.packed.empty() ? nullptr : &asset.packed);
+        asset.indexFlags |= MeshFormat::eVertexFetchOptimized;
+        asset.indexFlags &= ~(MeshFormat::eLevelsOfDetail | MeshFormat::eMeshletsBuilt | MeshFormat::eProgressive);
+        
+        // dropping unused vertices can pull the bounds in
+        if (asset.hasBounds)
+            asset.bounds = computeBounds(asset.vertices.data(), asset.vertices.size());
+        }
+    
+    // meshlets and levels index the final vertex order, so they come last
+    if (options.meshlets && !(asset.indexFlags & MeshFormat::eMeshletsBuilt))
+        {
+        buildMeshlets(asset);
+        asset.indexFlags |= MeshFormat::eMeshletsBuilt;
+        }
+    
+    if (options.levels && !(asset.indexFlags & MeshFormat::eLevelsOfDetail))
+        {
+        generateLevels(asset, options.levelRatios, options.levelError);
+        asset.indexFlags |= MeshFormat::eLevelsOfDetail;
+        asset.indexFlags &= ~MeshFormat::eProgressive;
+        }
+    
+    } // MeshIO :: optimize
 
-void MeshIO::writeMeshFile (const char* path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
-    { // MeshIO :: writeMeshFile
+uint64_t MeshIO::fingerprint (const MeshOptimizeOptions& options)
+    { // MeshIO :: fingerprint
     
-    std::ofstream output (path, std::ios::binary);
+    // fields are copied out one at a time so padding in
+    // the options never reaches the hash
+    std::vector<uint8_t> bytes;
+    auto add = [&bytes] (const void* data, size_t size)
+        {
+        bytes.insert(bytes.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        };
     
-    // the first 2 entries in the file are integers with the first
-    // representing the number of vertices and the second representing
-    // the number of face entries in the mesh
-    uint32_t v = static_cast<uint32_t>(vertices.size());
-    uint32_t f = static_cast<uint32_t>(indices.size());
+    const uint32_t pipeline = MeshFormat::pipeline;
+    const uint8_t  passes[] =
+        {
+        options.weld, options.vertexCache, options.overdraw, options.vertexFetch, options.meshlets, options.levels
+        };
     
-    output.write((char*)&v, sizeof(uint32_t));
-    output.write((char*)&f, sizeof(uint32_t));
+    add(&pipeline,                  sizeof(pipeline));
+    add(passes,                     sizeof(passes));
+    add(&options.weldEpsilon,       sizeof(float));
+    add(&options.overdrawThreshold, sizeof(float));
+    add(&options.levelError,        sizeof(float));
+    add(options.levelRatios.data(), sizeof(float) * options.levelRatios.size());
     
-    // we then write out the vertex and face data
-    output.write((char*)vertices.data(), sizeof(Vertex) * v);
-    output.write((char*)indices.data(), sizeof(uint32_t) * f);
+    return checksum(bytes.data(), bytes.size());
     
-    output.close();
+    } // MeshIO :: fingerprint
+
+bool MeshIO::mapOptimizedMeshFile (const char* path, MeshView& view, const MeshCache& cache, const MeshOptimizeOptions& options)
+    { // MeshIO :: mapOptimizedMeshFile
+    
+    MappedFile original;
+    if (!original.open(path))
+        return false;
+    
+    const uint64_t source = checksum(original.data, original.size);
+    original.close();
+    
+    const std::string entry = cache.entry(source, fingerprint(options));
+    
+    // this process or another may already have done the work
+    // for exactly these bytes and options. the checksums guard
+    // against an entry damaged on disk
+    if (mapMeshFile(entry.c_str(), view))
+        {
+        if (view.source == source && verify(view))
+            {
+            cache.touch(entry);
+            return true;
+            }
         
-    } // MeshIO :: writeMeshFile
+        view.file.close();
+        cache.remove(entry);
+        }
+    
+    MeshAsset asset;
+    if (!readMeshAsset(path, asset))
+        return false;
+    
+    optimize(asset, options);
+    asset.source = source;
+    
+    // the entry is written under a private name and renamed
+    // into place, so a reader never maps a partial file. if it
+    // can not be written we fall back on the original geometry
+    // rather than failing the load
+    const std::string temporary = cache.temporary();
+    
+    if (!writeMeshAsset(temporary.c_str(), asset))
+        {
+        cache.remove(temporary);
+        return mapMeshFile(path, view);
+        }
+    
+    if (!cache.publish(temporary, entry))
+        return mapMeshFile(path, view);
+    
+    cache.trim(entry);
+    
+    return mapMeshFile(entry.c_str(), view) || mapMeshFile(path, view);
+    
+    } // MeshIO :: mapOptimizedMeshFile
 
-float MeshIO::estimateBounds (const std::vector<Vertex>& vertices)
-    { // MeshIO :: estimateBounds
+std::future<MeshView> MeshIO::loadMesh (TaskPool& pool, const std::string& path, const MeshCache* cache)
+    { // MeshIO :: loadMesh
+    
+    return pool.submit([path, cache] ()
+        {
+        MeshView view;
+        
+        bool mapped = cache != nullptr ?
+            mapOptimizedMeshFile(path.c_str(), view, *cache) :
+            mapMeshFile(path.c_str(), view);
+        
+        if (!mapped)
+            view = MeshView();
+        
+        return view;
+        });
+    
+    } // MeshIO :: loadMesh
+
+bool MeshIO::openMeshStream (const char* path, MeshStream& stream)
+    { // MeshIO :: openMeshStream
+    
+    stream.file.close();
+    stream.file.clear();
+    stream.file.open(path, std::ios::binary | std::ios::ate);
+    
+    if (!stream.file.is_open())
+        return false;
+    
+    const uint64_t size = (uint64_t)stream.file.tellg();
+    stream.file.seekg(0);
+    
+    MeshFormat::Header header = { };
+    if (size >= sizeof(header))
+        stream.file.read((char*)&header, sizeof(header));
+    
+    // the table has to fit in the file before it is allocated
+    const uint64_t tableSize = (uint64_t)header.sectionCount * sizeof(MeshFormat::SectionEntry);
+    
+    std::vector<MeshFormat::SectionEntry> table;
+    if (header.magic == MeshFormat::magic && header.version >= MeshFormat::version && header.sectionSize == sizeof(MeshFormat::SectionEntry) &&
+        (uint64_t)header.headerSize + tableSize <= size)
+        {
+        table.resize(header.sectionCount);
+        stream.file.seekg(header.headerSize);
+        stream.file.read((char*)table.data(), sizeof(MeshFormat::SectionEntry) * table.size());
+        
+        if (!stream.file)
+            return false;
+        }
+    
+    stream.vertexSection = { };
+    stream.indexSection  = { };
+    for (const MeshFormat::SectionEntry& section : table)
+        {
+        if (section.type == MeshFormat::eVertices) stream.vertexSection = section;
+        if (section.type == MeshFormat::eIndices)  stream.indexSection  = section;
+        }
+    
+    const MeshFormat::SectionEntry& vertices = stream.vertexSection;
+    const MeshFormat::SectionEntry& indices  = stream.indexSection;
+    
+    const bool progressive =
+        (indices.flags & MeshFormat::eProgressive) &&
+        !((vertices.flags | indices.flags) & MeshFormat::eCompressed) &&
+        vertices.stride == sizeof(Vertex) &&
+        (indices.stride == sizeof(uint32_t) || indices.stride == sizeof(uint16_t)) &&
+        vertices.size == (uint64_t)vertices.count * vertices.stride &&
+        indices.size  == (uint64_t)indices.count  * indices.stride  &&
+        vertices.offset <= size && vertices.size <= size - vertices.offset &&
+        indices.offset  <= size && indices.size  <= size - indices.offset;
+    
+    // everything bar the two streamed sections is small and
+    // read up front, through the ordinary reader
+    const uint32_t small = MeshFormat::bit(MeshFormat::eBounds) | MeshFormat::bit(MeshFormat::eLODs) | MeshFormat::bit(MeshFormat::eLODIndices);
+    
+    MeshAsset asset;
+    if (!readMeshAsset(path, asset, progressive ? small : MeshFormat::all))
+        return false;
+    
+    // levels have to grow towards the full mesh and stay
+    // inside the vertex array, or the file is not one we
+    // can refine and it is read whole after all
+    bool levels = progressive && !asset.lods.empty();
+    for (size_t l = 0; levels && l < asset.lods.size(); ++l)
+        {
+        const uint32_t finer = l == 0 ? vertices.count : asset.lods[l - 1].vertexCount;
+        levels = asset.lods[l].vertexCount <= finer &&
+                 (uint64_t)asset.lods[l].firstIndex + asset.lods[l].indexCount <= asset.lodIndices.size();
+        }
     
-    float minX = std::numeric_limits<float>::max(); uint32_t minXIndex = 0;
-    float maxX = std::numeric_limits<float>::min(); uint32_t maxXIndex = 0;
-    float minY = std::numeric_limits<float>::max(); uint32_t minYIndex = 0;
-    float maxY = std::numeric_limits<float>::min(); uint32_t maxYIndex = 0;
-    float minZ = std::numeric_limits<float>::max(); uint32_t minZIndex = 0;
-    float maxZ = std::numeric_limits<float>::min(); uint32_t maxZIndex = 0;
+    if (progressive && !levels && !readMeshAsset(path, asset))
+        return false;
     
-    glm::vec3 centroid = { 0.0f, 0.0f, 0.0f };
+    stream.hasBounds  = asset.hasBounds;
+    stream.bounds     = asset.bounds;
+    stream.indexFlags = asset.indexFlags;
+    stream.lods.swap(asset.lods);
+    stream.lodIndices.clear();
+    stream.lodIndices16.clear();
+    stream.indices.clear();
+    stream.indices16.clear();
+    stream.vertexHash = MeshChecksum();
     
-    for (uint32_t v = 0; v < vertices.size(); ++v)
-        { // for each vertex position
+    // lod indices go back to the width they were stored at,
+    // so the view looks the same as a mapped file's would
+    if (narrowIndices(asset.lodIndices.data(), asset.lodIndices.size(), 0, stream.lodIndices16))
+        asset.lodIndices.clear();
+    stream.lodIndices.swap(asset.lodIndices);
+    
+    if (!levels)
+        { // read whole
+        
+        stream.vertices.swap(asset.vertices);
+        stream.loaded = stream.vertices.size();
+        stream.finest = 0;
         
-        if (vertices[v].position.x < minX) { minX = vertices[v].position.x; minXIndex = v; }
-        if (vertices[v].position.x > maxX) { maxX = vertices[v].position.x; maxXIndex = v; }
-        if (vertices[v].position.y < minY) { minY = vertices[v].position.y; minYIndex = v; }
-        if (vertices[v].position.y > maxY) { maxY = vertices[v].position.y; maxYIndex = v; }
-        if (vertices[v].position.z < minZ) { minZ = vertices[v].position.z; minZIndex = v; }
-        if (vertices[v].position.z > maxZ) { maxZ = vertices[v].position.z; maxZIndex = v; }
+        if (!narrowIndices(asset.indices.data(), asset.indices.size(), 0, stream.indices16))
+            stream.indices.swap(asset.indices);
         
-        centroid += vertices[v].position;
+        stream.file.close();
+        return true;
+        
+        } // read whole
+    
+    stream.vertices.assign(vertices.count, Vertex());
+    
+    if (indices.stride == sizeof(uint16_t))
+        stream.indices16.assign(indices.count, 0);
+    else
+        stream.indices.assign(indices.count, 0);
+    
+    stream.loaded = 0;
+    stream.finest = (uint32_t)stream.lods.size() + 1;
+    
+    return refineMeshStream(stream);
+    
+    } // MeshIO :: openMeshStream
+
+bool MeshIO::refineMeshStream (MeshStream& stream)
+    { // MeshIO :: refineMeshStream
+    
+    if (stream.finest == 0)
+        return true;
+    
+    const uint32_t level  = stream.finest - 1;
+    const size_t   target = level == 0 ? stream.vertices.size() : stream.lods[level - 1].vertexCount;
+    
+    // the vertices arrive in file order, so the checksum of
+    // the section builds up a level at a time. nothing is
+    // committed to the stream until the whole step has read
+    MeshChecksum hash = stream.vertexHash;
+    
+    if (target > stream.loaded)
+        {
+        const size_t count = target - stream.loaded;
         
-        } // for each vertex position
+        stream.file.clear();
+        stream.file.seekg(stream.vertexSection.offset + sizeof(Vertex) * (uint64_t)stream.loaded);
+        stream.file.read((char*)(stream.vertices.data() + stream.loaded), sizeof(Vertex) * count);
         
-    centroid /= (float)vertices.size();
+        if (!stream.file)
+            return false;
         
-    assert(minX == vertices[minXIndex].position.x);
-    assert(minY == vertices[minYIndex].position.y);
-    assert(minZ == vertices[minZIndex].position.z);
-    assert(maxX == vertices[maxXIndex].position.x);
-    assert(maxY == vertices[maxYIndex].position.y);
-    assert(maxZ == vertices[maxZIndex].position.z);
+        hash.add(stream.vertices.data() + stream.loaded, sizeof(Vertex) * count);
+        }
     
-    // we compute 3 pairs of vertices with the minimum and maximum
-    // value of each dimension, giving us a vector across the extents
-    // of the x, y and z axes
-    std::vector<float> spans = {
-            glm::length(vertices[maxXIndex].position - vertices[minXIndex].position),
-            glm::length(vertices[maxYIndex].position - vertices[minYIndex].position),
-            glm::length(vertices[maxZIndex].position - vertices[minZIndex].position)};
+    if (level == 0)
+        { // full mesh
+        
+        if (hash.value() != stream.vertexSection.checksum)
+            return false;
+        
+        void* destination = stream.indices.empty() ? (void*)stream.indices16.data() : (void*)stream.indices.data();
+        
+        stream.file.seekg(stream.indexSection.offset);
+        stream.file.read((char*)destination, stream.indexSection.size);
         
-    float r = *std::max_element(std::begin(spans), std::end(spans));
+        if (!stream.file || checksum(destination, stream.indexSection.size) != stream.indexSection.checksum)
+            return false;
+        
+        stream.file.close();
+        
+        } // full mesh
+    
+    stream.vertexHash = hash;
+    stream.loaded     = std::max(stream.loaded, target);
+    stream.finest     = level;
+    
+    return true;
+    
+    } // MeshIO :: refineMeshStream
+
+std::future<MeshView> MeshIO::loadMeshStream (TaskPool& pool, const std::string& path, MeshStream& stream)
+    { // MeshIO :: loadMeshStream
+    
+    MeshStream* target = &stream;
+    
+    return pool.submit([path, target] ()
+        {
+        return openMeshStream(path.c_str(), *target) ? target->view() : MeshView();
+        });
     
-    // we then make a single pass through the vertices and expand the
-    // sphere whenever we encounter a point outside of it
-    for (uint32_t v = 0; v < vertices.size(); ++v)
-        { // for each position
+    } // MeshIO :: loadMeshStream
+
+std::future<MeshView> MeshIO::generateMesh (TaskPool& pool, MeshGenerator::Shape shape, uint64_t triangles, uint32_t seed)
+    { // MeshIO :: generateMesh
+    
+    return pool.submit([shape, triangles, seed] ()
+        {
+        MeshView view;
+        
+        size_t vertexCount = 0;
+        if (!MeshGenerator::measure(shape, triangles, vertexCount) || 3 * triangles > std::numeric_limits<size_t>::max() / sizeof(uint32_t))
+            return view;
+        
+        // vertices and indices share the one allocation, laid
+        // out as they would be in a file
+        const size_t indexCount  = (size_t)(3 * triangles);
+        const size_t indexOffset = (sizeof(Vertex) * vertexCount + MeshFormat::alignment - 1) & ~(size_t)(MeshFormat::alignment - 1);
         
-        float distance = glm::length(vertices[v].position - centroid);
-        if (distance > r)
-            r += distance - r;
+        view.decoded.resize(indexOffset + sizeof(uint32_t) * indexCount);
         
-        } // for each position
+        Vertex*   vertices = (Vertex*)view.decoded.data();
+        uint32_t* indices  = (uint32_t*)(view.decoded.data() + indexOffset);
+        
+        MeshGenerator::generate(shape, triangles, vertices, indices, seed);
+        
+        view.vertices  = { vertices, vertexCount };
+        view.indices   = { indices,  indexCount };
+        view.version   = MeshFormat::version;
+        view.hasBounds = true;
+        view.bounds    = computeBounds(vertices, vertexCount);
+        
+        return view;
+        });
+    
+    } // MeshIO :: generateMesh
+
+MeshView MeshStream::view () const
+    { // MeshStream :: view
+    
+    MeshView view;
+        view.version      = MeshFormat::version;
+        view.hasBounds    = hasBounds;
+        view.bounds       = bounds;
+        view.indexFlags   = indexFlags;
+        view.vertices     = { vertices.data(),     vertices.size()     };
+        view.indices      = { indices.data(),      indices.size()      };
+        view.indices16    = { indices16.data(),    indices16.size()    };
+        view.lods         = { lods.data(),         lods.size()         };
+        view.lodIndices   = { lodIndices.data(),   lodIndices.size()   };
+        view.lodIndices16 = { lodIndices16.data(), lodIndices16.size() };
+    
+    return view;
+    
+    } // MeshStream :: view
+
+float MeshIO::estimateBounds (const std::vector<Vertex>& vertices)
+    { // MeshIO :: estimateBounds
+    
+    if (vertices.empty())
+        return 0.0f;
     
-    return 0;
+    Bounds::Positions positions = Bounds::positions(vertices.data(), vertices.size());
+    
+    return Bounds::spheres(positions, Bounds::extents(positions)).ritter.radius;
     
     } // MeshIO :: estimateBounds
 
 glm::vec3 MeshIO::centroid (const std::vector<Vertex>& vertices)
     { // MeshIO :: centroid
-    glm::vec3 result = { 0.0f, 0.0f, 0.0f };
-    for (const Vertex& v : vertices)
-        result += v.position;
-    return result / (float)vertices.size();
+    return Bounds::extents(Bounds::positions(vertices.data(), vertices.size())).centroid;
     } // MeshIO :: centroid
 
 
@@ -212,6 +3473,14 @@ void MeshIO::assign (std::vector<Vertex>& vertices, uint32_t id)
 
     } // MeshIO :: paint
 
+void MeshIO::assign (std::vector<Vertex>& vertices, uint32_t id, size_t first)
+    { // MeshIO :: assign
+    
+    for (size_t v = first; v < vertices.size(); ++v)
+        vertices[v].id = id;
+
+    } // MeshIO :: assign
+
 void MeshIO::merge
         (std::vector<Vertex>         &aVertices,
          std::vector<uint32_t>       &aIndices,
@@ -220,35 +3489,207 @@ void MeshIO::merge
     { // MeshIO :: merge
     
     // the index offset is the highest possible index of a's vertex list
-    size_t offset = aVertices.size();
+    uint32_t offset = static_cast<uint32_t>(aVertices.size());
 
     //    merge the vertex lists. These can just be placed on the
     //    back of the vertex array
-    for (uint32_t i = 0; i < bVertices.size(); ++i)
-        aVertices.push_back(bVertices[i]);
+    aVertices.insert(aVertices.end(), bVertices.begin(), bVertices.end());
 
     //    merge the index lists. use the offset to find the
     //    indices of the old vertices in the updated array
-    for (uint32_t i = 0; i < bIndices.size(); ++i)
-        aIndices.push_back(offset + bIndices[i]);
+    size_t first = aIndices.size();
+    aIndices.resize(first + bIndices.size());
+    for (size_t i = 0; i < bIndices.size(); ++i)
+        aIndices[first + i] = offset + bIndices[i];
+    
+    } // MeshIO :: merge
+
+void MeshIO::merge
+        (std::vector<Vertex>         &aVertices,
+         std::vector<uint32_t>       &aIndices,
+         const MeshSpan<Vertex>      &bVertices,
+         const MeshSpan<uint32_t>    &bIndices)
+    { // MeshIO :: merge
+    
+    uint32_t offset = static_cast<uint32_t>(aVertices.size());
+    
+    // the vertices can be copied straight out of the source
+    // memory onto the back of the vertex array
+    aVertices.insert(aVertices.end(), bVertices.begin(), bVertices.end());
+    
+    // the indices still need rebasing as they are copied
+    size_t first = aIndices.size();
+    aIndices.resize(first + bIndices.size);
+    for (size_t i = 0; i < bIndices.size; ++i)
+        aIndices[first + i] = offset + bIndices[i];
+    
+    } // MeshIO :: merge
+
+void MeshIO::merge
+        (std::vector<Vertex>         &aVertices,
+         std::vector<uint32_t>       &aIndices,
+         const MeshSpan<Vertex>      &bVertices,
+         const MeshSpan<uint16_t>    &bIndices)
+    { // MeshIO :: merge
+    
+    uint32_t offset = static_cast<uint32_t>(aVertices.size());
+    
+    aVertices.insert(aVertices.end(), bVertices.begin(), bVertices.end());
+    
+    // widened to 32 bits as they are rebased
+    size_t first = aIndices.size();
+    aIndices.resize(first + bIndices.size);
+    for (size_t i = 0; i < bIndices.size; ++i)
+        aIndices[first + i] = offset + bIndices[i];
     
     } // MeshIO :: merge
 
+void MeshIO::merge
+        (std::vector<Vertex>         &aVertices,
+         std::vector<uint32_t>       &aIndices,
+         std::vector<MeshBatchItem>  &items)
+    { // MeshIO :: merge
+    
+    if (items.empty())
+        return;
+    
+    size_t vertexCount = aVertices.size();
+    size_t indexCount  = aIndices.size();
+    
+    for (MeshBatchItem& item : items)
+        {
+        item.firstVertex = vertexCount;
+        item.firstIndex  = indexCount;
+        vertexCount     += item.vertices.size;
+        indexCount      += item.indexCount();
+        }
+    
+    const size_t vertexBase = aVertices.size();
+    const size_t indexBase  = aIndices.size();
+    
+    aVertices.resize(vertexCount);
+    aIndices.resize(indexCount);
+    
+    // each worker takes a slice of the output and walks the items
+    // overlapping it, so one large object is still spread across
+    // every thread
+    auto firstItem = [&items] (size_t position, bool vertices)
+        {
+        size_t lo = 0, hi = items.size();
+        while (lo + 1 < hi)
+            {
+            size_t mid = (lo + hi) / 2;
+            if ((vertices ? items[mid].firstVertex : items[mid].firstIndex) <= position)
+                lo = mid;
+            else
+                hi = mid;
+            }
+        return lo;
+        };
+    
+    Parallel::forRange(vertexCount - vertexBase, 1 << 16, [&] (size_t begin, size_t end, uint32_t)
+        {
+        begin += vertexBase;
+        end   += vertexBase;
+        
+        for (size_t i = firstItem(begin, true); i < items.size() && items[i].firstVertex < end; ++i)
+            {
+            const MeshBatchItem& item = items[i];
+            
+            size_t from = std::max(begin, item.firstVertex);
+            size_t to   = std::min(end,   item.firstVertex + item.vertices.size);
+            
+            for (size_t v = from; v < to; ++v)
+                {
+                aVertices[v]    = item.vertices[v - item.firstVertex];
+                aVertices[v].id = item.id;
+                }
+            }
+        });
+    
+    Parallel::forRange(indexCount - indexBase, 1 << 17, [&] (size_t begin, size_t end, uint32_t)
+        {
+        begin += indexBase;
+        end   += indexBase;
+        
+        for (size_t i = firstItem(begin, false); i < items.size() && items[i].firstIndex < end; ++i)
+            {
+            const MeshBatchItem& item = items[i];
+            
+            size_t   from   = std::max(begin, item.firstIndex);
+            size_t   to     = std::min(end,   item.firstIndex + item.indexCount());
+            uint32_t offset = static_cast<uint32_t>(item.firstVertex);
+            
+            if (item.indices16.size)
+                for (size_t k = from; k < to; ++k)
+                    aIndices[k] = offset + item.indices16[k - item.firstIndex];
+            else
+                for (size_t k = from; k < to; ++k)
+                    aIndices[k] = offset + item.indices[k - item.firstIndex];
+            }
+        });
+    
+    } // MeshIO :: merge
+
+void MeshIO::splitStreams
+        (const Vertex*                  vertices,
+         size_t                         count,
+         std::vector<VertexPosition>   &positions,
+         std::vector<VertexAttributes> &attributes)
+    { // MeshIO :: splitStreams
+    
+    positions.resize(count);
+    attributes.resize(count);
+    
+    Parallel::forRange(count, 64 * 1024, [&] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t i = begin; i < end; ++i)
+            {
+            positions[i]  = { vertices[i].position, vertices[i].id };
+            attributes[i] = { vertices[i].normal, vertices[i].color, vertices[i].uvs };
+            }
+        });
+    
+    } // MeshIO :: splitStreams
+
+bool MeshIO::narrowIndices (const uint32_t* indices, size_t count, uint32_t base, std::vector<uint16_t>& output)
+    { // MeshIO :: narrowIndices
+    
+    for (size_t i = 0; i < count; ++i)
+        if (indices[i] < base || indices[i] - base > 0xFFFF)
+            return false;
+    
+    size_t first = output.size();
+    output.resize(first + count);
+    for (size_t i = 0; i < count; ++i)
+        output[first + i] = static_cast<uint16_t>(indices[i] - base);
+    
+    return true;
+    
+    } // MeshIO :: narrowIndices
+
 void MeshIO::atlas (std::vector<Vertex>& vertices, uint32_t n, float w)
     { // MeshIO :: atlas
+    atlas(vertices.data(), vertices.size(), n, w);
+    } // MeshIO :: atlas
+
+void MeshIO::atlas (Vertex* vertices, size_t count, uint32_t n, float w)
+    { // MeshIO :: atlas
     
     int   m = sqrt (n);
     float t = w / (float)m;
     float s = t / (float)w;
     
     // scale parameterisation
-    for (Vertex& v : vertices)
-        v.uvs = v.uvs * s;
+    for (size_t i = 0; i < count; ++i)
+        vertices[i].uvs = vertices[i].uvs * s;
         
     // translate parameterisation
-    for (Vertex& v : vertices)
+    for (size_t i = 0; i < count; ++i)
         { // for each vertex
         
+        Vertex& v = vertices[i];
+        
         float hID = (v.id % m);
         float vID = floor (v.id / (float)m);
         
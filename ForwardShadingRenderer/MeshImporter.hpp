@@ -0,0 +1,1097 @@
+//
+//  MeshImporter.hpp
+//  ForwardRenderer
+//
+//  parallel readers for the scan formats the models arrive in,
+//  Wavefront .obj and ascii or binary .ply, turning them into
+//  a MeshAsset for MeshIO::writeMeshAsset
+//
+
+#ifndef MeshImporter_hpp
+#define MeshImporter_hpp
+
+#include <cctype>
+
+#include "MeshIO.hpp"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshImporter Interface
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct MeshImporter
+    {
+    
+    //
+    //  importMesh
+    //
+    //  reads a Wavefront .obj or an ascii or binary .ply, chosen by
+    //  the extension, into an asset ready for writeMeshAsset. the
+    //  file is mapped and parsed in line aligned chunks across all
+    //  hardware threads. polygons are fanned into triangles and
+    //  normals are computed from the faces when the file has none
+    //
+    static bool importMesh (const char* path, MeshAsset& asset);
+    
+    static bool importOBJ (const char* path, MeshAsset& asset);
+    static bool importPLY (const char* path, MeshAsset& asset);
+    
+    //
+    //  computeNormals
+    //
+    //  area weighted vertex normals from the triangles using them.
+    //  positions no triangle uses get a zero normal
+    //
+    static void computeNormals
+            (const std::vector<glm::vec3> &positions,
+             const uint32_t               *indices,
+             size_t                        indexCount,
+             std::vector<glm::vec3>       &normals);
+    
+    //
+    //  parseFloat
+    //
+    //  decimal to float without locale or stream overhead, for the
+    //  importers. returns the character after the number, or
+    //  nullptr if no number starts at p (after spaces and tabs)
+    //
+    static const char* parseFloat (const char* p, const char* end, float& value);
+    
+    //
+    //  parseInt
+    //
+    //  the same for signed integers
+    //
+    static const char* parseInt (const char* p, const char* end, int64_t& value);
+    
+    //
+    //  splitLines
+    //
+    //  cuts [0, size) into at most chunks pieces, each ending just
+    //  after a newline, returned as the boundaries between them
+    //  starting at 0 and ending at size
+    //
+    static std::vector<size_t> splitLines (const char* data, size_t size, size_t chunks);
+
+    };
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  MeshImporter Implementation
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+bool MeshImporter::importMesh (const char* path, MeshAsset& asset)
+    { // MeshImporter :: importMesh
+    
+    std::string extension = path;
+    size_t      dot       = extension.find_last_of('.');
+    extension = dot == std::string::npos ? std::string() : extension.substr(dot + 1);
+    
+    for (char& c : extension)
+        c = (char)tolower((unsigned char)c);
+    
+    if (extension == "obj") return importOBJ(path, asset);
+    if (extension == "ply") return importPLY(path, asset);
+    
+    return false;
+    
+    } // MeshImporter :: importMesh
+
+const char* MeshImporter::parseFloat (const char* p, const char* end, float& value)
+    { // MeshImporter :: parseFloat
+    
+    static const double powers[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    
+    // 19 significant digits always fit the mantissa, any past
+    // that only shift the exponent. leading zeros do not count
+    uint64_t mantissa = 0;
+    int      digits   = 0;
+    int      exponent = 0;
+    bool     any      = false;
+    
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p)
+        {
+        any = true;
+        if (digits < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); digits += mantissa != 0; }
+        else               exponent++;
+        }
+    
+    if (p < end && *p == '.')
+        for (++p; p < end && (unsigned)(*p - '0') < 10; ++p)
+            {
+            any = true;
+            if (digits < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); digits += mantissa != 0; exponent--; }
+            }
+    
+    if (!any)
+        return nullptr;
+    
+    if (p < end && (*p == 'e' || *p == 'E'))
+        {
+        const char* q = p + 1;
+        
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            negativeExponent = *q++ == '-';
+        
+        if (q < end && (unsigned)(*q - '0') < 10)
+            {
+            int e = 0;
+            for (; q < end && (unsigned)(*q - '0') < 10; ++q)
+                e = std::min(e * 10 + (*q - '0'), 100000);
+            
+            exponent += negativeExponent ? -e : e;
+            p = q;
+            }
+        }
+    
+    double result = (double)mantissa;
+    
+    for (; exponent >  22; exponent -= 22) result *= 1e22;
+    for (; exponent < -22; exponent += 22) result /= 1e22;
+    
+    result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    
+    value = (float)(negative ? -result : result);
+    return p;
+    
+    } // MeshImporter :: parseFloat
+
+const char* MeshImporter::parseInt (const char* p, const char* end, int64_t& value)
+    { // MeshImporter :: parseInt
+    
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    
+    if (p == end || (unsigned)(*p - '0') >= 10)
+        return nullptr;
+    
+    int64_t result = 0;
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p)
+        result = result * 10 + (*p - '0');
+    
+    value = negative ? -result : result;
+    return p;
+    
+    } // MeshImporter :: parseInt
+
+std::vector<size_t> MeshImporter::splitLines (const char* data, size_t size, size_t chunks)
+    { // MeshImporter :: splitLines
+    
+    std::vector<size_t> bounds (1, 0);
+    
+    for (size_t c = 1; c < chunks; ++c)
+        {
+        size_t at = std::max(bounds.back(), size * c / chunks);
+        
+        const void* newline = at < size ? memchr(data + at, '\n', size - at) : nullptr;
+        if (!newline)
+            break;
+        
+        at = (size_t)((const char*)newline - data) + 1;
+        if (at > bounds.back() && at < size)
+            bounds.push_back(at);
+        }
+    
+    bounds.push_back(size);
+    return bounds;
+    
+    } // MeshImporter :: splitLines
+
+void MeshImporter::computeNormals
+        (const std::vector<glm::vec3> &positions,
+         const uint32_t               *indices,
+         size_t                        indexCount,
+         std::vector<glm::vec3>       &normals)
+    { // MeshImporter :: computeNormals
+    
+    normals.assign(positions.size(), glm::vec3(0.0f));
+    
+    // the unnormalised cross product is twice the triangle's
+    // area, which weights each face by its size
+    for (size_t t = 0; t + 2 < indexCount; t += 3)
+        {
+        uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+        glm::vec3 n = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+        normals[a] += n;
+        normals[b] += n;
+        normals[c] += n;
+        }
+    
+    Parallel::forRange(normals.size(), 1 << 16, [&normals] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t v = begin; v < end; ++v)
+            {
+            float length = glm::length(normals[v]);
+            if (length > 0.0f)
+                normals[v] /= length;
+            }
+        });
+    
+    } // MeshImporter :: computeNormals
+
+bool MeshImporter::importOBJ (const char* path, MeshAsset& asset)
+    { // MeshImporter :: importOBJ
+    
+    MappedFile file;
+    if (!file.open(path, MappedFile::Access::Sequential))
+        return false;
+    
+    const char*  text = reinterpret_cast<const char*>(file.data);
+    const size_t size = file.size;
+    
+    // several chunks per thread so uneven ones still balance
+    const std::vector<size_t> bounds = splitLines(text, size, std::min<size_t>(Parallel::threads() * 8, size / (1 << 20) + 1));
+    const size_t              chunks = bounds.size() - 1;
+    
+    auto space = [] (char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    
+    struct Counts
+        {
+        size_t positions = 0;
+        size_t uvs       = 0;
+        size_t normals   = 0;
+        size_t triangles = 0;
+        };
+    
+    // the first pass only counts each kind of line, so that the
+    // second can write every chunk's results straight into place
+    std::vector<Counts> counts (chunks + 1);
+    
+    Parallel::forRange(chunks, 1, [&] (size_t begin, size_t end, uint32_t)
+        {
+        for (size_t c = begin; c < end; ++c)
+            { // for each chunk
+            
+            Counts&     count = counts[c + 1];
+            const char* p     = text + bounds[c];
+            const char* last  = text + bounds[c + 1];
+            
+            while (p < last)
+                {
+                const char* eol = static_cast<const char*>(memchr(p, '\n', last - p));
+                if (!eol)
+                    eol = last;
+                
+                while (p < eol && space(*p))
+                    ++p;
+                
+                if (eol - p > 1 && p[0] == 'v' && space(p[1]))
+                    count.positions++;
+                else if (eol - p > 2 && p[0] == 'v' && p[1] == 't' && space(p[2]))
+                    count.uvs++;
+                else if (eol - p > 2 && p[0] == 'v' && p[1] == 'n' && space(p[2]))
+                    count.normals++;
+                else if (eol - p > 1 && p[0] == 'f' && space(p[1]))
+                    {
+                    size_t corners = 0;
+                    for (++p; p < eol; )
+                        {
+                        while (p < eol && space(*p))
+                            ++p;
+                        if (p == eol)
+                            break;
+                        corners++;
+                        while (p < eol && !space(*p))
+                            ++p;
+                        }
+                    if (corners > 2)
+                        count.triangles += corners - 2;
+                    }
+                
+                p = eol + 1;
+                }
+            
+            } // for each chunk
+        });
+    
+    for (size_t c = 1; c <= chunks; ++c)
+        {
+        counts[c].positions += counts[c - 1].positions;
+        counts[c].uvs       += counts[c - 1].uvs;
+        counts[c].normals   += counts[c - 1].normals;
+        counts[c].triangles += counts[c - 1].triangles;
+        }
+    
+    const Counts total = counts[chunks];
+    
+    // colours are the optional r g b trailing a position, and
+    // default to the grey the baked meshes use
+    std::vector<glm::vec3> positions (total.positions);
+    std::vector<glm::vec3> colors    (total.positions, glm::vec3(0.64f));
+    std::vector<glm::vec2> uvs       (total.uvs);
+    std::vector<glm::vec3> normals   (total.normals);
+    
+    // position, uv and normal of every triangle corner, one based
+    // with 0 for a reference the face left out
+    std::vector<uint32_t> corners (total.triangles * 9);
+    std::vector<uint8_t>  failed  (Parallel::threads(), 0);
+    
+    Parallel::forRange(chunks, 1, [&] (size_t begin, size_t end, uint32_t worker)
+        {
+        std::vector<uint32_t> polygon;
+        
+        for (size_t c = begin; c < end; ++c)
+            { // for each chunk
+            
+            size_t position = counts[c].positions;
+            size_t uv       = counts[c].uvs;
+            size_t normal   = counts[c].normals;
+            size_t corner   = counts[c].triangles * 9;
+            
+            const char* p    = text + bounds[c];
+            const char* last = text + bounds[c + 1];
+            
+            while (p < last)
+                { // for each line
+                
+                const char* eol = static_cast<const char*>(memchr(p, '\n', last - p));
+                if (!eol)
+                    eol = last;
+                
+                while (p < eol && space(*p))
+                    ++p;
+                
+                float values[7];
+                int   n = 0;
+                
+                if (eol - p > 1 && p[0] == 'v' && space(p[1]))
+                    {
+                    for (const char* q = p + 1; n < 7 && (q = parseFloat(q, eol, values[n])); ++n)
+                        ;
+                    if (n < 3)
+                        failed[worker] = 1;
+                    
+                    positions[position] = { values[0], values[1], values[2] };
+                    if (n >= 6)
+                        colors[position] = { values[n - 3], values[n - 2], values[n - 1] };
+                    position++;
+                    }
+                else if (eol - p > 2 && p[0] == 'v' && p[1] == 't' && space(p[2]))
+                    {
+                    values[1] = 0.0f;
+                    for (const char* q = p + 2; n < 2 && (q = parseFloat(q, eol, values[n])); ++n)
+                        ;
+                    if (n < 1)
+                        failed[worker] = 1;
+                    
+                    uvs[uv++] = { values[0], values[1] };
+                    }
+                else if (eol - p > 2 && p[0] == 'v' && p[1] == 'n' && space(p[2]))
+                    {
+                    for (const char* q = p + 2; n < 3 && (q = parseFloat(q, eol, values[n])); ++n)
+                        ;
+                    if (n < 3)
+                        failed[worker] = 1;
+                    
+                    normals[normal++] = { values[0], values[1], values[2] };
+                    }
+                else if (eol - p > 1 && p[0] == 'f' && space(p[1]))
+                    {
+                    polygon.clear();
+                    
+                    // tokens are split exactly as the counting pass
+                    // split them, so each face fills the triangles
+                    // it was counted for even when a token is bad
+                    for (++p; p < eol; )
+                        {
+                        while (p < eol && space(*p))
+                            ++p;
+                        if (p == eol)
+                            break;
+                        
+                        const char* token = p;
+                        while (p < eol && !space(*p))
+                            ++p;
+                        
+                        // v, v/vt, v//vn or v/vt/vn, negative
+                        // references counting back from here
+                        const size_t defined[3] = { position, uv, normal };
+                        uint32_t     reference[3] = { 0, 0, 0 };
+                        
+                        const char* q = token;
+                        for (int k = 0; k < 3 && q < p; ++k)
+                            {
+                            int64_t index = 0;
+                            const char* next = (q < p && *q != '/') ? parseInt(q, p, index) : q;
+                            
+                            if (next == nullptr)
+                                break;
+                            
+                            if (index < 0)
+                                index += (int64_t)defined[k] + 1;
+                            
+                            reference[k] = index > 0 && index <= 0xFFFFFFFF ? (uint32_t)index : 0;
+                            
+                            if (next == q && k == 0)
+                                break;
+                            
+                            q = next;
+                            if (q < p && *q == '/')
+                                ++q;
+                            else
+                                break;
+                            }
+                        
+                        polygon.insert(polygon.end(), reference, reference + 3);
+                        }
+                    
+                    for (size_t k = 6; k + 2 < polygon.size(); k += 3)
+                        {
+                        std::copy(polygon.begin(),         polygon.begin() + 3,     corners.begin() + corner);
+                        std::copy(polygon.begin() + k - 3, polygon.begin() + k + 3, corners.begin() + corner + 3);
+                        corner += 9;
+                        }
+                    }
+                
+                p = eol + 1;
+                
+                } // for each line
+            
+            } // for each chunk
+        });
+    
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+        return false;
+    
+    // every position must exist, uvs and normals may be left out,
+    // and normals are only trusted if every corner names one
+    std::vector<uint8_t> missingNormal (failed.size(), 0);
+    
+    Parallel::forRange(total.triangles * 3, 1 << 16, [&] (size_t begin, size_t end, uint32_t worker)
+        {
+        for (size_t k = begin; k < end; ++k)
+            {
+            const uint32_t* c = &corners[k * 3];
+            if (c[0] == 0 || c[0] > total.positions || c[1] > total.uvs || c[2] > total.normals)
+                failed[worker] = 1;
+            if (c[2] == 0)
+                missingNormal[worker] = 1;
+            }
+        });
+    
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+        return false;
+    
+    const bool hasNormals = total.normals > 0 && std::find(missingNormal.begin(), missingNormal.end(), 1) == missingNormal.end();
+    
+    std::vector<uint32_t> indices (total.triangles * 3);
+    for (size_t k = 0; k < indices.size(); ++k)
+        indices[k] = corners[k * 3] - 1;
+    
+    std::vector<glm::vec3> positionNormals;
+    if (!hasNormals)
+        computeNormals(positions, indices.data(), indices.size(), positionNormals);
+    
+    auto corner = [&] (size_t k)
+        {
+        const uint32_t* c = &corners[k * 3];
+        
+        Vertex vertex;
+            vertex.position = positions[c[0] - 1];
+            vertex.normal   = hasNormals ? normals[c[2] - 1] : positionNormals[c[0] - 1];
+            vertex.color    = colors[c[0] - 1];
+            vertex.uvs      = c[1] ? uvs[c[1] - 1] : glm::vec2(0.0f);
+            vertex.id       = 0;
+        
+        return vertex;
+        };
+    
+    asset = MeshAsset();
+    
+    // scans usually give each position one uv and normal, in which
+    // case the positions are the vertices. otherwise every corner
+    // becomes a vertex and identical ones are welded back together
+    const uint64_t unset = ~0ull;
+    std::vector<uint64_t> attributes (total.positions, unset);
+    std::vector<uint32_t> first      (total.positions, 0);
+    
+    bool shared = true;
+    for (size_t k = 0; k < indices.size() && shared; ++k)
+        {
+        uint64_t key = ((uint64_t)corners[k * 3 + 1] << 32) | (hasNormals ? corners[k * 3 + 2] : 0u);
+        
+        if (attributes[indices[k]] == unset)
+            {
+            attributes[indices[k]] = key;
+            first[indices[k]]      = (uint32_t)k;
+            }
+        else
+            shared = attributes[indices[k]] == key;
+        }
+    
+    if (shared)
+        {
+        asset.vertices.resize(total.positions);
+        
+        Parallel::forRange(total.positions, 1 << 16, [&] (size_t begin, size_t end, uint32_t)
+            {
+            for (size_t v = begin; v < end; ++v)
+                {
+                if (attributes[v] != unset)
+                    asset.vertices[v] = corner(first[v]);
+                else
+                    {
+                    asset.vertices[v]          = Vertex();
+                    asset.vertices[v].position = positions[v];
+                    asset.vertices[v].color    = colors[v];
+                    }
+                }
+            });
+        
+        asset.indices = std::move(indices);
+        }
+    else
+        {
+        asset.vertices.resize(indices.size());
+        
+        Parallel::forRange(indices.size(), 1 << 16, [&] (size_t begin, size_t end, uint32_t)
+            {
+            for (size_t k = begin; k < end; ++k)
+                {
+                asset.vertices[k] = corner(k);
+                indices[k]        = (uint32_t)k;
+                }
+            });
+        
+        asset.indices = std::move(indices);
+        MeshIO::weld(asset.indices, asset.vertices);
+        }
+    
+    return true;
+    
+    } // MeshImporter :: importOBJ
+
+bool MeshImporter::importPLY (const char* path, MeshAsset& asset)
+    { // MeshImporter :: importPLY
+    
+    MappedFile file;
+    if (!file.open(path, MappedFile::Access::Sequential))
+        return false;
+    
+    const char*  text = reinterpret_cast<const char*>(file.data);
+    const size_t size = file.size;
+    
+    enum Type   { eInt8, eUInt8, eInt16, eUInt16, eInt32, eUInt32, eFloat32, eFloat64, eUnknown };
+    enum Format { eAscii, eLittleEndian, eBigEndian };
+    
+    static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+    
+    auto typeOf = [] (const std::string& name)
+        {
+        if (name == "char"   || name == "int8")    return eInt8;
+        if (name == "uchar"  || name == "uint8")   return eUInt8;
+        if (name == "short"  || name == "int16")   return eInt16;
+        if (name == "ushort" || name == "uint16")  return eUInt16;
+        if (name == "int"    || name == "int32")   return eInt32;
+        if (name == "uint"   || name == "uint32")  return eUInt32;
+        if (name == "float"  || name == "float32") return eFloat32;
+        if (name == "double" || name == "float64") return eFloat64;
+        return eUnknown;
+        };
+    
+    struct Property
+        {
+        std::string name;
+        Type        type      = eUnknown; // of the items, for a list
+        Type        countType = eUnknown; // lists only
+        bool        list      = false;
+        size_t      offset    = 0;        // within a fixed size record
+        };
+    
+    struct Element
+        {
+        std::string           name;
+        size_t                count  = 0;
+        size_t                stride = 0;    // record size, when fixed
+        bool                  fixed  = true; // no list properties
+        std::vector<Property> properties;
+        };
+    
+    // the header is plain text ending in an end_header line
+    static const char marker[] = "end_header";
+    const char* headerEnd = std::search(text, text + size, marker, marker + sizeof(marker) - 1);
+    if (size < 4 || memcmp(text, "ply", 3) != 0 || headerEnd == text + size)
+        return false;
+    
+    const char* body = static_cast<const char*>(memchr(headerEnd, '\n', text + size - headerEnd));
+    if (!body)
+        return false;
+    body++;
+    
+    Format               format = eAscii;
+    std::vector<Element> elements;
+    
+    std::istringstream header (std::string(text, headerEnd));
+    std::string        line;
+    
+    while (std::getline(header, line))
+        { // for each header line
+        
+        std::istringstream words (line);
+        std::string        keyword;
+        words >> keyword;
+        
+        if (keyword == "format")
+            {
+            std::string name;
+            words >> name;
+            if      (name == "ascii")                format = eAscii;
+            else if (name == "binary_little_endian") format = eLittleEndian;
+            else if (name == "binary_big_endian")    format = eBigEndian;
+            else return false;
+            }
+        else if (keyword == "element")
+            {
+            Element element;
+            words >> element.name >> element.count;
+            elements.push_back(element);
+            }
+        else if (keyword == "property" && !elements.empty())
+            {
+            Element&    element = elements.back();
+            Property    property;
+            std::string type;
+            words >> type;
+            
+            if (type == "list")
+                {
+                std::string countType, itemType;
+                words >> countType >> itemType >> property.name;
+                property.list      = true;
+                property.countType = typeOf(countType);
+                property.type      = typeOf(itemType);
+                element.fixed      = false;
+                if (property.countType == eUnknown || property.countType >= eFloat32)
+                    return false;
+                }
+            else
+                {
+                words >> property.name;
+                property.type    = typeOf(type);
+                property.offset  = element.stride;
+                element.stride  += sizes[property.type];
+                }
+            
+            if (property.type == eUnknown)
+                return false;
+            
+            element.properties.push_back(property);
+            }
+        
+        } // for each header line
+    
+    const uint16_t probe      = 1;
+    const bool     bigEndian  = *reinterpret_cast<const uint8_t*>(&probe) == 0;
+    const bool     swap       = format != eAscii && (format == eBigEndian) != bigEndian;
+    
+    auto read = [swap] (const uint8_t* at, Type type) -> double
+        {
+        uint8_t bytes[8];
+        memcpy(bytes, at, sizes[type]);
+        if (swap)
+            std::reverse(bytes, bytes + sizes[type]);
+        
+        switch (type)
+            {
+            case eInt8:    { int8_t   v; memcpy(&v, bytes, 1); return v; }
+            case eUInt8:   { uint8_t  v; memcpy(&v, bytes, 1); return v; }
+            case eInt16:   { int16_t  v; memcpy(&v, bytes, 2); return v; }
+            case eUInt16:  { uint16_t v; memcpy(&v, bytes, 2); return v; }
+            case eInt32:   { int32_t  v; memcpy(&v, bytes, 4); return v; }
+            case eUInt32:  { uint32_t v; memcpy(&v, bytes, 4); return v; }
+            case eFloat32: { float    v; memcpy(&v, bytes, 4); return v; }
+            case eFloat64: { double   v; memcpy(&v, bytes, 8); return v; }
+            default:       return 0.0;
+            }
+        };
+    
+    // which property of the vertex element feeds each attribute
+    enum Role { eX, eY, eZ, eNX, eNY, eNZ, eRed, eGreen, eBlue, eU, eV, eRoles };
+    
+    const Element* vertexElement = nullptr;
+    const Element* faceElement   = nullptr;
+    
+    for (const Element& element : elements)
+        {
+        if (element.name == "vertex") vertexElement = &element;
+        if (element.name == "face")   faceElement   = &element;
+        }
+    
+    if (!vertexElement || !vertexElement->fixed)
+        return false;
+    
+    int   roles  [eRoles];
+    float scales [eRoles];
+    std::fill(roles,  roles  + eRoles, -1);
+    std::fill(scales, scales + eRoles, 1.0f);
+    
+    for (size_t i = 0; i < vertexElement->properties.size(); ++i)
+        {
+        const Property&    property = vertexElement->properties[i];
+        const std::string& name     = property.name;
+        
+        int role = name == "x"  ? eX  : name == "y"  ? eY  : name == "z"  ? eZ  :
+                   name == "nx" ? eNX : name == "ny" ? eNY : name == "nz" ? eNZ :
+                   name == "red"   || name == "r" ? eRed   :
+                   name == "green" || name == "g" ? eGreen :
+                   name == "blue"  || name == "b" ? eBlue  :
+                   name == "u" || name == "s" || name == "texture_u" || name == "texture_s" ? eU :
+                   name == "v" || name == "t" || name == "texture_v" || name == "texture_t" ? eV : -1;
+        
+        if (role < 0)
+            continue;
+        
+        roles[role] = (int)i;
+        
+        // integer colours span their type's range
+        if (role >= eRed && role <= eBlue)
+            scales[role] = property.type == eUInt8 ? 1.0f / 255.0f : property.type == eUInt16 ? 1.0f / 65535.0f : 1.0f;
+        }
+    
+    if (roles[eX] < 0 || roles[eY] < 0 || roles[eZ] < 0)
+        return false;
+    
+    const bool hasNormals = roles[eNX] >= 0 && roles[eNY] >= 0 && roles[eNZ] >= 0;
+    const bool hasColors  = roles[eRed] >= 0 && roles[eGreen] >= 0 && roles[eBlue] >= 0;
+    const bool hasUVs     = roles[eU] >= 0 && roles[eV] >= 0;
+    
+    int faceList = -1;
+    if (faceElement)
+        for (size_t i = 0; i < faceElement->properties.size(); ++i)
+            if (faceElement->properties[i].list &&
+                (faceElement->properties[i].name == "vertex_indices" || faceElement->properties[i].name == "vertex_index"))
+                faceList = (int)i;
+    
+    asset = MeshAsset();
+    asset.vertices.resize(vertexElement->count);
+    
+    // builds vertex v from get(index of a vertex property)
+    auto decode = [&] (size_t v, const auto& get)
+        {
+        Vertex& vertex = asset.vertices[v];
+        
+        vertex.position = { (float)get(roles[eX]), (float)get(roles[eY]), (float)get(roles[eZ]) };
+        vertex.normal   = hasNormals ? glm::vec3((float)get(roles[eNX]), (float)get(roles[eNY]), (float)get(roles[eNZ])) : glm::vec3(0.0f);
+        vertex.color    = hasColors  ? glm::vec3((float)get(roles[eRed])   * scales[eRed],
+                                                 (float)get(roles[eGreen]) * scales[eGreen],
+                                                 (float)get(roles[eBlue])  * scales[eBlue]) : glm::vec3(0.64f);
+        vertex.uvs      = hasUVs ? glm::vec2((float)get(roles[eU]), (float)get(roles[eV])) : glm::vec2(0.0f);
+        vertex.id       = 0;
+        };
+    
+    auto fan = [] (const std::vector<uint32_t>& polygon, std::vector<uint32_t>& triangles)
+        {
+        for (size_t k = 2; k < polygon.size(); ++k)
+            {
+            triangles.push_back(polygon[0]);
+            triangles.push_back(polygon[k - 1]);
+            triangles.push_back(polygon[k]);
+            }
+        };
+    
+    std::vector<uint8_t>  failed (Parallel::threads(), 0);
+    std::vector<uint32_t> indices;
+    
+    if (format == eAscii)
+        { // ascii body
+        
+        // one record per line, so knowing the line a chunk starts
+        // on tells it which element and record it starts in
+        const size_t              length = (size_t)(text + size - body);
+        const std::vector<size_t> bounds = splitLines(body, length, std::min<size_t>(Parallel::threads() * 8, length / (1 << 20) + 1));
+        const size_t              chunks = bounds.size() - 1;
+        
+        std::vector<size_t> lines (chunks + 1, 0);
+        
+        Parallel::forRange(chunks, 1, [&] (size_t begin, size_t end, uint32_t)
+            {
+            for (size_t c = begin; c < end; ++c)
+                lines[c + 1] = (size_t)std::count(body + bounds[c], body + bounds[c + 1], '\n');
+            });
+        
+        for (size_t c = 1; c <= chunks; ++c)
+            lines[c] += lines[c - 1];
+        
+        std::vector<size_t> firstLine (elements.size() + 1, 0);
+        for (size_t e = 0; e < elements.size(); ++e)
+            firstLine[e + 1] = firstLine[e] + elements[e].count;
+        
+        std::vector<std::vector<uint32_t>> triangles (chunks);
+        
+        Parallel::forRange(chunks, 1, [&] (size_t begin, size_t end, uint32_t worker)
+            {
+            std::vector<double>   values;
+            std::vector<uint32_t> polygon;
+            
+            for (size_t c = begin; c < end; ++c)
+                { // for each chunk
+                
+                size_t      line = lines[c];
+                size_t      e    = 0;
+                const char* p    = body + bounds[c];
+                const char* last = body + bounds[c + 1];
+                
+                for (; p < last; ++line)
+                    { // for each line
+                    
+                    const char* eol = static_cast<const char*>(memchr(p, '\n', last - p));
+                    if (!eol)
+                        eol = last;
+                    
+                    while (e < elements.size() && line >= firstLine[e + 1])
+                        e++;
+                    if (e == elements.size())
+                        break;
+                    
+                    const Element& element = elements[e];
+                    
+                    if (&element == vertexElement || &element == faceElement)
+                        {
+                        values.clear();
+                        polygon.clear();
+                        
+                        const char* q = p;
+                        
+                        for (size_t i = 0; i < element.properties.size() && q; ++i)
+                            {
+                            if (element.properties[i].list)
+                                {
+                                int64_t count = 0;
+                                q = parseInt(q, eol, count);
+                                
+                                for (int64_t k = 0; q && k < count; ++k)
+                                    {
+                                    int64_t index = 0;
+                                    q = parseInt(q, eol, index);
+                                    if (&element == faceElement && (int)i == faceList)
+                                        polygon.push_back((uint32_t)index);
+                                    }
+                                
+                                values.push_back(0.0);
+                                }
+                            else
+                                {
+                                float value = 0.0f;
+                                q = parseFloat(q, eol, value);
+                                values.push_back(value);
+                                }
+                            }
+                        
+                        if (!q)
+                            failed[worker] = 1;
+                        else if (&element == vertexElement)
+                            decode(line - firstLine[e], [&values] (int i) { return values[i]; });
+                        else
+                            fan(polygon, triangles[c]);
+                        }
+                    
+                    p = eol + 1;
+                    
+                    } // for each line
+                
+                } // for each chunk
+            });
+        
+        if (lines[chunks] + 1 < firstLine[elements.size()])
+            return false;
+        
+        for (const std::vector<uint32_t>& chunk : triangles)
+            indices.insert(indices.end(), chunk.begin(), chunk.end());
+        
+        } // ascii body
+    else
+        { // binary body
+        
+        const uint8_t* at   = reinterpret_cast<const uint8_t*>(body);
+        const uint8_t* stop = file.data + size;
+        
+        // steps over one record at a time, for elements with lists,
+        // gathering the face polygons when asked to
+        auto walk = [&] (const Element& element, std::vector<uint32_t>* triangles)
+            {
+            std::vector<uint32_t> polygon;
+            
+            for (size_t r = 0; r < element.count; ++r)
+                {
+                polygon.clear();
+                
+                for (size_t i = 0; i < element.properties.size(); ++i)
+                    {
+                    const Property& property = element.properties[i];
+                    
+                    if (!property.list)
+                        {
+                        if ((size_t)(stop - at) < sizes[property.type])
+                            return false;
+                        at += sizes[property.type];
+                        continue;
+                        }
+                    
+                    if ((size_t)(stop - at) < sizes[property.countType])
+                        return false;
+                    
+                    size_t count = (size_t)(int64_t)read(at, property.countType);
+                    at += sizes[property.countType];
+                    
+                    if ((size_t)(stop - at) / sizes[property.type] < count)
+                        return false;
+                    
+                    if (triangles && (int)i == faceList)
+                        for (size_t k = 0; k < count; ++k)
+                            polygon.push_back((uint32_t)(int64_t)read(at + k * sizes[property.type], property.type));
+                    
+                    at += count * sizes[property.type];
+                    }
+                
+                if (triangles)
+                    fan(polygon, *triangles);
+                }
+            
+            return true;
+            };
+        
+        for (const Element& element : elements)
+            { // for each element
+            
+            if (&element == vertexElement)
+                {
+                if ((size_t)(stop - at) / element.stride < element.count)
+                    return false;
+                
+                const uint8_t* records = at;
+                
+                Parallel::forRange(element.count, 1 << 14, [&] (size_t begin, size_t end, uint32_t)
+                    {
+                    for (size_t v = begin; v < end; ++v)
+                        {
+                        const uint8_t* record = records + v * element.stride;
+                        decode(v, [&] (int i) { return read(record + element.properties[i].offset, element.properties[i].type); });
+                        }
+                    });
+                
+                at += element.count * element.stride;
+                }
+            else if (&element == faceElement && faceList >= 0)
+                {
+                // scans are nearly always all triangles, which makes
+                // every record the same size and lets them be decoded
+                // in parallel. anything else takes the serial walk
+                size_t lists  = 0;
+                size_t before = 0;
+                size_t fixed  = 0;
+                
+                for (size_t i = 0; i < element.properties.size(); ++i)
+                    {
+                    const Property& property = element.properties[i];
+                    if (property.list)
+                        lists++;
+                    else
+                        {
+                        fixed += sizes[property.type];
+                        if ((int)i < faceList)
+                            before += sizes[property.type];
+                        }
+                    }
+                
+                const Property& list   = element.properties[faceList];
+                const size_t    stride = fixed + sizes[list.countType] + 3 * sizes[list.type];
+                
+                bool regular = lists == 1 && (size_t)(stop - at) / stride >= element.count;
+                
+                if (regular)
+                    {
+                    std::vector<uint8_t> irregular (failed.size(), 0);
+                    indices.resize(element.count * 3);
+                    
+                    const uint8_t* records = at;
+                    
+                    Parallel::forRange(element.count, 1 << 14, [&] (size_t begin, size_t end, uint32_t worker)
+                        {
+                        for (size_t f = begin; f < end; ++f)
+                            {
+                            const uint8_t* record = records + f * stride + before;
+                            
+                            if (read(record, list.countType) != 3.0)
+                                {
+                                irregular[worker] = 1;
+                                return;
+                                }
+                            
+                            record += sizes[list.countType];
+                            for (size_t k = 0; k < 3; ++k)
+                                indices[f * 3 + k] = (uint32_t)(int64_t)read(record + k * sizes[list.type], list.type);
+                            }
+                        });
+                    
+                    regular = std::find(irregular.begin(), irregular.end(), 1) == irregular.end();
+                    
+                    if (regular)
+                        at += element.count * stride;
+                    }
+                
+                if (!regular)
+                    {
+                    indices.clear();
+                    if (!walk(element, &indices))
+                        return false;
+                    }
+                }
+            else if (element.fixed)
+                {
+                if ((size_t)(stop - at) / std::max<size_t>(element.stride, 1) < element.count)
+                    return false;
+                at += element.count * element.stride;
+                }
+            else if (!walk(element, nullptr))
+                return false;
+            
+            } // for each element
+        
+        } // binary body
+    
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+        return false;
+    
+    const size_t vertexCount = asset.vertices.size();
+    
+    Parallel::forRange(indices.size(), 1 << 16, [&] (size_t begin, size_t end, uint32_t worker)
+        {
+        for (size_t k = begin; k < end; ++k)
+            if (indices[k] >= vertexCount)
+                failed[worker] = 1;
+        });
+    
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+        return false;
+    
+    if (!hasNormals)
+        {
+        std::vector<glm::vec3> positions (vertexCount), normals;
+        for (size_t v = 0; v < vertexCount; ++v)
+            positions[v] = asset.vertices[v].position;
+        
+        computeNormals(positions, indices.data(), indices.size(), normals);
+        
+        for (size_t v = 0; v < vertexCount; ++v)
+            asset.vertices[v].normal = normals[v];
+        }
+    
+    asset.indices = std::move(indices);
+    
+    return true;
+    
+    } // MeshImporter :: importPLY
+
+#endif /* MeshImporter_hpp */
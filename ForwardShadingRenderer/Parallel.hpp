@@ -0,0 +1,79 @@
+//
+//  Parallel.hpp
+//  ForwardRenderer
+//
+//  minimal fork/join helpers for the offline mesh passes,
+//  splitting a range of work evenly across hardware threads
+//
+
+#ifndef Parallel_hpp
+#define Parallel_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace Parallel
+    {
+
+    //
+    //  threads
+    //
+    //  the number of workers a parallel range will use at
+    //  most, never less than one
+    //
+    inline uint32_t threads ()
+        { // Parallel :: threads
+        uint32_t n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+        } // Parallel :: threads
+
+    //
+    //  workers
+    //
+    //  how many workers forRange will split count items
+    //  across, given each should get at least grain of them
+    //
+    inline uint32_t workers (size_t count, size_t grain)
+        { // Parallel :: workers
+        size_t chunks = grain ? count / grain : count;
+        return (uint32_t)std::max<size_t>(1, std::min<size_t>(threads(), chunks));
+        } // Parallel :: workers
+
+    //
+    //  forRange
+    //
+    //  calls body(begin, end, worker) over contiguous slices of
+    //  [0, count), one per worker, and waits for them all. small
+    //  ranges run on the calling thread
+    //
+    template <typename Body>
+    inline void forRange (size_t count, size_t grain, Body body)
+        { // Parallel :: forRange
+
+        const uint32_t n = workers(count, grain);
+
+        if (n == 1)
+            {
+            body((size_t)0, count, 0u);
+            return;
+            }
+
+        std::vector<std::thread> pool;
+        pool.reserve(n - 1);
+
+        for (uint32_t w = 1; w < n; ++w)
+            pool.emplace_back([=, &body] () { body(count * w / n, count * (w + 1) / n, w); });
+
+        body((size_t)0, count / n, 0u);
+
+        for (std::thread& thread : pool)
+            thread.join();
+
+        } // Parallel :: forRange
+
+    }
+
+#endif /* Parallel_hpp */
@@ -0,0 +1,192 @@
+//
+//  TaskPool.hpp
+//  ForwardRenderer
+//
+//  a fixed set of worker threads running submitted tasks in
+//  the order they arrive, each handing its result back through
+//  a future. used to load assets while the device is created,
+//  and to split per frame work without starting threads
+//
+
+#ifndef TaskPool_hpp
+#define TaskPool_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+class TaskPool
+    { // TaskPool
+public:
+
+    //
+    //  workers defaults to one per hardware thread, never less
+    //  than two so loads that mostly wait on the disk still
+    //  overlap on a single core machine
+    //
+    explicit TaskPool (uint32_t workers = 0)
+        { // TaskPool :: TaskPool
+
+        if (workers == 0)
+            workers = std::max(2u, std::thread::hardware_concurrency());
+
+        threads.reserve(workers);
+        for (uint32_t w = 0; w < workers; ++w)
+            threads.emplace_back([this] () { run(); });
+
+        } // TaskPool :: TaskPool
+
+    //
+    //  waits for every queued task to finish before the
+    //  workers are joined
+    //
+    ~TaskPool ()
+        { // TaskPool :: ~TaskPool
+
+            {
+            std::lock_guard<std::mutex> lock (mutex);
+            stopping = true;
+            }
+        wake.notify_all();
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        } // TaskPool :: ~TaskPool
+
+    TaskPool  (const TaskPool&)            = delete;
+    TaskPool& operator= (const TaskPool&)  = delete;
+
+    //
+    //  submit
+    //
+    //  queues task and returns a future for its result. tasks
+    //  start in submission order, so one that waits on futures
+    //  submitted before it can only ever wait on work that is
+    //  finished or already running
+    //
+    template <typename Task>
+    std::future<typename std::result_of<Task()>::type> submit (Task task)
+        { // TaskPool :: submit
+
+        typedef typename std::result_of<Task()>::type Result;
+
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(task);
+        std::future<Result> result = packaged->get_future();
+
+            {
+            std::lock_guard<std::mutex> lock (mutex);
+            queue.emplace_back([packaged] () { (*packaged)(); });
+            }
+        wake.notify_one();
+
+        return result;
+
+        } // TaskPool :: submit
+
+    //
+    //  forRange
+    //
+    //  calls body(begin, end, slice) over contiguous slices of
+    //  [0, count), each at least grain long, and waits for them
+    //  all, as Parallel::forRange does but on the workers. the
+    //  caller takes slices too, including any a worker still busy
+    //  with an earlier task has not reached, so work queued ahead
+    //  only costs the help that worker would have given
+    //
+    template <typename Body>
+    void forRange (size_t count, size_t grain, Body body)
+        { // TaskPool :: forRange
+
+        const size_t chunks = grain ? count / grain : count;
+        const size_t n      = std::max<size_t>(1, std::min<size_t>(threads.size() + 1, chunks));
+
+        if (n == 1)
+            {
+            body((size_t)0, count, 0u);
+            return;
+            }
+
+        // helpers that start after every slice is taken find none
+        // left and never touch body, so it can stay on our stack
+        struct Slices
+            {
+            std::atomic<size_t>     next     { 0 };
+            size_t                  finished = 0;
+            std::mutex              mutex;
+            std::condition_variable done;
+            };
+        std::shared_ptr<Slices> slices = std::make_shared<Slices>();
+
+        const Body* shared = &body;
+        auto work = [slices, shared, count, n] ()
+            {
+            for (size_t s = slices->next++; s < n; s = slices->next++)
+                {
+                (*shared)(count * s / n, count * (s + 1) / n, (uint32_t)s);
+
+                std::lock_guard<std::mutex> lock (slices->mutex);
+                if (++slices->finished == n)
+                    slices->done.notify_all();
+                }
+            };
+
+            {
+            std::lock_guard<std::mutex> lock (mutex);
+            for (size_t h = 1; h < n; ++h)
+                queue.emplace_back(work);
+            }
+        wake.notify_all();
+
+        work();
+
+        std::unique_lock<std::mutex> lock (slices->mutex);
+        slices->done.wait(lock, [&slices, n] () { return slices->finished == n; });
+
+        } // TaskPool :: forRange
+
+    uint32_t workers () const { return (uint32_t)threads.size(); }
+
+private:
+
+    void run ()
+        { // TaskPool :: run
+
+        for (;;)
+            {
+            std::function<void()> task;
+
+                {
+                std::unique_lock<std::mutex> lock (mutex);
+                wake.wait(lock, [this] () { return stopping || !queue.empty(); });
+
+                if (queue.empty())
+                    return;
+
+                task = std::move(queue.front());
+                queue.pop_front();
+                }
+
+            task();
+            }
+
+        } // TaskPool :: run
+
+    std::vector<std::thread>          threads;
+    std::deque<std::function<void()>> queue;
+    std::mutex                        mutex;
+    std::condition_variable           wake;
+    bool                              stopping = false;
+
+    }; // TaskPool
+
+#endif /* TaskPool_hpp */
@@ -118,41 +118,82 @@ void keyCallback (GLFWwindow* window, int key, int scancode, int action, int mod
 //      width   - horizontal size of the window
 //      height  - vertical size of the window
 //      title   - string to display in menu bar
+//      options - optional rendering paths to enable
 //      clear   - the colour to clear the screen with each frame
 //
 //  creates a window with a vulkan context configured for a forward
 //  shading architecture
 //
-VulkanApp::VulkanApp (uint32_t width, uint32_t height, std::string title, uint32_t objects, uint32_t id, glm::vec3 clear):
+VulkanApp::VulkanApp (uint32_t width, uint32_t height, std::string title, uint32_t objects, uint32_t id, VulkanOptions options, glm::vec3 clear):
         WINDOW_WIDTH  (width),
         WINDOW_HEIGHT (height),
         WINDOW_TITLE  (title),
         WINDOW_CLEAR  ({ clear.x, clear.y, clear.z, 1.0f }),
         window        (nullptr),
 		timing        (MAX_FPS),
-		nObjects      (objects)
+		options       (options),
+		nObjects      (objects),
+		farPlane      (std::max(100.0f, 4.0f * offset * std::sqrt((float)objects))),
+		meshCache     (new MeshCache(options.meshCache, options.meshCacheBytes))
     { // VulkanApp :: VulkanApp
 
 	runID = id;
 	timing.id = runID;
+
+	if (nObjects == 0)
+		ErrorHandler::fatal("At least one object is needed");
     
     if (createWindow           ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("GLFW Window Creation failure");
-    if (createSceneMesh        ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Failed to prepare a mesh");
+
+	// the meshes are mapped, optimized and batched on the pool
+	// while the instance, device and pipeline are created, and
+	// only waited on once the buffers need them. progressive
+	// meshes only bring in their coarsest level here and are
+	// refined from the render loop. a generated shape replaces
+	// the scans entirely, built at the budget asked for
+	std::vector<std::future<MeshView>> loads;
+	if (!options.meshShape.empty())
+		{
+		MeshGenerator::Shape shape;
+		if (!MeshGenerator::parse(options.meshShape, shape))
+			ErrorHandler::fatal("Unknown mesh shape " + options.meshShape);
+
+		loads.push_back(MeshIO::generateMesh(pool, shape, options.meshTriangles, runID));
+		}
+	else for (uint32_t i = 0; i < meshVariants; ++i)
+		{
+		const std::string path = "models/bust_" + std::to_string(i) + ".mesh";
+
+		if (options.progressiveMeshes && !options.packedVertices)
+			{
+			streaming.streams.emplace_back(new MeshStream());
+			loads.push_back(MeshIO::loadMeshStream(pool, path, *streaming.streams.back()));
+			}
+		else
+			loads.push_back(MeshIO::loadMesh(pool, path, options.optimizeMeshes ? meshCache.get() : nullptr));
+		}
+
+	std::future<vk::Result> scene = pool.submit([this, &loads] () { return createSceneMesh(loads); });
+
     if (createInstance         ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Vulkan instance creation failure");
     if (createDebugCallback    ()  != vk::Result::eSuccess) ErrorHandler::nonfatal ("Validation disabled");
     if (createSurface          ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Surface KHR creation failed");
     if (createDevice           ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Device creation failure");
     if (createSwapChain        ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Swapchain Creation failure");
     if (createDepthBuffer      ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Depth Buffer Creation failure");
-    if (createUniformBuffer    ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Uniform Buffer Creationn failure");
     if (createPipelineLayout   ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Pipeline Layout Creation failure");
-    if (createDescriptorSet    ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Descriptor Set Creation failure");
     if (createSemaphores       ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Semaphore creation failure");
     if (createRenderPass       ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Render Pass Creation failure");
     if (createFrameBuffers     ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Frame Buffer Creation failure");
+    if (createGraphicsPipeline ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Graphics Pipeline Creation failure");
+    if (createCullPipeline     ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Cull Pipeline Creation failure");
+    if (scene.get              ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Failed to prepare a mesh");
+    if (createUniformBuffer    ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Uniform Buffer Creationn failure");
     if (createVertexBuffer     ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Vertex Buffer Creation failure");
     if (createIndexBuffer      ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Index Buffer Creation failure");
-    if (createGraphicsPipeline ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Graphics Pipeline Creation failure");
+    if (createObjectBuffers    ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Object Buffer Creation failure");
+    if (createIndirectBuffer   ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Indirect Buffer Creation failure");
+    if (createDescriptorSet    ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Descriptor Set Creation failure");
     if (createCommandBuffers   ()  != vk::Result::eSuccess) ErrorHandler::fatal    ("Command Pool/Buffer creation failure");
 
 
@@ -173,8 +214,10 @@ VulkanApp::VulkanApp (uint32_t width, uint32_t height, std::string title, uint32
 VulkanApp::~VulkanApp ()
     { // VulkanApp :: ~VulkanApp
     
-    // destroy graphics pipeline
+    // destroy graphics pipelines
     core.logicalDevice.destroyPipeline(graphics.pipeline);
+    core.logicalDevice.destroyPipeline(graphics.depthPipeline);
+    core.logicalDevice.destroyPipeline(graphics.cullPipeline);
     
     // destroy semaphores
     core.logicalDevice.destroySemaphore(semaphores.imageAvailable);
@@ -183,10 +226,34 @@ VulkanApp::~VulkanApp ()
     // destroy vertex buffer
     core.logicalDevice.destroyBuffer(buffers.vertex.buffer);
     core.logicalDevice.freeMemory(buffers.vertex.memory);
+    core.logicalDevice.destroyBuffer(buffers.attributes.buffer);
+    core.logicalDevice.freeMemory(buffers.attributes.memory);
 
-    // destroy index buffer
+    // destroy index buffers
     core.logicalDevice.destroyBuffer(buffers.index.buffer);
     core.logicalDevice.freeMemory(buffers.index.memory);
+    core.logicalDevice.destroyBuffer(buffers.index16.buffer);
+    core.logicalDevice.freeMemory(buffers.index16.memory);
+
+    // destroy indirect buffer
+    core.logicalDevice.destroyBuffer(buffers.indirect.buffer);
+    core.logicalDevice.freeMemory(buffers.indirect.memory);
+
+    // destroy object buffers
+    core.logicalDevice.destroyBuffer(buffers.objects.buffer);
+    core.logicalDevice.freeMemory(buffers.objects.memory);
+    core.logicalDevice.destroyBuffer(buffers.instances.buffer);
+    core.logicalDevice.freeMemory(buffers.instances.memory);
+
+    // destroy cull pass buffers
+    core.logicalDevice.destroyBuffer(buffers.commands.buffer);
+    core.logicalDevice.freeMemory(buffers.commands.memory);
+    core.logicalDevice.destroyBuffer(buffers.draws.buffer);
+    core.logicalDevice.freeMemory(buffers.draws.memory);
+    core.logicalDevice.destroyBuffer(buffers.levels.buffer);
+    core.logicalDevice.freeMemory(buffers.levels.memory);
+    core.logicalDevice.destroyBuffer(buffers.objectDraws.buffer);
+    core.logicalDevice.freeMemory(buffers.objectDraws.memory);
 
     // destroy framebuffers
     for (uint32_t i = 0; i < swapchain.nImages; ++i)
@@ -264,40 +331,218 @@ vk::Result VulkanApp::createWindow ()
 //
 //  createSceneMesh
 //
-//  initializes a mesh to render
+//  initializes a mesh to render from whichever of the mesh
+//  variants loaded. runs on a pool worker alongside device
+//  creation, so it only touches the meshes, the simulation
+//  bounds and the quantization and atlas parts of the ubo. the
+//  uniform buffer is only created, and the ubo otherwise
+//  written, once it has finished
 //
-vk::Result VulkanApp::createSceneMesh ()
+vk::Result VulkanApp::createSceneMesh (std::vector<std::future<MeshView>>& loads)
     { // VulkanApp :: createSceneMesh
 
-	std::uniform_int_distribution<int> dist(0, 3);
-
-	// the four meshes are pre-loaded and selected from
-	// at random for each object, the selected mesh is then
-	// batched into the render mesh
-	std::vector<std::vector<Vertex>>   vBuffers(1);
-	std::vector<std::vector<uint32_t>> iBuffers(1);
+	// the variants are selected from at random for each object
+	// and batched into the render mesh. the files are mapped
+	// rather than read so batching copies straight out of the
+	// page cache. variants missing from disk are skipped
+	std::vector<MeshView>   views;
+	std::vector<MeshBounds> bounds;
+	std::vector<uint32_t>   sources; // variant each view was loaded from
 
-	for (uint32_t i = 0; i < 1; ++i)
+	for (uint32_t v = 0; v < loads.size(); ++v)
 		{ // for each mesh
 
-		std::string path = "models/bust_";
-		path += std::to_string(i);
-		path += ".mesh";
+		MeshView view = loads[v].get();
+		if (view.version == 0)
+			{
+			if (!streaming.streams.empty())
+				streaming.streams[v].reset();
+			continue;
+			}
+
+		sources.push_back(v);
 
-		MeshIO::readMeshFile(path.c_str(), vBuffers[i], iBuffers[i]);
+		// meshes written before bounds were stored get them here
+		bounds.push_back(view.hasBounds ? view.bounds : MeshIO::computeBounds(view.vertices.data, view.vertices.size));
+		views.push_back(std::move(view));
 
 		} // for each mesh
 
+	if (views.empty())
+		return vk::Result::eErrorInitializationFailed;
+
+	// objects are placed by their model origin, so two collide once
+	// the spheres about their origins holding the whole mesh touch
+	simulation.bounds = 0.0f;
+	for (const MeshBounds& b : bounds)
+		simulation.bounds = std::max(simulation.bounds, 2.0f * objectScale * (glm::length(b.center) + b.radius));
+
+	// a generator of our own, the shared one is in use on the
+	// main thread while this runs
+	std::default_random_engine            variants (runID);
+	std::uniform_int_distribution<size_t> dist     (0, views.size() - 1);
+
+	std::vector<uint32_t> models (nObjects);
+	for (uint32_t& model : models)
+		model = (uint32_t)dist(variants);
+
+	// instanced, each model in use is copied once and its objects
+	// all draw from that copy, telling themselves apart by their
+	// instance. otherwise every object gets a copy of its own,
+	// stamped with its id
+	std::vector<uint32_t> drawModels; // model each draw copies
+	meshes.objects.resize(nObjects);
+
+	if (options.instancedMeshes)
+		{
+		std::vector<uint32_t> copies (views.size(), UINT32_MAX);
+
+		for (uint32_t i = 0; i < nObjects; ++i)
+			{
+			if (copies[models[i]] == UINT32_MAX)
+				{
+				copies[models[i]] = static_cast<uint32_t>(drawModels.size());
+				drawModels.push_back(models[i]);
+				}
+
+			meshes.objects[i] = copies[models[i]];
+			}
+		}
+	else
+		{
+		drawModels = models;
+		for (uint32_t i = 0; i < nObjects; ++i)
+			meshes.objects[i] = i;
+		}
+
+	// every copy is batched in one merge, which sizes the
+	// arrays once and stamps the ids as it copies
+	const uint32_t nDraws = static_cast<uint32_t>(drawModels.size());
+
+	std::vector<MeshBatchItem> items (nDraws);
+
+	for (uint32_t d = 0; d < nDraws; ++d)
+		{
+		uint32_t model = drawModels[d];
+
+		items[d].vertices  = views[model].vertices;
+		items[d].indices   = views[model].indices;
+		items[d].indices16 = views[model].indices16;
+		items[d].id        = options.instancedMeshes ? 0 : static_cast<int32_t>(d);
+		}
+
+	MeshIO::merge(meshes.vertices, meshes.indices, items);
+
+	if (!streaming.streams.empty())
+		{
+		streaming.variants.resize(nDraws);
+		for (uint32_t d = 0; d < nDraws; ++d)
+			streaming.variants[d] = sources[drawModels[d]];
+		}
+
+	for (uint32_t d = 0; d < nDraws; ++d)
+		{ // for each mesh copy
+
+		uint32_t model      = drawModels[d];
+		size_t   first      = items[d].firstVertex;
+		size_t   firstIndex = items[d].firstIndex;
+
+		// the gpu copy of the indices is rebased to the object, with
+		// any levels of detail following the full mesh
+		const MeshView& view = views[model];
+
+		std::vector<uint32_t> local (meshes.indices.begin() + firstIndex, meshes.indices.begin() + firstIndex + items[d].indexCount());
+		for (uint32_t& index : local)
+			index -= (uint32_t)first;
+
+		VulkanMeshes::Draw draw;
+			draw.finest       = streaming.streams.empty() ? 0 : streaming.streams[sources[model]]->finest;
+			draw.objectCount  = 0;
+			draw.vertexOffset = static_cast<int32_t>(first);
+			draw.center       = bounds[model].center;
+			draw.radius       = bounds[model].radius;
+			draw.levels.push_back({ 0, static_cast<uint32_t>(local.size()), 0.0f });
+
+		// a streamed mesh is drawn through its coarse levels while
+		// the rest arrives, whether or not they are picked by distance
+		if (options.levelOfDetail || !streaming.streams.empty())
+			{
+			uint32_t base = static_cast<uint32_t>(local.size());
+			local.insert(local.end(), view.lodIndices.begin(),   view.lodIndices.end());
+			local.insert(local.end(), view.lodIndices16.begin(), view.lodIndices16.end());
+
+			for (const MeshLOD& lod : view.lods)
+				draw.levels.push_back({ base + lod.firstIndex, lod.indexCount, lod.error });
+			}
+
+		// anything under 65,536 vertices can go in the 16 bit
+		// buffer and the rest falls back on 32 bits. the count is
+		// what decides, a streamed mesh's indices are not all in
+		uint32_t offset;
+
+		if (options.smallIndices && view.vertices.size <= 65536 && MeshIO::narrowIndices(local.data(), local.size(), 0, meshes.indices16))
+			{
+			offset         = static_cast<uint32_t>(meshes.indices16.size() - local.size());
+			draw.indexType = vk::IndexType::eUint16;
+			}
+		else
+			{
+			offset         = static_cast<uint32_t>(meshes.indices32.size());
+			draw.indexType = vk::IndexType::eUint32;
+			meshes.indices32.insert(meshes.indices32.end(), local.begin(), local.end());
+			}
+
+		for (VulkanMeshes::Level& level : draw.levels)
+			level.firstIndex += offset;
+
+		draw.commandCount = options.instancedMeshes ? static_cast<uint32_t>(draw.levels.size()) : 1;
+
+		meshes.draws.push_back(draw);
+
+		} // for each mesh copy
+
+	// the commands of every 16 bit draw come ahead of the 32 bit
+	// ones, so each width is a single run of the indirect buffer
+	// that one call can draw, whatever the mix of meshes
+	meshes.commands = 0;
+
+	for (vk::IndexType type : { vk::IndexType::eUint16, vk::IndexType::eUint32 })
+		{
+		for (VulkanMeshes::Draw& draw : meshes.draws)
+			if (draw.indexType == type)
+				{
+				draw.firstCommand = meshes.commands;
+				meshes.commands  += draw.commandCount;
+				}
+
+		if (type == vk::IndexType::eUint16)
+			meshes.commands16 = meshes.commands;
+		}
+
+	// culled on the gpu, objects are appended to the command of
+	// whichever level they land on, so every command of a copy
+	// keeps a slot for each of its objects
 	for (uint32_t i = 0; i < nObjects; ++i)
-		{ // for each objectssss
+		meshes.draws[meshes.objects[i]].objectCount += 1;
 
-		uint32_t model = 0;
-		MeshIO::assign(vBuffers[model], i);
-		MeshIO::merge(meshes.vertices, meshes.indices, vBuffers[model], iBuffers[model]);
+	meshes.slots = 0;
+	for (const VulkanMeshes::Draw& draw : meshes.draws)
+		meshes.slots += options.gpuCulling ? draw.objectCount * draw.commandCount : draw.objectCount;
 
-		} // for each object
+	// objects are given a tile each of the uv atlas in the
+	// vertex shader, as instances share their texture coordinates
+	ubo.atlas = glm::vec4(std::floor(std::sqrt((float)nObjects)), 0.0f, 0.0f, 0.0f);
 
-	MeshIO::atlas(meshes.vertices, nObjects, 1080);
+	// the packed layout is what gets uploaded when enabled, the
+	// full precision copy is kept for the cpu side bookkeeping
+	if (options.packedVertices)
+		{
+		MeshQuantization quantization = MeshIO::quantize(meshes.vertices.data(), meshes.vertices.size(), meshes.packed);
+		ubo.positionOffset = quantization.offset;
+		ubo.positionScale  = quantization.scale;
+		}
+	else if (options.splitVertexStreams)
+		MeshIO::splitStreams(meshes.vertices.data(), meshes.vertices.size(), meshes.positions, meshes.attributes);
 
 	return vk::Result::eSuccess;
     
@@ -510,6 +755,24 @@ vk::Result VulkanApp::createDevice ()
     const std::vector<const char*> extensions =
         { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
+    // indirect commands start their instances part way into the
+    // instance buffer, which every desktop device supports. many
+    // commands in one indirect call is taken when on offer, and
+    // otherwise each is recorded as a call of its own
+    vk::PhysicalDeviceFeatures supported = core.physicalDevice.getFeatures();
+    vk::PhysicalDeviceFeatures enabled   = { };
+
+    if (!supported.drawIndirectFirstInstance)
+        {
+        ErrorHandler::nonfatal("Device does not support drawIndirectFirstInstance");
+        return vk::Result::eErrorFeatureNotPresent;
+        }
+
+    enabled.drawIndirectFirstInstance = VK_TRUE;
+    enabled.multiDrawIndirect         = supported.multiDrawIndirect;
+
+    features.maxDrawIndirectCount = supported.multiDrawIndirect ? core.physicalDevice.getProperties().limits.maxDrawIndirectCount : 1;
+
     vk::DeviceCreateInfo deviceCreateInfo = { };
         deviceCreateInfo.queueCreateInfoCount    = static_cast<uint32_t>(queueCreationInfos.size());
         deviceCreateInfo.pQueueCreateInfos       = queueCreationInfos.data();
@@ -517,7 +780,7 @@ vk::Result VulkanApp::createDevice ()
         deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
         deviceCreateInfo.enabledLayerCount       = 0;
         deviceCreateInfo.ppEnabledLayerNames     = nullptr;
-        deviceCreateInfo.pEnabledFeatures        = nullptr;
+        deviceCreateInfo.pEnabledFeatures        = &enabled;
 
     result = candidateDevices[0].createDevice(&deviceCreateInfo, nullptr, &core.logicalDevice);
 
@@ -701,7 +964,7 @@ vk::Result VulkanApp::createUniformBuffer ()
     { // Vulkan :: createUniformBuffer
     vk::Result result = vk::Result::eSuccess;
     
-    ubo.proj = glm::perspective((float)(WINDOW_WIDTH / WINDOW_HEIGHT), 1.0f, 0.01f, 100.0f);
+    ubo.proj = glm::perspective((float)(WINDOW_WIDTH / WINDOW_HEIGHT), 1.0f, 0.01f, farPlane);
     ubo.proj[1][1] *= -1;
 
 	eyePosition.y = sqrt(nObjects) * 2.0f;
@@ -711,12 +974,6 @@ vk::Result VulkanApp::createUniformBuffer ()
         glm::vec3 { 0.0f, 0.0f, 1.0f },  // center
         glm::vec3 { 0.0f, 0.0f, 1.00f }); // world up
     
-
-	std::uniform_real_distribution<float> dist(0.0, 1.0);
-	rng.seed(time(0));
-	for (uint32_t i = 0; i < nObjects; ++i)
-		ubo.materials[i] = { dist(rng), dist(rng), dist(rng), dist(rng) };
-
     ubo.lightPosition = lightPosition;
     ubo.eyePosition = eyePosition;
     
@@ -781,6 +1038,63 @@ vk::Result VulkanApp::createUniformBuffer ()
     } // Vulkan :: createUniformBuffer
 
 
+//
+//  createObjectBuffers
+//
+//  storage buffers sized by the number of objects for what each
+//  object has of its own, its transform and material, and for
+//  the object behind each instance slot. they are host visible
+//  and written in place by updateUniforms and selectLevels, but
+//  for the instances when the cull pass fills them on the gpu
+//
+vk::Result VulkanApp::createObjectBuffers ()
+    { // VulkanApp :: createObjectBuffers
+    
+    const vk::DeviceSize objectSize   = sizeof(ObjectData) * nObjects;
+    const vk::DeviceSize instanceSize = sizeof(uint32_t)   * meshes.slots;
+    
+    // a storage buffer can only be bound as far as the device
+    // allows, 128mb or about 1.6 million objects at the least
+    vk::PhysicalDeviceProperties properties = core.physicalDevice.getProperties();
+    
+    if (objectSize > properties.limits.maxStorageBufferRange || instanceSize > properties.limits.maxStorageBufferRange)
+        {
+        ErrorHandler::nonfatal("Too many objects for one storage buffer, at most " + std::to_string(properties.limits.maxStorageBufferRange / sizeof(ObjectData)));
+        return vk::Result::eErrorOutOfDeviceMemory;
+        }
+    
+	std::uniform_real_distribution<float> dist(0.0, 1.0);
+	rng.seed(time(0));
+	objects.materials.resize(nObjects);
+	for (uint32_t i = 0; i < nObjects; ++i)
+		objects.materials[i] = { dist(rng), dist(rng), dist(rng), dist(rng) };
+
+	objects.instances.resize(nObjects);
+	for (uint32_t i = 0; i < nObjects; ++i)
+		objects.instances[i] = i;
+    
+    createBuffer(
+        objectSize,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+        vk::MemoryPropertyFlagBits::eHostCoherent,
+        buffers.objects.buffer,
+        buffers.objects.memory);
+    
+    createBuffer(
+        instanceSize,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        options.gpuCulling ? vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal) :
+        vk::MemoryPropertyFlagBits::eHostVisible |
+        vk::MemoryPropertyFlagBits::eHostCoherent,
+        buffers.instances.buffer,
+        buffers.instances.memory);
+    
+    return vk::Result::eSuccess;
+    
+    } // VulkanApp :: createObjectBuffers
+
+
 //
 //
 //
@@ -790,15 +1104,27 @@ vk::Result VulkanApp::createPipelineLayout ()
     
     graphics.layouts.push_back(vk::DescriptorSetLayout());
     
-    vk::DescriptorSetLayoutBinding layoutBinding = { };
-        layoutBinding.binding             = 0;
-        layoutBinding.descriptorType      = vk::DescriptorType::eUniformBuffer;
-        layoutBinding.descriptorCount     = 1;
-        layoutBinding.stageFlags          = vk::ShaderStageFlagBits::eVertex;
-        layoutBinding.pImmutableSamplers  = nullptr;
+    // the shared uniforms, then the per object and per instance
+    // storage buffers, all read by the vertex shaders. the cull
+    // pass shares them, and has the draws, their levels, the draw
+    // of each object and the indirect commands after them
+    std::vector<vk::DescriptorSetLayoutBinding> layoutBindings (options.gpuCulling ? 7 : 3);
+    
+    for (uint32_t b = 0; b < layoutBindings.size(); ++b)
+        {
+        layoutBindings[b].binding             = b;
+        layoutBindings[b].descriptorType      = b == 0 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+        layoutBindings[b].descriptorCount     = 1;
+        layoutBindings[b].stageFlags          = b < 3 ? vk::ShaderStageFlagBits::eVertex : vk::ShaderStageFlagBits::eCompute;
+        layoutBindings[b].pImmutableSamplers  = nullptr;
+        
+        if (options.gpuCulling)
+            layoutBindings[b].stageFlags |= vk::ShaderStageFlagBits::eCompute;
+        }
+    
     vk::DescriptorSetLayoutCreateInfo descriptorCreateInfo = { };
-        descriptorCreateInfo.bindingCount = 1;
-        descriptorCreateInfo.pBindings    = &layoutBinding;
+        descriptorCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+        descriptorCreateInfo.pBindings    = layoutBindings.data();
         
     result = core.logicalDevice.createDescriptorSetLayout(
         &descriptorCreateInfo,
@@ -840,9 +1166,11 @@ vk::Result VulkanApp::createDescriptorSet ()
     
     // first we'll need a descriptor pool from
     // which to allocate our descriptor sets
-    std::array<vk::DescriptorPoolSize, 1> poolSizes;
+    std::array<vk::DescriptorPoolSize, 2> poolSizes;
         poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
         poolSizes[0].descriptorCount = 1;
+        poolSizes[1].type = vk::DescriptorType::eStorageBuffer;
+        poolSizes[1].descriptorCount = options.gpuCulling ? 6 : 2;
     vk::DescriptorPoolCreateInfo poolCreateInfo = { };
         poolCreateInfo.maxSets       = 1;
         poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());;
@@ -876,22 +1204,45 @@ vk::Result VulkanApp::createDescriptorSet ()
         } // failed to create descriptor set
         
     // then we prepare to write the descriptor
-    // set to the device. initially this will
-    // only contain the uniform buffer object
-    vk::DescriptorBufferInfo bufferInfo = { };
-        bufferInfo.buffer = buffers.uniform.buffer;
-        bufferInfo.offset = 0;
-        bufferInfo.range  = sizeof(UniformBufferObject);
-    
-    vk::WriteDescriptorSet writes = { };
-        writes.dstSet          = graphics.descriptorSet;
-        writes.descriptorCount = 1;
-        writes.descriptorType  = vk::DescriptorType::eUniformBuffer;
-        writes.pBufferInfo     = &bufferInfo;
-        writes.dstArrayElement = 0;
-        writes.dstBinding      = 0;
-        
-    core.logicalDevice.updateDescriptorSets(1, &writes, 0, nullptr);
+    // set to the device, the uniform buffer object
+    // followed by the object and instance buffers
+    // and whatever the cull pass reads and writes
+    std::array<vk::DescriptorBufferInfo, 7> bufferInfos = { };
+        bufferInfos[0].buffer = buffers.uniform.buffer;
+        bufferInfos[0].offset = 0;
+        bufferInfos[0].range  = sizeof(UniformBufferObject);
+        bufferInfos[1].buffer = buffers.objects.buffer;
+        bufferInfos[1].offset = 0;
+        bufferInfos[1].range  = sizeof(ObjectData) * nObjects;
+        bufferInfos[2].buffer = buffers.instances.buffer;
+        bufferInfos[2].offset = 0;
+        bufferInfos[2].range  = sizeof(uint32_t) * meshes.slots;
+        bufferInfos[3].buffer = buffers.draws.buffer;
+        bufferInfos[3].offset = 0;
+        bufferInfos[3].range  = sizeof(DrawData) * meshes.draws.size();
+        bufferInfos[4].buffer = buffers.levels.buffer;
+        bufferInfos[4].offset = 0;
+        bufferInfos[4].range  = VK_WHOLE_SIZE;
+        bufferInfos[5].buffer = buffers.objectDraws.buffer;
+        bufferInfos[5].offset = 0;
+        bufferInfos[5].range  = sizeof(uint32_t) * nObjects;
+        bufferInfos[6].buffer = buffers.indirect.buffer;
+        bufferInfos[6].offset = 0;
+        bufferInfos[6].range  = sizeof(vk::DrawIndexedIndirectCommand) * meshes.commands;
+    
+    std::vector<vk::WriteDescriptorSet> writes (options.gpuCulling ? 7 : 3);
+    
+    for (uint32_t b = 0; b < writes.size(); ++b)
+        {
+        writes[b].dstSet          = graphics.descriptorSet;
+        writes[b].descriptorCount = 1;
+        writes[b].descriptorType  = b == 0 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+        writes[b].pBufferInfo     = &bufferInfos[b];
+        writes[b].dstArrayElement = 0;
+        writes[b].dstBinding      = b;
+        }
+        
+    core.logicalDevice.updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
     
     return result;
     
@@ -1062,8 +1413,23 @@ vk::Result VulkanApp::createVertexBuffer ()
     vk::Result result = vk::Result::eSuccess;
     
     // first we create a buffer for the vertices so
-    // we can get them onto VRAM / device memory
-    vk::DeviceSize bufferSize = sizeof(Vertex) * meshes.vertices.size ();
+    // we can get them onto VRAM / device memory. it holds
+    // whichever layout binding 0 reads, the positions
+    // alone when the streams are split
+    const void*    source     = meshes.vertices.data();
+    vk::DeviceSize bufferSize = sizeof(Vertex) * meshes.vertices.size();
+    
+    if (options.packedVertices)
+        {
+        source     = meshes.packed.data();
+        bufferSize = sizeof(PackedVertex) * meshes.packed.size();
+        }
+    else if (options.splitVertexStreams)
+        {
+        source     = meshes.positions.data();
+        bufferSize = sizeof(VertexPosition) * meshes.positions.size();
+        }
+    
     vk::BufferCreateInfo createInfo = { };
         createInfo.usage = vk::BufferUsageFlagBits::eVertexBuffer;
         createInfo.size  = bufferSize;
@@ -1109,7 +1475,7 @@ vk::Result VulkanApp::createVertexBuffer ()
     if (result != vk::Result::eSuccess)
         return result;
         
-    memcpy(data, meshes.vertices.data(), (size_t)bufferSize);
+    memcpy(data, source, (size_t)bufferSize);
     core.logicalDevice.unmapMemory(buffers.vertex.memory);
     
     core.logicalDevice.bindBufferMemory(
@@ -1117,77 +1483,207 @@ vk::Result VulkanApp::createVertexBuffer ()
         buffers.vertex.memory,
         0);
 
+    // the other attributes of a split vertex go in a
+    // second buffer, bound to binding 1 beside it
+    if (!meshes.attributes.empty())
+        {
+        const vk::DeviceSize attributeSize = sizeof(VertexAttributes) * meshes.attributes.size();
+        
+        createBuffer(
+            attributeSize,
+            vk::BufferUsageFlagBits::eVertexBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+            buffers.attributes.buffer,
+            buffers.attributes.memory);
+        
+        result = core.logicalDevice.mapMemory(buffers.attributes.memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags { }, &data);
+        
+        if (result != vk::Result::eSuccess)
+            return result;
+        
+        memcpy(data, meshes.attributes.data(), (size_t)attributeSize);
+        core.logicalDevice.unmapMemory(buffers.attributes.memory);
+        }
+
     return result;
     
     } // VulkanApp :: createVertexBuffer
 
 
 //
+//  createIndexBuffer
 //
+//  uploads the 16 and 32 bit object indices into
+//  their own buffers, skipping whichever is empty
 //
 vk::Result VulkanApp::createIndexBuffer ()
     { // VulkanApp :: createIndexBuffer
     vk::Result result = vk::Result::eSuccess;
     
-    // first we create a buffer for the vertices so
-    // we can get them onto VRAM / device memory
-    vk::DeviceSize bufferSize = sizeof(uint32_t) * meshes.indices.size ();
-    vk::BufferCreateInfo createInfo = { };
-        createInfo.usage = vk::BufferUsageFlagBits::eIndexBuffer;
-        createInfo.size  = bufferSize;
-        createInfo.queueFamilyIndexCount = 0;
-        createInfo.pQueueFamilyIndices = nullptr;
-        createInfo.sharingMode = vk::SharingMode::eExclusive;
+    struct Upload {
+        const void*                  source;
+        vk::DeviceSize               size;
+        VulkanBuffers::VulkanBuffer* destination;
+    };
+    
+    std::array<Upload, 2> uploads = { {
+        { meshes.indices16.data(), sizeof(uint16_t) * meshes.indices16.size(), &buffers.index16 },
+        { meshes.indices32.data(), sizeof(uint32_t) * meshes.indices32.size(), &buffers.index   }
+    } };
+    
+    for (const Upload& upload : uploads)
+        { // for each index width
         
-    result = core.logicalDevice.createBuffer(
-        &createInfo,
-        nullptr,
-        &buffers.index.buffer);
+        // vulkan does not allow zero sized buffers, a width
+        // no object uses is simply left as a null handle
+        if (upload.size == 0)
+            continue;
         
-    if (result != vk::Result::eSuccess)
-        return result;
+        createBuffer(
+            upload.size,
+            vk::BufferUsageFlagBits::eIndexBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+            upload.destination->buffer,
+            upload.destination->memory);
         
-    // we query the device for the requirements of
-    // our buffer's memory including size and type
-    vk::MemoryRequirements requirements = { };
-    core.logicalDevice.getBufferMemoryRequirements(buffers.index.buffer, &requirements);
-
-    // once we have a buffer and know about the memory
-    // we're going to allocate we can perform the VRAM
-    // allocation and crash on failure
-    vk::MemoryAllocateInfo allocationInfo = { };
-    allocationInfo.memoryTypeIndex = VulkanHelpers::findMemoryType(
-        core.physicalDevice,
-        requirements.memoryTypeBits,
-        vk::MemoryPropertyFlagBits::eHostVisible |
-        vk::MemoryPropertyFlagBits::eHostCoherent);
-    allocationInfo.allocationSize = requirements.size;
+        void* data;
+        result = core.logicalDevice.mapMemory(upload.destination->memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags {}, &data);
+        
+        if (result != vk::Result::eSuccess)
+            return result;
+        
+        memcpy(data, upload.source, (size_t)upload.size);
+        core.logicalDevice.unmapMemory(upload.destination->memory);
+        
+        } // for each index width
         
-    result = core.logicalDevice.allocateMemory(&allocationInfo, nullptr, &buffers.index.memory);
+    return result;
+    
+    } // VulkanApp :: createIndexBuffer
 
-    if (result != vk::Result::eSuccess)
-        return result;
 
-    // now the VRAM on the graphics card is sitting
-    // allocated and empty we can copy our index
-    // data across, once again crashing on failure
-    void* data;
-    result = core.logicalDevice.mapMemory(buffers.index.memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags {}, &data);
-   
-    if (result != vk::Result::eSuccess)
-        return result;
+//
+//  createIndirectBuffer
+//
+//  draw commands, one per object or, when instanced, one per
+//  level of each mesh. they are host visible and filled in by
+//  selectLevels before each frame, unless culling on the gpu,
+//  where they stay on the device and are reset from a copy
+//  with no instances before the cull pass fills them. the
+//  copy, the draws, their levels and the draw of each object
+//  are what the pass is given to work from
+//
+vk::Result VulkanApp::createIndirectBuffer ()
+    { // VulkanApp :: createIndirectBuffer
+    
+    const vk::DeviceSize commandSize = sizeof(vk::DrawIndexedIndirectCommand) * meshes.commands;
+    
+    if (!options.gpuCulling)
+        {
+        createBuffer(
+            commandSize,
+            vk::BufferUsageFlagBits::eIndirectBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+            buffers.indirect.buffer,
+            buffers.indirect.memory);
+        
+        cullObjects();
+        selectLevels();
         
-    memcpy(data, meshes.indices.data(), (size_t)bufferSize);
-    core.logicalDevice.unmapMemory(buffers.index.memory);
+        return vk::Result::eSuccess;
+        }
     
-    core.logicalDevice.bindBufferMemory(
-        buffers.index.buffer,
-        buffers.index.memory,
-        0);
+    createBuffer(
+        commandSize,
+        vk::BufferUsageFlagBits::eIndirectBuffer |
+        vk::BufferUsageFlagBits::eStorageBuffer  |
+        vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        buffers.indirect.buffer,
+        buffers.indirect.memory);
+    
+    // every command reserves a slot for each object of its copy,
+    // so the pass can append to any of them without overflowing.
+    // a copy per object has its one command pointed at whichever
+    // level the object lands on by the pass itself
+    std::vector<vk::DrawIndexedIndirectCommand> commands (meshes.commands);
+    std::vector<DrawData>                       draws    (meshes.draws.size());
+    std::vector<VulkanMeshes::Level>            levels;
+    
+    uint32_t slot = 0;
+    
+    for (uint32_t d = 0; d < meshes.draws.size(); ++d)
+        { // for each mesh copy
+        
+        const VulkanMeshes::Draw& draw = meshes.draws[d];
+        
+        for (uint32_t c = 0; c < draw.commandCount; ++c)
+            {
+            const VulkanMeshes::Level& level = draw.levels[draw.commandCount > 1 ? c : draw.finest];
+            
+            vk::DrawIndexedIndirectCommand& command = commands[draw.firstCommand + c];
+                command.indexCount    = level.indexCount;
+                command.instanceCount = 0;
+                command.firstIndex    = level.firstIndex;
+                command.vertexOffset  = draw.vertexOffset;
+                command.firstInstance = slot;
+            
+            slot += draw.objectCount;
+            }
+        
+        draws[d].sphere       = glm::vec4(draw.center, draw.radius);
+        draws[d].firstCommand = draw.firstCommand;
+        draws[d].commandCount = draw.commandCount;
+        draws[d].firstLevel   = static_cast<uint32_t>(levels.size());
+        draws[d].levelCount   = static_cast<uint32_t>(draw.levels.size());
+        draws[d].finest       = draw.finest;
+        
+        levels.insert(levels.end(), draw.levels.begin(), draw.levels.end());
+        
+        } // for each mesh copy
+    
+    struct Upload {
+        const void*                  source;
+        vk::DeviceSize               size;
+        VulkanBuffers::VulkanBuffer* destination;
+        vk::BufferUsageFlags         usage;
+    };
+    
+    std::array<Upload, 4> uploads = { {
+        { commands.data(),       commandSize,                                 &buffers.commands,    vk::BufferUsageFlagBits::eTransferSrc   },
+        { draws.data(),          sizeof(DrawData) * draws.size(),             &buffers.draws,       vk::BufferUsageFlagBits::eStorageBuffer },
+        { levels.data(),         sizeof(VulkanMeshes::Level) * levels.size(), &buffers.levels,      vk::BufferUsageFlagBits::eStorageBuffer },
+        { meshes.objects.data(), sizeof(uint32_t) * meshes.objects.size(),    &buffers.objectDraws, vk::BufferUsageFlagBits::eStorageBuffer }
+    } };
+    
+    for (const Upload& upload : uploads)
+        { // for each buffer the pass reads
+        
+        createBuffer(
+            upload.size,
+            upload.usage,
+            vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+            upload.destination->buffer,
+            upload.destination->memory);
+        
+        void* data;
+        vk::Result result = core.logicalDevice.mapMemory(upload.destination->memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags {}, &data);
         
-    return result;
+        if (result != vk::Result::eSuccess)
+            return result;
+        
+        memcpy(data, upload.source, (size_t)upload.size);
+        core.logicalDevice.unmapMemory(upload.destination->memory);
+        
+        } // for each buffer the pass reads
     
-    } // VulkanApp :: createIndexBuffer
+    return vk::Result::eSuccess;
+    
+    } // VulkanApp :: createIndirectBuffer
 
 
 //
@@ -1199,22 +1695,50 @@ vk::Result VulkanApp::createGraphicsPipeline ()
     
     vk::PipelineShaderStageCreateInfo shaderStages[] =
         {
-        VulkanShaders::loadShader(core.logicalDevice, "shaders/vert.spv", vk::ShaderStageFlagBits::eVertex),
+        VulkanShaders::loadShader(core.logicalDevice, options.packedVertices ? "shaders/vert_packed.spv" : "shaders/vert.spv", vk::ShaderStageFlagBits::eVertex),
         VulkanShaders::loadShader(core.logicalDevice, "shaders/frag.spv", vk::ShaderStageFlagBits::eFragment)
         };
         
-     vk::VertexInputBindingDescription inputBinding = { };
-        inputBinding.binding    = 0;
-        inputBinding.stride     = sizeof(Vertex);
-        inputBinding.inputRate  = vk::VertexInputRate::eVertex;
-        
-    std::array<vk::VertexInputAttributeDescription, 5> attributes = Vertex::attributeDescriptions();
+    const bool split = options.splitVertexStreams && !options.packedVertices;
+    
+    // split vertices read positions from binding 0 and the
+    // rest from binding 1, everything else is one stream
+    vk::VertexInputBindingDescription inputBindings[2] = { };
+        inputBindings[0].binding    = 0;
+        inputBindings[0].stride     = options.packedVertices ? sizeof(PackedVertex) : split ? sizeof(VertexPosition) : sizeof(Vertex);
+        inputBindings[0].inputRate  = vk::VertexInputRate::eVertex;
+        inputBindings[1].binding    = 1;
+        inputBindings[1].stride     = sizeof(VertexAttributes);
+        inputBindings[1].inputRate  = vk::VertexInputRate::eVertex;
+        
+    std::vector<vk::VertexInputAttributeDescription> attributes;
+    std::vector<vk::VertexInputAttributeDescription> depthAttributes;
+    if (options.packedVertices)
+        {
+        std::array<vk::VertexInputAttributeDescription, 4> packed = PackedVertex::attributeDescriptions();
+        attributes.assign(packed.begin(), packed.end());
+        }
+    else if (split)
+        {
+        std::array<vk::VertexInputAttributeDescription, 2> position = VertexPosition::attributeDescriptions(0);
+        std::array<vk::VertexInputAttributeDescription, 3> rest     = VertexAttributes::attributeDescriptions(1);
+        attributes.assign(position.begin(), position.end());
+        attributes.insert(attributes.end(), rest.begin(), rest.end());
+        depthAttributes.assign(position.begin(), position.begin() + 1); // the depth pass reads the position alone
+        }
+    else
+        {
+        std::array<vk::VertexInputAttributeDescription, 5> full     = Vertex::attributeDescriptions();
+        std::array<vk::VertexInputAttributeDescription, 1> position = Vertex::positionAttributeDescriptions();
+        attributes.assign(full.begin(), full.end());
+        depthAttributes.assign(position.begin(), position.end());
+        }
         
     vk::PipelineVertexInputStateCreateInfo vertexInputInfo = { };
-        vertexInputInfo.vertexBindingDescriptionCount   = 1;
+        vertexInputInfo.vertexBindingDescriptionCount   = split ? 2 : 1;
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
         
-        vertexInputInfo.pVertexBindingDescriptions      = &inputBinding;
+        vertexInputInfo.pVertexBindingDescriptions      = inputBindings;
         vertexInputInfo.pVertexAttributeDescriptions    = attributes.data();
         
     vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo = { };
@@ -1295,10 +1819,14 @@ vk::Result VulkanApp::createGraphicsPipeline ()
         dynamicStateCreateInfo.dynamicStateCount = 2;
         dynamicStateCreateInfo.pDynamicStates    = dynamicStates;
         
+    // after a prepass the depth buffer already holds the
+    // nearest surface, so shading only has to match it
+    const bool prepass = options.depthPrepass && !options.packedVertices;
+    
     vk::PipelineDepthStencilStateCreateInfo depthStencilCreateInfo = { };
         depthStencilCreateInfo.depthTestEnable       = VK_TRUE;
-        depthStencilCreateInfo.depthWriteEnable      = VK_TRUE;
-        depthStencilCreateInfo.depthCompareOp        = vk::CompareOp::eLess;
+        depthStencilCreateInfo.depthWriteEnable      = prepass ? VK_FALSE : VK_TRUE;
+        depthStencilCreateInfo.depthCompareOp        = prepass ? vk::CompareOp::eLessOrEqual : vk::CompareOp::eLess;
         depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
         depthStencilCreateInfo.minDepthBounds        = 0.0f;
         depthStencilCreateInfo.maxDepthBounds        = 1.0f;
@@ -1335,12 +1863,93 @@ vk::Result VulkanApp::createGraphicsPipeline ()
     if (result != vk::Result::eSuccess)
         return result;
         
+    if (prepass)
+        { // depth only pipeline
+        
+        // the same state again, but fed only the position
+        // stream, with no fragment stage and no colour writes
+        vk::PipelineShaderStageCreateInfo depthStage =
+            VulkanShaders::loadShader(core.logicalDevice, "shaders/depth.spv", vk::ShaderStageFlagBits::eVertex);
+        
+        vk::PipelineVertexInputStateCreateInfo depthInputInfo = vertexInputInfo;
+            depthInputInfo.vertexBindingDescriptionCount   = 1;
+            depthInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(depthAttributes.size());
+            depthInputInfo.pVertexAttributeDescriptions    = depthAttributes.data();
+        
+        vk::PipelineColorBlendAttachmentState depthBlendAttachmentState = { };
+            depthBlendAttachmentState.colorWriteMask = vk::ColorComponentFlags();
+            depthBlendAttachmentState.blendEnable    = VK_FALSE;
+        
+        vk::PipelineColorBlendStateCreateInfo depthBlendCreateInfo = colorBlendCreateInfo;
+            depthBlendCreateInfo.pAttachments = &depthBlendAttachmentState;
+        
+        vk::PipelineDepthStencilStateCreateInfo depthOnlyCreateInfo = depthStencilCreateInfo;
+            depthOnlyCreateInfo.depthWriteEnable = VK_TRUE;
+            depthOnlyCreateInfo.depthCompareOp   = vk::CompareOp::eLess;
+        
+        vk::GraphicsPipelineCreateInfo depthCreateInfo = pipelineCreateInfo;
+            depthCreateInfo.stageCount         = 1;
+            depthCreateInfo.pStages            = &depthStage;
+            depthCreateInfo.pVertexInputState  = &depthInputInfo;
+            depthCreateInfo.pDepthStencilState = &depthOnlyCreateInfo;
+            depthCreateInfo.pColorBlendState   = &depthBlendCreateInfo;
+        
+        result = core.logicalDevice.createGraphicsPipelines(nullptr, 1, &depthCreateInfo, nullptr, &graphics.depthPipeline);
+        
+        if (result != vk::Result::eSuccess)
+            return result;
+        
+        } // depth only pipeline
+        
     VulkanShaders::tidy(core.logicalDevice);
 
     return result;
     } // VulkanApp :: createGraphicsPipeline
 
 
+//
+//  createCullPipeline
+//
+//  the compute pipeline of the cull pass, sharing the layout
+//  of the graphics pipeline. it is dispatched on the graphics
+//  queue ahead of the render pass, with a thread per object
+//
+vk::Result VulkanApp::createCullPipeline ()
+    { // VulkanApp :: createCullPipeline
+    vk::Result result = vk::Result::eSuccess;
+    
+    if (!options.gpuCulling)
+        return result;
+    
+    std::vector<vk::QueueFamilyProperties> families = core.physicalDevice.getQueueFamilyProperties();
+    
+    if (!(families[queues.graphicsIndex].queueFlags & vk::QueueFlagBits::eCompute))
+        {
+        ErrorHandler::nonfatal("Graphics queue does not support compute");
+        return vk::Result::eErrorFeatureNotPresent;
+        }
+    
+    // cull.comp runs in groups of 64 objects
+    const uint32_t groups = (nObjects + 63) / 64;
+    
+    if (groups > core.physicalDevice.getProperties().limits.maxComputeWorkGroupCount[0])
+        {
+        ErrorHandler::nonfatal("Too many objects for one cull dispatch");
+        return vk::Result::eErrorOutOfDeviceMemory;
+        }
+    
+    vk::ComputePipelineCreateInfo pipelineCreateInfo = { };
+        pipelineCreateInfo.stage  = VulkanShaders::loadShader(core.logicalDevice, "shaders/cull.spv", vk::ShaderStageFlagBits::eCompute);
+        pipelineCreateInfo.layout = graphics.layout;
+        
+    result = core.logicalDevice.createComputePipelines(nullptr, 1, &pipelineCreateInfo, nullptr, &graphics.cullPipeline);
+    
+    VulkanShaders::tidy(core.logicalDevice);
+    
+    return result;
+    } // VulkanApp :: createCullPipeline
+
+
 //
 //  createCommandBuffers
 //
@@ -1403,16 +2012,88 @@ vk::Result VulkanApp::createCommandBuffers ()
             renderPassBeginInfo.clearValueCount = 2;
             renderPassBeginInfo.pClearValues = clearValues.data();
         
-        vk::DeviceSize offsets[] = { 0 };
+        vk::DeviceSize offsets[] = { 0, 0 };
+        vk::Buffer     vertexBuffers[] = { buffers.vertex.buffer, buffers.attributes.buffer };
+        
+        // the commands of each index width are one run of the
+        // indirect buffer, so a pass binds each index buffer once
+        // and draws every mesh and instance of that width in as
+        // few calls as the device allows, one with multi draw
+        auto drawObjects = [&] ()
+            {
+            for (vk::IndexType type : { vk::IndexType::eUint16, vk::IndexType::eUint32 })
+                { // for each index width
+                
+                const bool     narrow = type == vk::IndexType::eUint16;
+                const uint32_t first  = narrow ? 0 : meshes.commands16;
+                const uint32_t count  = narrow ? meshes.commands16 : meshes.commands - meshes.commands16;
+                
+                if (count == 0)
+                    continue;
+                
+                swapchain.commandBuffers[i].bindIndexBuffer(narrow ? buffers.index16.buffer : buffers.index.buffer, 0, type);
+                
+                // the counts come from the indirect buffer so the
+                // level and number of instances can change without
+                // re-recording
+                for (uint32_t c = 0; c < count; c += features.maxDrawIndirectCount)
+                    swapchain.commandBuffers[i].drawIndexedIndirect(
+                        buffers.indirect.buffer,
+                        sizeof(vk::DrawIndexedIndirectCommand) * (first + c),
+                        std::min(features.maxDrawIndirectCount, count - c),
+                        sizeof(vk::DrawIndexedIndirectCommand));
+                
+                } // for each index width
+            };
+        
+        // the cull pass resets the commands to no instances, then
+        // appends every object in view to the command of its level,
+        // all ahead of the render pass so the draws read what it
+        // wrote. the cpu never looks at an object's visibility
+        if (graphics.cullPipeline)
+            {
+            vk::BufferCopy region = { 0, 0, sizeof(vk::DrawIndexedIndirectCommand) * meshes.commands };
+            swapchain.commandBuffers[i].copyBuffer(buffers.commands.buffer, buffers.indirect.buffer, 1, &region);
+            
+            vk::MemoryBarrier reset = { };
+                reset.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                reset.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+            
+            swapchain.commandBuffers[i].pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlags { }, 1, &reset, 0, nullptr, 0, nullptr);
+            
+            swapchain.commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eCompute, graphics.cullPipeline);
+            swapchain.commandBuffers[i].bindDescriptorSets(vk::PipelineBindPoint::eCompute, graphics.layout, 0, 1, &graphics.descriptorSet, 0, nullptr);
+            swapchain.commandBuffers[i].dispatch((nObjects + 63) / 64, 1, 1);
+            
+            vk::MemoryBarrier culled = { };
+                culled.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+                culled.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead;
+            
+            swapchain.commandBuffers[i].pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+                vk::DependencyFlags { }, 1, &culled, 0, nullptr, 0, nullptr);
+            }
         
         swapchain.commandBuffers[i].beginRenderPass(&renderPassBeginInfo, vk::SubpassContents::eInline);
         
-            swapchain.commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, graphics.pipeline);
-            swapchain.commandBuffers[i].bindVertexBuffers(0, 1, &buffers.vertex.buffer, offsets);
-            swapchain.commandBuffers[i].bindIndexBuffer(buffers.index.buffer, 0, vk::IndexType::eUint32);
             swapchain.commandBuffers[i].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphics.layout, 0, 1, &graphics.descriptorSet, 0, nullptr);
             
-            swapchain.commandBuffers[i].drawIndexed(static_cast<uint32_t>(meshes.indices.size()), 1, 0, 0, 0);
+            // the prepass only reads binding 0, so split
+            // vertices fetch just their positions for it
+            if (graphics.depthPipeline)
+                {
+                swapchain.commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, graphics.depthPipeline);
+                swapchain.commandBuffers[i].bindVertexBuffers(0, 1, vertexBuffers, offsets);
+                drawObjects();
+                }
+            
+            swapchain.commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, graphics.pipeline);
+            swapchain.commandBuffers[i].bindVertexBuffers(0, buffers.attributes.buffer ? 2 : 1, vertexBuffers, offsets);
+            drawObjects();
     
         swapchain.commandBuffers[i].endRenderPass();
         swapchain.commandBuffers[i].end();
@@ -1436,15 +2117,15 @@ void VulkanApp::arrangeObjects ()
 		arrangement.translations.resize(nObjects);
 		arrangement.centre = { 0.0f, 0.0f, 0.0f };
 
-		for (Vertex& v : meshes.vertices)
-			{ // for each vertex
+		for (uint32_t i = 0; i < nObjects; ++i)
+			{ // for each object
 
-			arrangement.translations[v.id] = {
-				(v.id % m) * offset,
+			arrangement.translations[i] = {
+				(i % m) * offset,
 				0.0f, 
-				(v.id / m) * offset};
+				(i / m) * offset};
 
-			} // for each vertex
+			} // for each object
 
 		for (uint32_t i = 0; i < nObjects; ++i)
 			arrangement.centre += arrangement.translations[i];
@@ -1456,14 +2137,10 @@ void VulkanApp::arrangeObjects ()
 		}
 
 
+	// the transforms follow from the positions in updateUniforms
 	for (uint32_t i = 0; i < nObjects; ++i)
 		{ // for each object
 		
-		ubo.model[i] = glm::mat4(1.0f);
-		ubo.model[i] = glm::translate(ubo.model[i], arrangement.translations[i] - arrangement.centre);
-		ubo.model[i] = glm::scale(ubo.model[i], glm::vec3(0.5f, 0.5f, 0.5f));
-		//ubo.model[i] = glm::rotate(ubo.model[i], glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-
 		simulation.positions[i] = arrangement.translations[i] - arrangement.centre;
 
 		} // for each object
@@ -1491,7 +2168,6 @@ void VulkanApp::createPhysicsState()
 		simulation.velocities[i] = glm::vec3(posDist(rng), posDist(rng), posDist(rng));
 		simulation.rotations[i] = glm::vec3(angDist(rng), angDist(rng), angDist(rng));
 		simulation.orientations[i] = glm::vec3(0.0f, 0.0f, 0.0f);
-		simulation.bounds = 2.0f;
 
 	} // for each object
 
@@ -1522,62 +2198,155 @@ void VulkanApp::updatePhysicsState ()
 			}
 
 
-	// collide with eachother
+	// collide with eachother. objects are sorted into a grid of
+	// cells as wide as the collision distance, so each only
+	// needs testing against those in the cells around its own
+	const float minDist = std::max(simulation.bounds, 1e-3f);
+
+	auto cellOf = [minDist] (const glm::vec3& p)
+		{
+		return glm::ivec3(glm::floor(p / minDist));
+		};
+
+	auto keyOf = [] (const glm::ivec3& c)
+		{
+		return ((uint64_t)(uint32_t)(c.x & 0x1FFFFF) << 42) | ((uint64_t)(uint32_t)(c.y & 0x1FFFFF) << 21) | (uint64_t)(uint32_t)(c.z & 0x1FFFFF);
+		};
+
+	std::vector<std::pair<uint64_t, uint32_t>> cells (nObjects);
 	for (uint32_t i = 0; i < nObjects; ++i)
-		for (uint32_t j = 0; j < nObjects; ++j)
-			{
-			if (i == j) continue;
-
-			float minDist = simulation.bounds;
-			float actDist = glm::length(simulation.positions[i] - simulation.positions[j]);
-			if (actDist < minDist)
-				{ 
-				simulation.velocities[i] = glm::normalize(simulation.positions[i] - simulation.positions[j]) * 0.01f;
-				simulation.velocities[j] = glm::normalize(simulation.positions[j] - simulation.positions[i]) * 0.01f;
+		cells[i] = { keyOf(cellOf(simulation.positions[i])), i };
+
+	std::sort(cells.begin(), cells.end());
+
+	for (uint32_t i = 0; i < nObjects; ++i)
+		{ // for each object
+
+		const glm::ivec3 cell = cellOf(simulation.positions[i]);
+
+		for (int32_t x = -1; x <= 1; ++x)
+		for (int32_t y = -1; y <= 1; ++y)
+		for (int32_t z = -1; z <= 1; ++z)
+			{ // for each neighbouring cell
+
+			const uint64_t key   = keyOf(cell + glm::ivec3(x, y, z));
+			auto           first = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, 0u));
+
+			for (auto other = first; other != cells.end() && other->first == key; ++other)
+				{
+				uint32_t j = other->second;
+				if (i == j) continue;
+
+				float actDist = glm::length(simulation.positions[i] - simulation.positions[j]);
+				if (actDist < minDist)
+					{ 
+					simulation.velocities[i] = glm::normalize(simulation.positions[i] - simulation.positions[j]) * 0.01f;
+					simulation.velocities[j] = glm::normalize(simulation.positions[j] - simulation.positions[i]) * 0.01f;
+					}
 				}
-			}
+
+			} // for each neighbouring cell
+
+		} // for each object
 	} // VulkanApp :: updatePhysicsState
 
 
 //
 //
 //
-void VulkanApp::updateUniforms ()
-    { // VulkanApp :: updateUniforms
-    
-    if (animateLights)
-        {
-        ubo.lightPosition.x = sin (timing.timer * 0.1f) * 4.0f;
-        ubo.lightPosition.y = cos (timing.timer * 0.1f) * 4.0f;
-        }
+//
+//  updateCamera
+//
+//  builds the view and projection from the eye, and the planes
+//  of the volume they see, which either culling pass tests the
+//  objects against
+//
+void VulkanApp::updateCamera ()
+    { // VulkanApp :: updateCamera
 
-    ubo.proj = glm::perspective((float)(WINDOW_WIDTH / WINDOW_HEIGHT), 1.0f, 0.01f, 100.0f);
+    ubo.proj = glm::perspective((float)(WINDOW_WIDTH / WINDOW_HEIGHT), 1.0f, 0.01f, farPlane);
     ubo.proj[1][1] *= -1;
     ubo.view = glm::lookAt(
         eyePosition,                      // position
         eyePosition + glm::vec3 { 0.0f, -1.0f, 0.0f },  // center
         glm::vec3 { 0.0f, 0.0f, 1.00f }); // world up
-        
-    for (uint32_t i = 0; i < nObjects; ++i)
-        {
+    ubo.eyePosition = eyePosition;
 
-		ubo.model[i] = glm::mat4(1.0f);
-		ubo.model[i] = glm::translate(ubo.model[i], simulation.positions[i]);
-		ubo.model[i] = glm::scale(ubo.model[i], glm::vec3(0.5f, 0.5f, 0.5f));
-		ubo.model[i] = glm::rotate(ubo.model[i], glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	culling.planes = Frustum::planes(ubo.proj * ubo.view);
+	for (uint32_t p = 0; p < 6; ++p)
+		ubo.frustum[p] = culling.planes.planes[p];
 
-		ubo.model[i] = glm::rotate(ubo.model[i], glm::radians(simulation.orientations[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
-		ubo.model[i] = glm::rotate(ubo.model[i], glm::radians(simulation.orientations[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
-		ubo.model[i] = glm::rotate(ubo.model[i], glm::radians(simulation.orientations[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+	// the cull pass picks levels as selectLevels does
+	const float fov    = (float)(WINDOW_WIDTH / WINDOW_HEIGHT);
+	const float pixels = (float)WINDOW_HEIGHT / (2.0f * tan(fov * 0.5f));
 
-        }
+	ubo.lod.x = options.levelOfDetail ? pixels / options.lodPixelError : 0.0f;
+
+    } // VulkanApp :: updateCamera
+
+//
+//  cullObjects
+//
+//  lists the objects whose bounding spheres reach into the view,
+//  for when culling is left to the cpu. the spheres are packed a
+//  coordinate to an array so Frustum::cull tests eight at a time,
+//  each centred on the object's origin and wide enough to hold
+//  its mesh however it is turned
+//
+void VulkanApp::cullObjects ()
+	{ // VulkanApp :: cullObjects
 
+	Frustum::Spheres& spheres = culling.spheres;
+
+	if (spheres.size() != nObjects)
+		{
+		spheres.resize(nObjects);
+		for (uint32_t i = 0; i < nObjects; ++i)
+			{
+			const VulkanMeshes::Draw& draw = meshes.draws[meshes.objects[i]];
+			spheres.radius[i] = objectScale * (glm::length(draw.center) + draw.radius);
+			}
+		}
+
+	culling.visible.resize(nObjects);
+
+	// before the physics has placed anything, nothing is culled
+	if (simulation.positions.size() < nObjects)
+		{
+		for (uint32_t i = 0; i < nObjects; ++i)
+			culling.visible[i] = i;
+		return;
+		}
+
+	for (uint32_t i = 0; i < nObjects; ++i)
+		{
+		spheres.x[i] = simulation.positions[i].x;
+		spheres.y[i] = simulation.positions[i].y;
+		spheres.z[i] = simulation.positions[i].z;
+		}
+
+	culling.visible.resize(Frustum::cull(spheres, culling.planes, culling.visible.data()));
+
+	} // VulkanApp :: cullObjects
+
+//
+//
+//
+void VulkanApp::updateUniforms ()
+    { // VulkanApp :: updateUniforms
+    
+    if (animateLights)
+        {
+        ubo.lightPosition.x = sin (timing.timer * 0.1f) * 4.0f;
+        ubo.lightPosition.y = cos (timing.timer * 0.1f) * 4.0f;
+        }
+        
 	if (regenerateMaterials)
 		{
 		std::uniform_real_distribution<float> colDist(0.2f, 1.0f);
 		for (uint32_t i = 0; i < nObjects; ++i)
 			{
-			ubo.materials[i] =
+			objects.materials[i] =
 				{ colDist(rng), colDist(rng), colDist(rng), colDist(rng) };
 			}
 		regenerateMaterials = false;
@@ -1587,9 +2356,287 @@ void VulkanApp::updateUniforms ()
     core.logicalDevice.mapMemory(buffers.uniform.memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags { }, &data);
     memcpy(data, &ubo, sizeof(UniformBufferObject));
     core.logicalDevice.unmapMemory(buffers.uniform.memory);
+
+	// the transforms are built straight into the mapped object
+	// buffer, split across the pool for scenes of many objects.
+	// culled on the cpu, only the objects in view are drawn and
+	// so only theirs are written
+	if (core.logicalDevice.mapMemory(buffers.objects.memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags { }, &data) != vk::Result::eSuccess)
+		return;
+
+	ObjectData* destination = static_cast<ObjectData*>(data);
+
+	const bool   listed = !options.gpuCulling;
+	const size_t count  = listed ? culling.visible.size() : nObjects;
+
+	pool.forRange(count, 4096, [&] (size_t begin, size_t end, uint32_t)
+		{
+		for (size_t n = begin; n < end; ++n)
+			{ // for each object
+
+			const size_t i = listed ? culling.visible[n] : n;
+
+			glm::mat4 model = glm::mat4(1.0f);
+			model = glm::translate(model, simulation.positions[i]);
+			model = glm::scale(model, glm::vec3(objectScale));
+			model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+			model = glm::rotate(model, glm::radians(simulation.orientations[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
+			model = glm::rotate(model, glm::radians(simulation.orientations[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+			model = glm::rotate(model, glm::radians(simulation.orientations[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+
+			destination[i].model    = model;
+			destination[i].material = objects.materials[i];
+
+			} // for each object
+		});
+
+	core.logicalDevice.unmapMemory(buffers.objects.memory);
     
     } // VulkanApp :: updateUniforms
 
+//
+//  selectLevels
+//
+//  picks the coarsest level of each object whose error, projected
+//  to the screen at the object's distance from the eye, stays under
+//  options.lodPixelError, and writes the draw commands for them.
+//  only the objects cullObjects left in view are drawn. those
+//  behind a command take consecutive instance slots, which the
+//  instance buffer maps back to objects for the vertex shader
+//
+void VulkanApp::selectLevels ()
+	{ // VulkanApp :: selectLevels
+
+	// matches the projection built in updateCamera, pixels
+	// per unit of error at a distance of one
+	const float fov    = (float)(WINDOW_WIDTH / WINDOW_HEIGHT);
+	const float pixels = (float)WINDOW_HEIGHT / (2.0f * tan(fov * 0.5f));
+
+	const std::vector<uint32_t>& visible = culling.visible;
+
+	std::vector<vk::DrawIndexedIndirectCommand> commands (meshes.commands);
+	std::vector<uint32_t>                       objectCommands (visible.size());
+
+	for (uint32_t n = 0; n < visible.size(); ++n)
+		{ // for each object in view
+
+		const uint32_t            i    = visible[n];
+		const VulkanMeshes::Draw& draw = meshes.draws[meshes.objects[i]];
+
+		uint32_t chosen = 0;
+
+		if (options.levelOfDetail && i < simulation.positions.size())
+			{
+			float distance = std::max(glm::length(simulation.positions[i] - eyePosition), 0.01f);
+
+			for (uint32_t l = 1; l < draw.levels.size(); ++l)
+				if (draw.levels[l].error * draw.radius * objectScale * pixels / distance <= options.lodPixelError)
+					chosen = l;
+			}
+
+		// geometry still streaming in is drawn at the finest
+		// level that has landed
+		chosen = std::max(chosen, draw.finest);
+
+		const VulkanMeshes::Level& level = draw.levels[chosen];
+
+		// a shared copy has a command for each level, where a
+		// copy of its own holds whichever level the object is at
+		const uint32_t c = draw.firstCommand + (draw.commandCount > 1 ? chosen : 0);
+
+		commands[c].indexCount     = level.indexCount;
+		commands[c].instanceCount += 1;
+		commands[c].firstIndex     = level.firstIndex;
+		commands[c].vertexOffset   = draw.vertexOffset;
+
+		objectCommands[n] = c;
+
+		} // for each object in view
+
+	// commands take their slots in order, levels nobody is at
+	// drawing no instances at all
+	uint32_t slot = 0;
+	for (vk::DrawIndexedIndirectCommand& command : commands)
+		{
+		command.firstInstance = slot;
+		slot += command.instanceCount;
+		}
+
+	std::vector<uint32_t> placed (meshes.commands, 0);
+	for (uint32_t n = 0; n < visible.size(); ++n)
+		{
+		const uint32_t c = objectCommands[n];
+		const uint32_t s = commands[c].firstInstance + placed[c]++;
+
+		objects.instances[s] = visible[n];
+		}
+
+	void* data;
+	core.logicalDevice.mapMemory(buffers.indirect.memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags { }, &data);
+	memcpy(data, commands.data(), sizeof(vk::DrawIndexedIndirectCommand) * commands.size());
+	core.logicalDevice.unmapMemory(buffers.indirect.memory);
+
+	core.logicalDevice.mapMemory(buffers.instances.memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags { }, &data);
+	memcpy(data, objects.instances.data(), sizeof(uint32_t) * visible.size());
+	core.logicalDevice.unmapMemory(buffers.instances.memory);
+
+	} // VulkanApp :: selectLevels
+
+//
+//  streamMeshes
+//
+//  picks up a finished refinement and starts the next, for the
+//  mesh behind the nearest object not yet drawn in full. reads
+//  run on the pool so the frame never waits on the disk
+//
+void VulkanApp::streamMeshes ()
+	{ // VulkanApp :: streamMeshes
+
+	if (streaming.streams.empty())
+		return;
+
+	if (streaming.pending.valid())
+		{
+		if (streaming.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		// a failed read leaves its objects at the level they
+		// reached and the stream is given up on
+		if (streaming.pending.get())
+			refineObjects(streaming.reading, streaming.from);
+		else
+			{
+			ErrorHandler::nonfatal("Mesh stream failed to refine");
+			streaming.streams[streaming.reading].reset();
+			}
+		}
+
+	uint32_t next    = UINT32_MAX;
+	float    nearest = std::numeric_limits<float>::max();
+
+	for (uint32_t i = 0; i < nObjects && i < simulation.positions.size(); ++i)
+		{ // for each object
+
+		const uint32_t    variant = streaming.variants[meshes.objects[i]];
+		const MeshStream* stream  = streaming.streams[variant].get();
+		if (stream == nullptr || stream->finest == 0)
+			continue;
+
+		float distance = glm::length(simulation.positions[i] - eyePosition);
+		if (distance < nearest)
+			{
+			nearest = distance;
+			next    = variant;
+			}
+
+		} // for each object
+
+	if (next == UINT32_MAX)
+		return;
+
+	MeshStream* stream = streaming.streams[next].get();
+
+	streaming.reading = next;
+	streaming.from    = stream->loaded;
+	streaming.pending = pool.submit([stream] () { return MeshIO::refineMeshStream(*stream); });
+
+	} // VulkanApp :: streamMeshes
+
+//
+//  refineObjects
+//
+//  copies what a refinement of the given stream brought in, the
+//  vertices from firstVertex on and the full indices once they
+//  land, into every copy batched from it. the gpu is idle
+//  between frames, so the host visible buffers are written in
+//  place
+//
+void VulkanApp::refineObjects (uint32_t s, size_t firstVertex)
+	{ // VulkanApp :: refineObjects
+
+	const MeshStream& stream = *streaming.streams[s];
+	const size_t      count  = stream.loaded - firstVertex;
+
+	auto upload = [this] (vk::DeviceMemory memory, vk::DeviceSize offset, const void* source, size_t size)
+		{
+		if (size == 0)
+			return;
+
+		void* data;
+		if (core.logicalDevice.mapMemory(memory, offset, size, vk::MemoryMapFlags { }, &data) != vk::Result::eSuccess)
+			return;
+
+		memcpy(data, source, size);
+		core.logicalDevice.unmapMemory(memory);
+		};
+
+	for (uint32_t d = 0; d < meshes.draws.size(); ++d)
+		{ // for each mesh copy
+
+		if (streaming.variants[d] != s)
+			continue;
+
+		VulkanMeshes::Draw& draw  = meshes.draws[d];
+		const size_t        first = (size_t)draw.vertexOffset + firstVertex;
+
+		// the new vertices get the same id stamp the batch
+		// merge gave the rest
+		Vertex* vertices = meshes.vertices.data() + first;
+		std::copy(stream.vertices.begin() + firstVertex, stream.vertices.begin() + stream.loaded, vertices);
+
+		for (size_t v = 0; v < count; ++v)
+			vertices[v].id = options.instancedMeshes ? 0 : static_cast<int32_t>(d);
+
+		if (!meshes.positions.empty())
+			{
+			std::vector<VertexPosition>   positions;
+			std::vector<VertexAttributes> attributes;
+			MeshIO::splitStreams(vertices, count, positions, attributes);
+
+			std::copy(positions.begin(),  positions.end(),  meshes.positions.begin()  + first);
+			std::copy(attributes.begin(), attributes.end(), meshes.attributes.begin() + first);
+
+			upload(buffers.vertex.memory,     sizeof(VertexPosition)   * first, positions.data(),  sizeof(VertexPosition)   * count);
+			upload(buffers.attributes.memory, sizeof(VertexAttributes) * first, attributes.data(), sizeof(VertexAttributes) * count);
+			}
+		else
+			upload(buffers.vertex.memory, sizeof(Vertex) * first, vertices, sizeof(Vertex) * count);
+
+		// the full level's indices are already local to the
+		// object, only their width may need to change
+		if (stream.finest == 0)
+			{
+			const VulkanMeshes::Level& full = draw.levels[0];
+
+			if (draw.indexType == vk::IndexType::eUint16)
+				{
+				uint16_t* indices = meshes.indices16.data() + full.firstIndex;
+				for (uint32_t n = 0; n < full.indexCount; ++n)
+					indices[n] = stream.indices.empty() ? stream.indices16[n] : static_cast<uint16_t>(stream.indices[n]);
+
+				upload(buffers.index16.memory, sizeof(uint16_t) * full.firstIndex, indices, sizeof(uint16_t) * full.indexCount);
+				}
+			else
+				{
+				uint32_t* indices = meshes.indices32.data() + full.firstIndex;
+				for (uint32_t n = 0; n < full.indexCount; ++n)
+					indices[n] = stream.indices.empty() ? stream.indices16[n] : stream.indices[n];
+
+				upload(buffers.index.memory, sizeof(uint32_t) * full.firstIndex, indices, sizeof(uint32_t) * full.indexCount);
+				}
+			}
+
+		draw.finest = stream.finest;
+
+		// the cull pass picks levels from its own copy of the draws
+		if (options.gpuCulling)
+			upload(buffers.draws.memory, sizeof(DrawData) * d + offsetof(DrawData, finest), &draw.finest, sizeof(uint32_t));
+
+		} // for each mesh copy
+
+	} // VulkanApp :: refineObjects
+
 #include <windows.h>
 
 //
@@ -1634,8 +2681,9 @@ void VulkanApp::report ()
 	/* Move the cursor home */
 	SetConsoleCursorPosition(hStdOut, homeCoords);
 
-	uint32_t meshMemoryOccupation    = ((meshes.vertices.size() * sizeof(Vertex)) / 1000) / 1000;
-	meshMemoryOccupation += ((meshes.indices.size() * sizeof(uint32_t)) / 1000) / 1000;
+	size_t   vertexSize              = options.packedVertices ? sizeof(PackedVertex) : sizeof(Vertex);
+	uint32_t meshMemoryOccupation    = ((meshes.vertices.size() * vertexSize) / 1000) / 1000;
+	meshMemoryOccupation += ((meshes.indices16.size() * sizeof(uint16_t) + meshes.indices32.size() * sizeof(uint32_t)) / 1000) / 1000;
 
 	uint32_t depthBufferMemorySize   = ((WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(uint32_t) / 1000) / 1000);
 	uint32_t frameBufferMemorySize   = ((WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(glm::vec3) / 1000) / 1000);
@@ -1754,6 +2802,15 @@ void VulkanApp::loop ()
 		if (reset == 1)
 			updatePhysicsState ();
         
+		streamMeshes ();
+		updateCamera ();
+
+		if (!options.gpuCulling)
+			{
+			cullObjects ();
+			selectLevels ();
+			}
+
 		updateUniforms ();
         render ();
 
@@ -1773,7 +2830,7 @@ void VulkanApp::createBuffer (
         vk::BufferUsageFlags    usage,
         vk::MemoryPropertyFlags properties,
         vk::Buffer&             buffer,
-        vk::DeviceMemory        memory)
+        vk::DeviceMemory&       memory)
     { // VulkanApp :: createBuffer
     
     vk::Result result = vk::Result::eSuccess;
@@ -21,14 +21,42 @@
 #include <random>
 #include <string>
 #include <chrono>
+#include <memory>
 
 #include "VulkanVertex.hpp"
+#include "Frustum.hpp"
+#include "TaskPool.hpp"
 #include "Timer.hpp"
 
+struct MeshView;
+struct MeshCache;
+struct MeshStream;
+
+//
+//  optional rendering paths, chosen once at start up
+//
+struct VulkanOptions
+	{ // VulkanOptions
+	bool packedVertices = false; // upload the 20 byte PackedVertex layout instead of Vertex
+	bool optimizeMeshes = false; // run MeshIO::optimize at load, keeping the results in the mesh cache
+	std::string meshCache      = "cache";      // directory the optimized meshes are shared through
+	uint64_t    meshCacheBytes = 256ull << 20; // least recently used entries are evicted beyond this
+	bool smallIndices   = true;  // draw objects under 65,536 vertices from a uint16 index buffer
+	bool levelOfDetail  = true;  // pick a simplified level per object when the mesh has them
+	float lodPixelError = 1.0f;  // largest on screen error, in pixels, a level may introduce
+	bool splitVertexStreams = false; // bind positions and the other attributes as two streams, ignored when packed
+	bool depthPrepass       = false; // lay down depth with a position only pipeline before shading
+	bool progressiveMeshes  = false; // draw the coarsest level at once and stream the rest in, nearest first. reads the files as they are, ignored when packed
+	std::string meshShape;            // sphere, grid, torus or blob draws a generated mesh in place of the scans
+	uint64_t    meshTriangles = 65536; // exact triangle count of each generated object
+	bool instancedMeshes = true; // upload each mesh once and draw its objects as instances of it, rather than a copy per object
+	bool gpuCulling      = true; // frustum cull and pick levels in a compute pass ahead of the draws, rather than in cullObjects and selectLevels
+	}; // VulkanOptions
+
 class VulkanApp
 	{  // VulkanApp
 public:
-	VulkanApp(uint32_t width, uint32_t height, std::string title, uint32_t objects, uint32_t id, glm::vec3 clear = { 0.12f, 0.12f, 0.12f });
+	VulkanApp(uint32_t width, uint32_t height, std::string title, uint32_t objects, uint32_t id, VulkanOptions options = VulkanOptions(), glm::vec3 clear = { 0.12f, 0.12f, 0.12f });
 	~VulkanApp();
 
 protected:
@@ -43,10 +71,12 @@ protected:
 
 	uint32_t runID;
 
+	const VulkanOptions options;
+
 private:
 
 	vk::Result createWindow();
-	vk::Result createSceneMesh();
+	vk::Result createSceneMesh(std::vector<std::future<MeshView>>& loads);
 	vk::Result createInstance();
 	vk::Result createDebugCallback();
 	vk::Result createSurface();
@@ -54,6 +84,7 @@ private:
 	vk::Result createSwapChain();
 	vk::Result createDepthBuffer();
 	vk::Result createUniformBuffer();
+	vk::Result createObjectBuffers();
 	vk::Result createPipelineLayout();
 	vk::Result createDescriptorSet();
 	vk::Result createSemaphores();
@@ -61,7 +92,9 @@ private:
 	vk::Result createFrameBuffers();
 	vk::Result createVertexBuffer();
 	vk::Result createIndexBuffer();
+	vk::Result createIndirectBuffer();
 	vk::Result createGraphicsPipeline();
+	vk::Result createCullPipeline();
 	vk::Result createCommandBuffers();
 
 	void arrangeObjects();
@@ -69,7 +102,12 @@ private:
 	void createPhysicsState();
 	void updatePhysicsState();
 
+	void updateCamera();
+	void cullObjects();
 	void updateUniforms();
+	void selectLevels();
+	void streamMeshes();
+	void refineObjects(uint32_t stream, size_t firstVertex);
 
 	void report();
 
@@ -86,6 +124,11 @@ private:
 		vk::CommandPool   pool;
 	} command;
 
+	// optional device features the draws take advantage of
+	struct VulkanFeatures {
+		uint32_t maxDrawIndirectCount = 1; // commands one indirect call may draw, more than 1 with multi draw
+	} features;
+
 	struct VulkanQueues {
 		vk::Queue graphics; uint32_t graphicsIndex = UINT32_MAX;
 		vk::Queue compute;  uint32_t computeIndex = UINT32_MAX;
@@ -125,6 +168,8 @@ private:
 		vk::DescriptorSet       descriptorSet;
 		vk::PipelineLayout      layout;
 		vk::Pipeline            pipeline;
+		vk::Pipeline            depthPipeline; // position only, when options.depthPrepass is set
+		vk::Pipeline            cullPipeline;  // compute, when options.gpuCulling is set
 	} graphics;
 
 	struct VulkanShaderModules {
@@ -149,40 +194,135 @@ private:
 			vk::DeviceMemory memory;
 		};
 		VulkanBuffer uniform;
-		VulkanBuffer vertex;
-		VulkanBuffer index;
+		VulkanBuffer vertex;     // interleaved or packed vertices, or positions when the streams are split
+		VulkanBuffer attributes; // the rest of a split vertex
+		VulkanBuffer index;   // uint32 indices of objects too large for 16 bits
+		VulkanBuffer index16; // uint16 indices of everything else
+		VulkanBuffer indirect; // draw commands, the 16 bit draws' first, rewritten by selectLevels or the cull pass
+		VulkanBuffer objects;   // an ObjectData per object, rewritten every frame
+		VulkanBuffer instances; // object behind each instance slot, rewritten by selectLevels or the cull pass
+		VulkanBuffer commands;    // the draw commands with no instances, copied over the indirect ones ahead of culling
+		VulkanBuffer draws;       // a DrawData per mesh copy, for the cull pass
+		VulkanBuffer levels;      // the levels of every copy, one after another
+		VulkanBuffer objectDraws; // draw each object is an instance of
 	} buffers;
 
 	VkDebugReportCallbackEXT callback;
 
-	static constexpr uint32_t maxObjects = 64;
+	static constexpr uint32_t meshVariants = 4; // models/bust_0.mesh to bust_3.mesh
 	const uint32_t nObjects;
 	static constexpr float offset = 2.5f;
+	static constexpr float objectScale = 0.5f; // uniform scale in every model matrix
+	const float farPlane; // pushed out far enough to see every object in the arrangement
 
+	// the camera, light and decoding constants shared by every
+	// object. members are aligned to match the std140 layout in
+	// object.vert, where vec3s start on 16 bytes
 	struct UniformBufferObject {
-		glm::mat4 model[maxObjects];
 		glm::mat4 view;
 		glm::mat4 proj;
 
-		glm::vec3 lightPosition;
-		glm::vec3 eyePosition;
+		alignas(16) glm::vec3 lightPosition;
+		alignas(16) glm::vec3 eyePosition;
+
+		alignas(16) glm::vec4 positionOffset; // PackedVertex decode, see MeshQuantization
+		alignas(16) glm::vec4 positionScale;
 
-		glm::vec4 materials[maxObjects];
+		alignas(16) glm::vec4 atlas; // x holds the tiles along each side of the uv atlas
+
+		alignas(16) glm::vec4 frustum[6]; // inward facing planes of proj * view, read by cull.comp
+		alignas(16) glm::vec4 lod;        // x pixels per unit of error at a distance of one over lodPixelError, 0 without levels
 
 	} ubo;
 
+	// what each object gets on its own, an element of the
+	// std430 ObjectBuffer in object.vert
+	struct ObjectData {
+		glm::mat4 model;
+		glm::vec4 material;
+	};
+
+	// what the cull pass knows of each mesh copy, an element of
+	// the std430 DrawBuffer in cull.comp
+	struct alignas(16) DrawData {
+		glm::vec4 sphere; // bounds in model units, centre and radius
+		uint32_t  firstCommand;
+		uint32_t  commandCount;
+		uint32_t  firstLevel; // in the level buffer
+		uint32_t  levelCount;
+		uint32_t  finest;
+	};
+
+	struct VulkanObjects {
+		std::vector<glm::vec4> materials;
+		std::vector<uint32_t>  instances; // object behind each instance slot, see selectLevels
+	} objects;
+
 	struct VulkanMeshes {
 		std::vector<Vertex>   vertices;
 		std::vector<uint32_t>  indices;
+
+		std::vector<PackedVertex> packed; // filled when options.packedVertices is set
+
+		std::vector<VertexPosition>   positions;  // filled when options.splitVertexStreams is set
+		std::vector<VertexAttributes> attributes;
+
+		// each draw is one copy of a mesh, with indices local to
+		// its first vertex, which is what lets them fit in 16 bits.
+		// every level of detail shares those vertices, level 0
+		// being the full mesh. a copy per object has one indirect
+		// command, while a copy shared by instances has one per
+		// level so its objects can sit at different levels
+		struct Level { // read as LevelData by cull.comp
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			float    error; // fraction of radius
+		};
+		struct Draw {
+			std::vector<Level> levels;
+			uint32_t           firstCommand; // in the indirect buffer
+			uint32_t           commandCount;
+			uint32_t           finest; // finest level whose geometry has landed, 0 unless streaming
+			uint32_t           objectCount; // objects drawn from this copy
+			int32_t            vertexOffset;
+			vk::IndexType      indexType;
+			glm::vec3          center; // bounding sphere of the mesh in model units
+			float              radius;
+		};
+		std::vector<Draw>     draws;
+		std::vector<uint32_t> objects; // draw each object is an instance of
+		uint32_t              commands   = 0; // indirect commands across every draw
+		uint32_t              commands16 = 0; // of which the first are the 16 bit draws'
+		uint32_t              slots      = 0; // instance slots, enough for every object at any level when culled on the gpu
+		std::vector<uint16_t> indices16;
+		std::vector<uint32_t> indices32;
 	} meshes;
 
+	// the cpu culling pass, when options.gpuCulling is off
+	struct CullingState {
+		Frustum::Planes       planes;  // of the view, rebuilt by updateCamera
+		Frustum::Spheres      spheres; // bounds of each object, in world space
+		std::vector<uint32_t> visible; // objects in view, in order, rebuilt by cullObjects
+	} culling;
+
+	// progressive meshes are read a level at a time on the
+	// pool, one read in flight, for whichever mesh is used by
+	// the unrefined object nearest the eye
+	struct StreamingState {
+		std::vector<std::unique_ptr<MeshStream>> streams;  // one per mesh variant
+		std::vector<uint32_t>                    variants; // stream each draw was batched from
+		std::future<bool>                        pending;
+		uint32_t                                 reading = 0; // stream the pending read refines
+		size_t                                   from    = 0; // vertices it held before the read
+	} streaming;
+
 	struct PhysicsData {
 		std::vector<glm::vec3> positions;  // bounding sphere centroids
 		std::vector<glm::vec3> velocities; // derivatives of the motion
 
 		std::vector<glm::vec3> orientations; //
 		std::vector<glm::vec3> rotations;    // angular velocities
-		float bounds = 0.0f;                          // size of the bounding spheres
+		float bounds = 0.0f;                          // centre distance at which two objects touch, from the mesh bounds
 	} simulation;
 
 	struct InputParameters {
@@ -200,10 +340,13 @@ private:
         vk::BufferUsageFlags    usage,
         vk::MemoryPropertyFlags properties,
         vk::Buffer&             buffer,
-        vk::DeviceMemory        memory);
+        vk::DeviceMemory&       memory);
     
     std::default_random_engine rng;
     
+    std::unique_ptr<MeshCache> meshCache; // kept out of this header, it pulls in the platform apis
+    TaskPool                   pool;      // background asset loading, and per frame work once loaded
+    
     }; // VulkanApp
 
 #endif /* VulkanApp_hpp */
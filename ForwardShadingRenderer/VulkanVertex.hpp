@@ -59,7 +59,163 @@ struct Vertex
         return attributes;
         
         } // Vertex :: attributeDescriptions
+
+    //
+    //  the position alone, for pipelines such as the depth
+    //  prepass that read nothing else from the interleaved
+    //  layout and take their object from the instance
+    //
+    static std::array<vk::VertexInputAttributeDescription, 1> positionAttributeDescriptions ()
+        { // Vertex :: positionAttributeDescriptions
+        
+        std::array<vk::VertexInputAttributeDescription, 1> attributes = {};
+
+        // position
+        attributes[0].binding  = 0;
+        attributes[0].location = 0;
+        attributes[0].format   = vk::Format::eR32G32B32Sfloat;
+        attributes[0].offset   = offsetof(Vertex, position);
+
+        return attributes;
+        
+        } // Vertex :: positionAttributeDescriptions
+    
+    };
+
+//
+//  VertexPosition
+//
+//  the position stream of a Vertex split across two bindings.
+//  the object id rides along in the fourth word, as it does in
+//  PackedVertex, though shaders now take the object from the
+//  instance. position only passes bind just this stream
+//
+struct VertexPosition
+    {
+    glm::vec3 position;
+    int32_t   id;
+
+    static std::array<vk::VertexInputAttributeDescription, 2> attributeDescriptions (uint32_t binding = 0)
+        { // VertexPosition :: attributeDescriptions
+        
+        std::array<vk::VertexInputAttributeDescription, 2> attributes = {};
+
+        // position
+        attributes[0].binding  = binding;
+        attributes[0].location = 0;
+        attributes[0].format   = vk::Format::eR32G32B32Sfloat;
+        attributes[0].offset   = offsetof(VertexPosition, position);
+
+        // object id
+        attributes[1].binding  = binding;
+        attributes[1].location = 4;
+        attributes[1].format   = vk::Format::eR32Sint;
+        attributes[1].offset   = offsetof(VertexPosition, id);
+
+        return attributes;
+        
+        } // VertexPosition :: attributeDescriptions
     
     };
 
+//
+//  VertexAttributes
+//
+//  everything else a Vertex carries, the second stream of the
+//  split layout. locations match Vertex so the same shaders
+//  read either layout
+//
+struct VertexAttributes
+    {
+    glm::vec3 normal;
+    glm::vec3 color;
+    glm::vec2 uvs;
+
+    static std::array<vk::VertexInputAttributeDescription, 3> attributeDescriptions (uint32_t binding = 1)
+        { // VertexAttributes :: attributeDescriptions
+        
+        std::array<vk::VertexInputAttributeDescription, 3> attributes = {};
+
+        // normal
+        attributes[0].binding  = binding;
+        attributes[0].location = 1;
+        attributes[0].format   = vk::Format::eR32G32B32Sfloat;
+        attributes[0].offset   = offsetof(VertexAttributes, normal);
+
+        // colour
+        attributes[1].binding  = binding;
+        attributes[1].location = 2;
+        attributes[1].format   = vk::Format::eR32G32B32Sfloat;
+        attributes[1].offset   = offsetof(VertexAttributes, color);
+
+        // tcs
+        attributes[2].binding  = binding;
+        attributes[2].location = 3;
+        attributes[2].format   = vk::Format::eR32G32Sfloat;
+        attributes[2].offset   = offsetof(VertexAttributes, uvs);
+
+        return attributes;
+        
+        } // VertexAttributes :: attributeDescriptions
+    
+    };
+
+static_assert(sizeof(VertexPosition)   == 16, "position stream is expected to be 16 bytes");
+static_assert(sizeof(VertexAttributes) == 32, "attribute stream is expected to be 32 bytes");
+
+//
+//  PackedVertex
+//
+//  compact 20 byte alternative to Vertex produced by
+//  MeshIO::quantize. positions are 16 bit fixed point across
+//  the mesh's bounding box (decoded with the offset and scale
+//  in the uniform buffer) with the object id in the spare w
+//  component, normals are octahedral encoded, colours are
+//  rgba8 and texture coordinates are half floats
+//
+struct PackedVertex
+    {
+    uint16_t position[4]; // x, y, z unorm across the bounds, w object id
+    int16_t  normal[2];   // octahedral snorm
+    uint8_t  color[4];    // rgba unorm
+    uint16_t uvs[2];      // half floats
+
+    static std::array<vk::VertexInputAttributeDescription, 4> attributeDescriptions ()
+        { // PackedVertex :: attributeDescriptions
+        
+        std::array<vk::VertexInputAttributeDescription, 4> attributes = {};
+
+        // position and object id, read as integers so the id
+        // survives exactly and the position is scaled in the shader
+        attributes[0].binding  = 0;
+        attributes[0].location = 0;
+        attributes[0].format   = vk::Format::eR16G16B16A16Uint;
+        attributes[0].offset   = offsetof(PackedVertex, position);
+
+        // normal
+        attributes[1].binding  = 0;
+        attributes[1].location = 1;
+        attributes[1].format   = vk::Format::eR16G16Snorm;
+        attributes[1].offset   = offsetof(PackedVertex, normal);
+
+        // colour
+        attributes[2].binding  = 0;
+        attributes[2].location = 2;
+        attributes[2].format   = vk::Format::eR8G8B8A8Unorm;
+        attributes[2].offset   = offsetof(PackedVertex, color);
+
+        // tcs
+        attributes[3].binding  = 0;
+        attributes[3].location = 3;
+        attributes[3].format   = vk::Format::eR16G16Sfloat;
+        attributes[3].offset   = offsetof(PackedVertex, uvs);
+
+        return attributes;
+        
+        } // PackedVertex :: attributeDescriptions
+    
+    };
+
+static_assert(sizeof(PackedVertex) == 20, "packed vertices are expected to be 20 bytes");
+
 #endif /* VulkanVertex_h */
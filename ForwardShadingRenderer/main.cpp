@@ -8,11 +8,43 @@
 #include "VulkanApp.hpp"
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
 
+//
+//  usage: ForwardShadingRenderer [--shape sphere|grid|torus|blob] [--triangles n] [--objects n]
+//
+//  draws the bust scans by default. a shape swaps them for a
+//  generated mesh of exactly the given triangles per object,
+//  for measuring frame time against geometry alone
+//
 int main (int argc, const char* argv[])
     { // main
+	VulkanOptions options;
+	options.packedVertices = false;
+	options.optimizeMeshes = false;
+
+	uint32_t objects = 4;
+
+	for (int i = 1; i < argc; i += 2)
+		{ // for each option
+
+		// a trailing option without its value falls through to the usage
+		const std::string name  = i + 1 < argc ? argv[i] : "";
+		const char*       value = argv[i + 1];
+
+		if      (name == "--shape")     options.meshShape     = value;
+		else if (name == "--triangles") options.meshTriangles = std::strtoull(value, nullptr, 10);
+		else if (name == "--objects")   objects               = (uint32_t)std::strtoul(value, nullptr, 10);
+		else
+			{
+			std::cout << "usage: " << argv[0] << " [--shape sphere|grid|torus|blob] [--triangles n] [--objects n]" << std::endl;
+			return 1;
+			}
+
+		} // for each option
+
 	VulkanApp* app;
-	app = new VulkanApp(1080, 1080, "VulkanApp", 4, 0);
+	app = new VulkanApp(1080, 1080, "VulkanApp", objects, 0, options);
 	delete app;
     return 0;
     } // main
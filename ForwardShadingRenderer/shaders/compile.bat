@@ -1,7 +1,10 @@
 cls
 
 C:\VulkanSDK\1.0.61.1\Bin32\glslangValidator -V object.vert -o vert.spv
+C:\VulkanSDK\1.0.61.1\Bin32\glslangValidator -V -DPACKED_VERTICES object.vert -o vert_packed.spv
+C:\VulkanSDK\1.0.61.1\Bin32\glslangValidator -V depth.vert -o depth.spv
 C:\VulkanSDK\1.0.61.1\Bin32\glslangValidator -V object.frag -o frag.spv
+C:\VulkanSDK\1.0.61.1\Bin32\glslangValidator -V cull.comp -o cull.spv
 
 pause
 
@@ -1,3 +1,6 @@
 #!/bin/sh
 glslangValidator -V object.vert;
+glslangValidator -V -DPACKED_VERTICES object.vert -o vert_packed.spv;
+glslangValidator -V depth.vert -o depth.spv;
 glslangValidator -V object.frag;
+glslangValidator -V cull.comp -o cull.spv;
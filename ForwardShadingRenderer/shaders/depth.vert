@@ -0,0 +1,68 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  Uniforms
+ * * * * * * * * * * * * * * * * * * * * * * * * * * */
+layout (binding = 0) uniform UniformBuffer {
+    mat4 view;
+    mat4 proj;
+
+    vec3 lightPosition;
+    vec3 eyePosition;
+
+    vec4 positionOffset;
+    vec4 positionScale;
+
+    vec4 atlas;
+
+    vec4 frustum[6]; // read by cull.comp
+    vec4 lod;
+
+} uniforms;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  Per Object Storage
+ * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct ObjectData
+    {
+    mat4 model;
+    vec4 material;
+    };
+
+layout (std430, binding = 1) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+layout (std430, binding = 2) readonly buffer InstanceBuffer {
+    uint instances[];
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  Per Vertex Inputs
+ *
+ *  the depth prepass only reads where a vertex is, the
+ *  first attribute of binding 0. the object comes from the
+ *  instance, as in object.vert
+ * * * * * * * * * * * * * * * * * * * * * * * * * * */
+layout (location = 0) in vec3 position;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  PerVertex Outputs
+ *
+ *  invariant so the shading pass, which tests for equal
+ *  depth, computes exactly the same positions
+ * * * * * * * * * * * * * * * * * * * * * * * * * * */
+ out gl_PerVertex
+	{ invariant vec4 gl_Position; };
+
+void main () 
+    { // main
+
+    uint object = instances[gl_InstanceIndex];
+
+    gl_Position = uniforms.proj * uniforms.view * (objects[object].model * vec4(position, 1.0));
+
+    } // main
@@ -6,33 +6,91 @@
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
  *  Uniforms
  * * * * * * * * * * * * * * * * * * * * * * * * * * */
-#define MAX_OBJECTS 64
 layout (binding = 0) uniform UniformBuffer {
-    mat4 model [MAX_OBJECTS];
     mat4 view;
     mat4 proj;
 
     vec3 lightPosition;
     vec3 eyePosition;
 
-    vec4 materials[MAX_OBJECTS];
+    vec4 positionOffset; // PackedVertex position decode
+    vec4 positionScale;
+
+    vec4 atlas;
+
+    vec4 frustum[6]; // read by cull.comp
+    vec4 lod;
 
 } uniforms;
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  Per Object Storage
+ *
+ *  sized by the number of objects when the scene is
+ *  built. each draw's instances are consecutive slots,
+ *  mapped back to the objects they stand for
+ * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct ObjectData
+    {
+    mat4 model;
+    vec4 material;
+    };
+
+layout (std430, binding = 1) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+layout (std430, binding = 2) readonly buffer InstanceBuffer {
+    uint instances[];
+};
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
  *  Per Vertex Inputs
+ *
+ *  compiled a second time with PACKED_VERTICES defined
+ *  to read the compact PackedVertex layout instead
  * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef PACKED_VERTICES
+layout (location = 0) in uvec4 packedPosition; // xyz quantized, w object id
+layout (location = 1) in vec2  packedNormal;   // octahedral
+layout (location = 2) in vec4  packedColor;
+layout (location = 3) in vec2  packedUvs;
+
+vec3 decodeOctahedral (vec2 e)
+    { // decodeOctahedral
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+    } // decodeOctahedral
+
+vec3 position;
+vec3 normal;
+vec3 color;
+vec2 uvs;
+int  id;
+
+void decodeVertex ()
+    { // decodeVertex
+    position = uniforms.positionOffset.xyz + vec3(packedPosition.xyz) * uniforms.positionScale.xyz;
+    normal   = decodeOctahedral(packedNormal);
+    color    = packedColor.rgb;
+    uvs      = packedUvs;
+    id       = int(packedPosition.w);
+    } // decodeVertex
+#else
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec3 color;
 layout (location = 3) in vec2 uvs;
 layout (location = 4) in int  id;
+#endif
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
  *  PerVertex Outputs
  * * * * * * * * * * * * * * * * * * * * * * * * * * */
  out gl_PerVertex
-	{ vec4 gl_Position; };
+	{ invariant vec4 gl_Position; }; // matches depth.vert for the prepass
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
  *  Interpolated Outputs
@@ -49,7 +107,16 @@ layout (location = 6) out vec2 frag_uvs;
 void main () 
     { // main
 
-    vec4 worldPosition = uniforms.model[id] * vec4(position, 1.0);
+#ifdef PACKED_VERTICES
+    decodeVertex();
+#endif
+
+    // objects sharing a mesh are told apart by their instance,
+    // mapped to the object it stands for
+    uint object = instances[gl_InstanceIndex];
+    mat4 model  = objects[object].model;
+
+    vec4 worldPosition = model * vec4(position, 1.0);
     vec4 worldNormal   = vec4(normal, 0.0);
 
   //  gl_Position = vec4(-1.0 + (uvs.s * 2.0), 1.0 - (uvs.t * 2.0), 0.0, 1.0);
@@ -60,9 +127,12 @@ void main ()
     frag_eyePosition   = ( vec4(uniforms.eyePosition.xyz, 1.0)).xyz;
 
     frag_worldPosition = worldPosition.xyz;
-    frag_worldNormal   = mat3(transpose(inverse(uniforms.model[gl_InstanceIndex]))) * worldNormal.xyz;
-    frag_material      = uniforms.materials[id];
+    frag_worldNormal   = mat3(transpose(inverse(model))) * worldNormal.xyz;
+    frag_material      = objects[object].material;
     frag_color         = color;
-    frag_uvs           = uvs;
+
+    // each object samples its own tile of the atlas
+    uint tiles = uint(uniforms.atlas.x);
+    frag_uvs   = (uvs + vec2(object % tiles, object / tiles)) / float(tiles);
 
     } // main
\ No newline at end of file
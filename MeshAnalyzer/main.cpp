@@ -0,0 +1,329 @@
+//
+//  main.cpp
+//  MeshAnalyzer
+//
+//  measures how well a .mesh will run on the gpu and prints
+//  the results as json, so a build can fail on an asset that
+//  got worse
+//
+#include "VulkanVertex.hpp"
+#include "MeshIO.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void usage ()
+    { // usage
+    std::cout << "usage: MeshAnalyzer <in.mesh> [options]"                                    << std::endl;
+    std::cout                                                                                  << std::endl;
+    std::cout << "  --views <n>            directions overdraw is sampled from, default 8"     << std::endl;
+    std::cout << "  --resolution <n>       size of the overdraw raster, default 256"           << std::endl;
+    std::cout << "  --max-acmr <x>         fail when fifo 32 acmr is above x"                  << std::endl;
+    std::cout << "  --max-overdraw <x>     fail when overdraw is above x"                      << std::endl;
+    std::cout << "  --max-overfetch <x>    fail when Vertex overfetch is above x"              << std::endl;
+    std::cout << "  --max-duplicates <x>   fail when the duplicate vertex ratio is above x"    << std::endl;
+    std::cout                                                                                  << std::endl;
+    std::cout << "exits 0 when every limit given is met, 2 when one is not"                    << std::endl;
+    } // usage
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *  JsonWriter
+ *
+ *  writes nested objects and arrays to a stream, placing
+ *  the commas and indentation as it goes
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+struct JsonWriter
+    {
+    explicit JsonWriter (std::ostream& output) : output (output) { }
+
+    void beginObject (const char* name = nullptr) { open(name, '{'); }
+    void endObject   ()                           { close('}'); }
+    void beginArray  (const char* name = nullptr) { open(name, '['); }
+    void endArray    ()                           { close(']'); }
+
+    void value (const char* name, double number)
+        {
+        separate(name);
+
+        // json has no inf or nan, so they are written as null
+        if (number != number || number - number != 0.0)
+            output << "null";
+        else
+            {
+            char text[32];
+            snprintf(text, sizeof(text), "%.6g", number);
+            output << text;
+            }
+        }
+
+    void value (const char* name, uint64_t number) { separate(name); output << number; }
+    void value (const char* name, bool flag)       { separate(name); output << (flag ? "true" : "false"); }
+
+    void value (const char* name, const std::string& text)
+        {
+        separate(name);
+        output << '"';
+        for (char c : text)
+            {
+            if (c == '"' || c == '\\')
+                output << '\\' << c;
+            else if ((unsigned char)c < 0x20)
+                {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+                output << escaped;
+                }
+            else
+                output << c;
+            }
+        output << '"';
+        }
+
+private:
+
+    void separate (const char* name)
+        {
+        if (!first.empty())
+            {
+            output << (first.back() ? "\n" : ",\n");
+            first.back() = false;
+            }
+
+        output << std::string(2 * first.size(), ' ');
+        if (name != nullptr)
+            output << '"' << name << "\": ";
+        }
+
+    void open (const char* name, char bracket)
+        {
+        separate(name);
+        output << bracket;
+        first.push_back(true);
+        }
+
+    void close (char bracket)
+        {
+        const bool empty = first.back();
+        first.pop_back();
+
+        if (!empty)
+            output << "\n" << std::string(2 * first.size(), ' ');
+        output << bracket;
+
+        if (first.empty())
+            output << std::endl;
+        }
+
+    std::ostream&     output;
+    std::vector<bool> first; // per open bracket, whether nothing is in it yet
+    };
+
+//
+//  positionDuplicates
+//
+//  vertices sharing a position with an earlier one, whatever
+//  their other attributes. these are the seams, where normals
+//  or uvs split a surface
+//
+static size_t positionDuplicates (const std::vector<Vertex>& vertices)
+    { // positionDuplicates
+
+    struct Key { uint32_t x, y, z; };
+
+    std::vector<Key> keys (vertices.size());
+    for (size_t v = 0; v < vertices.size(); ++v)
+        memcpy(&keys[v], &vertices[v].position, sizeof(Key));
+
+    auto less  = [] (const Key& a, const Key& b) { return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z; };
+    auto equal = [] (const Key& a, const Key& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+
+    std::sort(keys.begin(), keys.end(), less);
+
+    return keys.size() - (size_t)(std::unique(keys.begin(), keys.end(), equal) - keys.begin());
+
+    } // positionDuplicates
+
+int main (int argc, const char* argv[])
+    { // main
+
+    if (argc < 2)
+        {
+        usage();
+        return 1;
+        }
+
+    const char* path = argv[1];
+
+    uint32_t views      = 8;
+    uint32_t resolution = 256;
+
+    // limits below zero are not checked
+    double maxAcmr = -1.0, maxOverdraw = -1.0, maxOverfetch = -1.0, maxDuplicates = -1.0;
+
+    for (int a = 2; a < argc; ++a)
+        {
+        const std::string option = argv[a];
+
+        if (a + 1 >= argc)
+            {
+            usage();
+            return 1;
+            }
+
+        const char* argument = argv[++a];
+
+        if      (option == "--views")          views         = (uint32_t)std::stoul(argument);
+        else if (option == "--resolution")     resolution    = (uint32_t)std::stoul(argument);
+        else if (option == "--max-acmr")       maxAcmr       = std::stod(argument);
+        else if (option == "--max-overdraw")   maxOverdraw   = std::stod(argument);
+        else if (option == "--max-overfetch")  maxOverfetch  = std::stod(argument);
+        else if (option == "--max-duplicates") maxDuplicates = std::stod(argument);
+        else
+            {
+            usage();
+            return 1;
+            }
+        }
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(path, asset))
+        {
+        std::cerr << "failed to read " << path << std::endl;
+        return 1;
+        }
+
+    const std::vector<uint32_t>& indices  = asset.indices;
+    const std::vector<Vertex>&   vertices = asset.vertices;
+
+    JsonWriter json (std::cout);
+
+    json.beginObject();
+    json.value("file",      std::string(path));
+    json.value("vertices",  (uint64_t)vertices.size());
+    json.value("triangles", (uint64_t)(indices.size() / 3));
+
+    // post transform cache, acmr being shader runs per triangle
+    // and atvr runs per vertex the mesh uses
+    VertexCacheStats gate;
+
+    json.beginArray("vertexCache");
+    for (bool fifo : { true, false })
+        for (uint32_t size : { 16u, 32u, 64u, 128u })
+            {
+            VertexCacheStats stats = MeshIO::analyzeVertexCache(indices.data(), indices.size(), vertices.size(), size, fifo);
+            if (fifo && size == 32)
+                gate = stats;
+
+            json.beginObject();
+            json.value("policy", std::string(fifo ? "fifo" : "lru"));
+            json.value("size",   (uint64_t)size);
+            json.value("acmr",   (double)stats.acmr);
+            json.value("atvr",   (double)stats.atvr);
+            json.endObject();
+            }
+    json.endArray();
+
+    OverdrawStats overdraw = MeshIO::analyzeOverdraw(vertices, indices, views, resolution);
+
+    json.beginObject("overdraw");
+    json.value("views",      (uint64_t)views);
+    json.value("resolution", (uint64_t)resolution);
+    json.value("ratio",      (double)overdraw.overdraw);
+    json.value("covered",    overdraw.covered);
+    json.value("shaded",     overdraw.shaded);
+    json.endObject();
+
+    // efficiency is the share of fetched bytes a vertex used,
+    // the inverse of overfetch, for each layout we can upload
+    VertexFetchStats interleaved;
+
+    json.beginArray("vertexFetch");
+    for (size_t stride : { sizeof(Vertex), sizeof(PackedVertex), sizeof(VertexPosition) })
+        {
+        VertexFetchStats stats = MeshIO::analyzeVertexFetch(indices.data(), indices.size(), vertices.size(), stride);
+        if (stride == sizeof(Vertex))
+            interleaved = stats;
+
+        json.beginObject();
+        json.value("stride",     (uint64_t)stride);
+        json.value("fetched",    stats.fetched);
+        json.value("used",       stats.used);
+        json.value("overfetch",  (double)stats.overfetch);
+        json.value("efficiency", stats.fetched ? (double)stats.used / (double)stats.fetched : 0.0);
+        json.endObject();
+        }
+    json.endArray();
+
+    // exact duplicates are found by welding a copy, which
+    // leaves the asset as it was read
+    std::vector<uint32_t> weldedIndices  = indices;
+    std::vector<Vertex>   weldedVertices = vertices;
+    WeldStats weld = MeshIO::weld(weldedIndices, weldedVertices, 0.0f);
+
+    const size_t seams = positionDuplicates(vertices);
+    const double ratio = vertices.empty() ? 0.0 : (double)(weld.verticesBefore - weld.verticesAfter) / (double)vertices.size();
+
+    json.beginObject("duplicates");
+    json.value("exact",         (uint64_t)(weld.verticesBefore - weld.verticesAfter));
+    json.value("ratio",         ratio);
+    json.value("position",      (uint64_t)seams);
+    json.value("positionRatio", vertices.empty() ? 0.0 : (double)seams / (double)vertices.size());
+    json.endObject();
+
+    json.beginArray("levels");
+    for (const MeshLOD& lod : asset.lods)
+        {
+        VertexCacheStats stats = MeshIO::analyzeVertexCache(asset.lodIndices.data() + lod.firstIndex, lod.indexCount, vertices.size(), 32);
+
+        json.beginObject();
+        json.value("triangles", (uint64_t)(lod.indexCount / 3));
+        json.value("error",     (double)lod.error);
+        json.value("acmr",      (double)stats.acmr);
+        json.endObject();
+        }
+    json.endArray();
+
+    struct Limit
+        {
+        const char* name;
+        double      measured;
+        double      limit;
+        };
+
+    const Limit limits[] =
+        {
+        { "acmr",       gate.acmr,             maxAcmr       },
+        { "overdraw",   overdraw.overdraw,     maxOverdraw   },
+        { "overfetch",  interleaved.overfetch, maxOverfetch  },
+        { "duplicates", ratio,                 maxDuplicates }
+        };
+
+    bool pass = true;
+
+    json.beginArray("limits");
+    for (const Limit& limit : limits)
+        {
+        if (limit.limit < 0.0)
+            continue;
+
+        const bool met = limit.measured <= limit.limit;
+        pass = pass && met;
+
+        json.beginObject();
+        json.value("metric",   std::string(limit.name));
+        json.value("measured", limit.measured);
+        json.value("limit",    limit.limit);
+        json.value("pass",     met);
+        json.endObject();
+        }
+    json.endArray();
+
+    json.value("pass", pass);
+    json.endObject();
+
+    return pass ? 0 : 2;
+
+    } // main
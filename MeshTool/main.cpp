@@ -0,0 +1,1401 @@
+//
+//  main.cpp
+//  MeshTool
+//
+//  command line utility for conditioning and measuring
+//  .mesh assets offline, outside of the renderer
+//
+#include "VulkanVertex.hpp"
+#include "MeshIO.hpp"
+#include "MeshImporter.hpp"
+#include "Frustum.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double elapsed (Clock::time_point start)
+    { // elapsed
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } // elapsed
+
+static void usage ()
+    { // usage
+    std::cout << "usage: MeshTool <command> [arguments]"                          << std::endl;
+    std::cout                                                                      << std::endl;
+    std::cout << "  info       <in.mesh>              print the header and sections"   << std::endl;
+    std::cout << "  convert    <in.mesh> <out.mesh>   rewrite as a v2 container"       << std::endl;
+    std::cout << "  compress   <in.mesh> <out.mesh>   rewrite with compressed sections" << std::endl;
+    std::cout << "  import     <in.obj|ply> <out.mesh> convert a scan to a .mesh"        << std::endl;
+    std::cout << "  generate   <shape> <triangles> <out.mesh> [seed]"                       << std::endl;
+    std::cout << "                                    build a sphere, grid, torus or blob" << std::endl;
+    std::cout << "  quantize   <in.mesh> <out.mesh>   add the packed vertex layout"    << std::endl;
+    std::cout << "  weld       <in.mesh> <out.mesh> [epsilon]"                              << std::endl;
+    std::cout << "                                    merge duplicate vertices"         << std::endl;
+    std::cout << "  lod        <in.mesh> <out.mesh> [max error]"                            << std::endl;
+    std::cout << "                                    build the level of detail chain"  << std::endl;
+    std::cout << "  meshlets   <in.mesh> <out.mesh>   build culling clusters"            << std::endl;
+    std::cout << "  progressive <in.mesh> <out.mesh>  order for coarse first streaming"  << std::endl;
+    std::cout << "  optimize   <in.mesh> <out.mesh> [threshold]"                            << std::endl;
+    std::cout << "                                    reorder for cache, overdraw, fetch" << std::endl;
+    std::cout << "  bench-load <in.mesh> [runs]       compare stream and mapped loads" << std::endl;
+    std::cout << "  bench-bounds <in.mesh> [runs]     check and time the bounds kernels" << std::endl;
+    std::cout << "  bench-merge  <in.mesh> [objects]  compare per object and batch merges" << std::endl;
+    std::cout << "  bench-codec  <in.mesh> [runs]     compare compressed and raw loads" << std::endl;
+    std::cout << "  bench-cache  <in.mesh> <cache dir> time an optimized load, miss then hit" << std::endl;
+    std::cout << "  bench-streams <in.mesh> [runs]    compare interleaved and split depth passes" << std::endl;
+    std::cout << "  bench-progressive <in.mesh> [runs] time each streamed level against a whole read" << std::endl;
+    std::cout << "  bench-cull [objects] [runs]       check and time the frustum culling kernels" << std::endl;
+    } // usage
+
+//
+//  info
+//
+//  prints the version, section table and bounds of a .mesh
+//  and checks the section checksums
+//
+static int info (const char* path)
+    { // info
+
+    MeshView view;
+    if (!MeshIO::mapMeshFile(path, view))
+        {
+        std::cout << "failed to map " << path << std::endl;
+        return 1;
+        }
+
+    std::cout << "  version   : " << view.version               << std::endl;
+    std::cout << "  vertices  : " << view.vertices.size         << std::endl;
+    std::cout << "  triangles : " << view.indexCount() / 3      << std::endl;
+
+    for (const MeshFormat::SectionEntry& section : view.sections)
+        {
+        std::cout << "  section " << section.type
+                  << " @ "  << section.offset
+                  << " : "  << section.count << " x " << section.stride << " bytes";
+
+        if (section.flags & MeshFormat::eCompressed)
+            std::cout << ", compressed to " << section.size;
+
+        std::cout << std::endl;
+        }
+
+    if (view.hasBounds)
+        {
+        const MeshBounds& b = view.bounds;
+        std::cout << "  aabb      : (" << b.min.x << ", " << b.min.y << ", " << b.min.z << ") - ("
+                                        << b.max.x << ", " << b.max.y << ", " << b.max.z << ")" << std::endl;
+        std::cout << "  sphere    : (" << b.center.x << ", " << b.center.y << ", " << b.center.z << ") r " << b.radius << std::endl;
+        }
+
+    for (size_t l = 0; l < view.lods.size; ++l)
+        std::cout << "  lod " << l + 1 << "     : " << view.lods[l].indexCount / 3
+                  << " triangles, error " << view.lods[l].error << std::endl;
+
+    if (view.meshlets.size)
+        std::cout << "  meshlets  : " << view.meshlets.size << std::endl;
+
+    bool valid = MeshIO::verify(view);
+    std::cout << "  checksums : " << (valid ? "ok" : "MISMATCH") << std::endl;
+
+    return valid ? 0 : 1;
+
+    } // info
+
+//
+//  convert
+//
+//  reads a v1 or v2 .mesh and writes it back out as v2
+//
+static int convert (const char* in, const char* out)
+    { // convert
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // convert
+
+//
+//  compress
+//
+//  rewrites a .mesh with its large sections compressed and
+//  reports how much smaller each one became
+//
+static int compress (const char* in, const char* out)
+    { // compress
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    if (!MeshIO::writeMeshAsset(out, asset, true))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    MeshView view;
+    if (!MeshIO::mapMeshFile(out, view))
+        {
+        std::cout << "failed to map " << out << std::endl;
+        return 1;
+        }
+
+    uint64_t raw = view.file.size;
+
+    for (const MeshFormat::SectionEntry& section : view.sections)
+        if (section.flags & MeshFormat::eCompressed)
+            {
+            const uint64_t decoded = (uint64_t)section.count * section.stride;
+            raw += decoded - section.size;
+
+            std::cout << "  section " << section.type << " : " << decoded << " -> " << section.size
+                      << " bytes (" << (double)decoded / section.size << ":1)" << std::endl;
+            }
+
+    std::cout << "  file      : " << raw << " -> " << view.file.size
+              << " bytes (" << (double)raw / view.file.size << ":1)" << std::endl;
+
+    return 0;
+
+    } // compress
+
+//
+//  quantize
+//
+//  adds the PackedVertex sections to a .mesh and reports the
+//  worst case error the packing introduces
+//
+static int quantize (const char* in, const char* out)
+    { // quantize
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    asset.quantization = MeshIO::quantize(asset.vertices.data(), asset.vertices.size(), asset.packed);
+
+    QuantizationError error = MeshIO::quantizationError(
+            asset.vertices.data(),
+            asset.packed.data(),
+            asset.vertices.size(),
+            asset.quantization);
+
+    std::cout << "  vertex size    : " << sizeof(Vertex) << " -> " << sizeof(PackedVertex) << " bytes" << std::endl;
+    std::cout << "  position error : " << error.position << std::endl;
+    std::cout << "  normal error   : " << error.normal   << " degrees" << std::endl;
+    std::cout << "  colour error   : " << error.color    << std::endl;
+    std::cout << "  uv error       : " << error.uvs      << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // quantize
+
+//
+//  import
+//
+//  converts a Wavefront .obj or a .ply into a .mesh
+//
+static int import (const char* in, const char* out)
+    { // import
+
+    MeshAsset asset;
+
+    Clock::time_point start = Clock::now();
+    if (!MeshImporter::importMesh(in, asset))
+        {
+        std::cout << "failed to import " << in << std::endl;
+        return 1;
+        }
+    double ms = elapsed(start);
+
+    MappedFile file;
+    file.open(in);
+    const double mb = (double)file.size / (1000.0 * 1000.0);
+    file.close();
+
+    asset.bounds    = MeshIO::computeBounds(asset.vertices.data(), asset.vertices.size());
+    asset.hasBounds = true;
+
+    std::cout << "  vertices  : " << asset.vertices.size()     << std::endl;
+    std::cout << "  triangles : " << asset.indices.size() / 3  << std::endl;
+    std::cout << "  took      : " << ms << "ms (" << mb / (ms / 1000.0) << " MB/s) on " << Parallel::threads() << " threads" << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // import
+
+//
+//  generate
+//
+//  writes a procedural shape of exactly the given number of
+//  triangles, for sweeping the renderer across budgets
+//
+static int generate (const char* name, uint64_t triangles, const char* out, uint32_t seed)
+    { // generate
+
+    MeshGenerator::Shape shape;
+    if (!MeshGenerator::parse(name, shape))
+        {
+        std::cout << "unknown shape " << name << ", expected sphere, grid, torus or blob" << std::endl;
+        return 1;
+        }
+
+    MeshAsset asset;
+
+    Clock::time_point start = Clock::now();
+    if (!MeshGenerator::generate(shape, triangles, asset.vertices, asset.indices, seed))
+        {
+        std::cout << "a " << name << " can not be built from " << triangles << " triangles" << std::endl;
+        return 1;
+        }
+    double ms = elapsed(start);
+
+    asset.bounds    = MeshIO::computeBounds(asset.vertices.data(), asset.vertices.size());
+    asset.hasBounds = true;
+
+    std::cout << "  vertices  : " << asset.vertices.size()     << std::endl;
+    std::cout << "  triangles : " << asset.indices.size() / 3  << std::endl;
+    std::cout << "  took      : " << ms << "ms on " << Parallel::threads() << " threads" << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // generate
+
+//
+//  weld
+//
+//  removes duplicate vertices and reports how much it saved
+//
+static int weld (const char* in, const char* out, float epsilon)
+    { // weld
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    Clock::time_point start = Clock::now();
+    WeldStats stats = MeshIO::weld(asset.indices, asset.vertices, epsilon, asset.packed.empty() ? nullptr : &asset.packed);
+    double ms = elapsed(start);
+
+    asset.indexFlags |= MeshFormat::eWelded;
+    if (stats.verticesAfter != stats.verticesBefore)
+        asset.indexFlags &= ~(MeshFormat::eVertexFetchOptimized | MeshFormat::eProgressive);
+    if (stats.trianglesAfter != stats.trianglesBefore)
+        asset.indexFlags &= ~(MeshFormat::eVertexCacheOptimized | MeshFormat::eOverdrawOptimized);
+    if (asset.hasBounds)
+        asset.bounds = MeshIO::computeBounds(asset.vertices.data(), asset.vertices.size());
+
+    std::cout << "  vertices  : " << stats.verticesBefore  << " -> " << stats.verticesAfter  << std::endl;
+    std::cout << "  triangles : " << stats.trianglesBefore << " -> " << stats.trianglesAfter << std::endl;
+    std::cout << "  reduction : " << stats.reduction * 100.0f << "%" << std::endl;
+    std::cout << "  took      : " << ms << "ms on " << Parallel::threads() << " threads" << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // weld
+
+//
+//  lod
+//
+//  generates the level of detail chain and reports the size
+//  and error of each level
+//
+static int lod (const char* in, const char* out, float maxError)
+    { // lod
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    MeshOptimizeOptions options;
+
+    Clock::time_point start = Clock::now();
+    MeshIO::generateLevels(asset, options.levelRatios, maxError);
+    double ms = elapsed(start);
+
+    asset.indexFlags |= MeshFormat::eLevelsOfDetail;
+    asset.indexFlags &= ~MeshFormat::eProgressive;
+
+    const size_t triangles = asset.indices.size() / 3;
+    std::cout << "  lod 0 : " << triangles << " triangles" << std::endl;
+
+    for (size_t l = 0; l < asset.lods.size(); ++l)
+        {
+        const MeshLOD& level = asset.lods[l];
+        std::cout << "  lod " << l + 1 << " : " << level.indexCount / 3 << " triangles ("
+                  << 100.0f * (float)(level.indexCount / 3) / (float)triangles << "%), error "
+                  << level.error << std::endl;
+        }
+
+    std::cout << "  took  : " << ms << "ms" << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // lod
+
+//
+//  progressive
+//
+//  orders a mesh for streaming coarsest level first, building
+//  the lod chain if it has none, and reports how much of the
+//  file each level needs before it can be drawn
+//
+static int progressive (const char* in, const char* out)
+    { // progressive
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    if (asset.lods.empty())
+        {
+        MeshOptimizeOptions options;
+        MeshIO::generateLevels(asset, options.levelRatios, options.levelError);
+        asset.indexFlags |= MeshFormat::eLevelsOfDetail;
+        }
+
+    if (!MeshIO::makeProgressive(asset))
+        {
+        std::cout << "no levels could be built for " << in << std::endl;
+        return 1;
+        }
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    // everything ahead of the vertex section is read before the
+    // coarsest level, then each level needs a longer prefix of it
+    MeshView view;
+    if (!MeshIO::mapMeshFile(out, view))
+        {
+        std::cout << "failed to map " << out << std::endl;
+        return 1;
+        }
+
+    uint64_t front = 0;
+    for (const MeshFormat::SectionEntry& section : view.sections)
+        if (section.type == MeshFormat::eVertices)
+            front = section.offset;
+
+    for (size_t l = asset.lods.size(); l-- > 0; )
+        {
+        const uint64_t bytes = front + sizeof(Vertex) * (uint64_t)asset.lods[l].vertexCount;
+        std::cout << "  lod " << l + 1 << " : " << asset.lods[l].vertexCount << " vertices, "
+                  << bytes / 1024 << " KB (" << 100.0 * bytes / view.file.size << "%)" << std::endl;
+        }
+
+    std::cout << "  lod 0 : " << asset.vertices.size() << " vertices, " << view.file.size / 1024 << " KB" << std::endl;
+
+    return 0;
+
+    } // progressive
+
+//
+//  meshlets
+//
+//  clusters a mesh and reports how full the meshlets are
+//  and how many of them the normal cones could cull from a
+//  ring of viewpoints around the mesh
+//
+static int meshlets (const char* in, const char* out)
+    { // meshlets
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    Clock::time_point start = Clock::now();
+    MeshIO::buildMeshlets(asset);
+    double ms = elapsed(start);
+
+    asset.indexFlags |= MeshFormat::eMeshletsBuilt;
+
+    const size_t count = asset.meshlets.size();
+    size_t       cones = 0;
+
+    for (const Meshlet& meshlet : asset.meshlets)
+        if (meshlet.coneCutoff < 1.0f)
+            cones++;
+
+    MeshBounds bounds = MeshIO::computeBounds(asset.vertices.data(), asset.vertices.size());
+
+    const uint32_t views  = 8;
+    size_t         culled = 0;
+
+    for (uint32_t v = 0; v < views; ++v)
+        {
+        float     angle = 6.2831853f * (float)v / (float)views;
+        glm::vec3 eye   = bounds.center + glm::vec3(std::cos(angle), std::sin(angle), 0.0f) * bounds.radius * 3.0f;
+
+        for (const Meshlet& meshlet : asset.meshlets)
+            if (MeshIO::meshletBackfacing(meshlet, eye))
+                culled++;
+        }
+
+    std::cout << "  meshlets  : " << count << std::endl;
+    std::cout << "  vertices  : " << (float)asset.meshletVertices.size() / (float)count << " per meshlet, "
+              << (float)asset.meshletVertices.size() / (float)asset.vertices.size() << "x the mesh" << std::endl;
+    std::cout << "  triangles : " << (float)(asset.indices.size() / 3) / (float)count << " per meshlet" << std::endl;
+    std::cout << "  cones     : " << 100.0f * (float)cones / (float)count << "% usable" << std::endl;
+    std::cout << "  culled    : " << 100.0f * (float)culled / (float)(count * views) << "% backfacing on average" << std::endl;
+    std::cout << "  took      : " << ms << "ms" << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // meshlets
+
+//
+//  report
+//
+//  prints simulated fifo acmr/atvr for a few cache sizes,
+//  the overdraw seen from a spread of viewpoints and the
+//  vertex fetch overfetch for both vertex layouts
+//
+static void report (const char* label, const MeshAsset& asset)
+    { // report
+
+    std::cout << "  " << label << std::endl;
+
+    for (uint32_t cacheSize : { 16u, 32u })
+        {
+        VertexCacheStats stats = MeshIO::analyzeVertexCache(
+                asset.indices.data(),
+                asset.indices.size(),
+                asset.vertices.size(),
+                cacheSize);
+
+        std::cout << "    fifo " << cacheSize << " : acmr " << stats.acmr << ", atvr " << stats.atvr << std::endl;
+        }
+
+    OverdrawStats overdraw = MeshIO::analyzeOverdraw(asset.vertices, asset.indices);
+    std::cout << "    overdraw : " << overdraw.overdraw << std::endl;
+
+    for (size_t vertexSize : { sizeof(Vertex), sizeof(PackedVertex) })
+        {
+        VertexFetchStats fetch = MeshIO::analyzeVertexFetch(
+                asset.indices.data(),
+                asset.indices.size(),
+                asset.vertices.size(),
+                vertexSize);
+
+        std::cout << "    fetch " << vertexSize << "B : overfetch " << fetch.overfetch << std::endl;
+        }
+
+    } // report
+
+//
+//  optimize
+//
+//  runs the mesh conditioning passes and reports their effect
+//
+static int optimize (const char* in, const char* out, float threshold)
+    { // optimize
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(in, asset))
+        {
+        std::cout << "failed to read " << in << std::endl;
+        return 1;
+        }
+
+    report("before", asset);
+
+    MeshOptimizeOptions options;
+        options.overdraw          = false;
+        options.vertexFetch       = false;
+        options.levels            = false;
+        options.meshlets          = false;
+        options.overdrawThreshold = threshold;
+
+    // run the passes one at a time so each gets its own numbers
+    Clock::time_point start = Clock::now();
+    asset.indexFlags &= ~(MeshFormat::eWelded | MeshFormat::eVertexCacheOptimized | MeshFormat::eOverdrawOptimized | MeshFormat::eVertexFetchOptimized | MeshFormat::eLevelsOfDetail | MeshFormat::eMeshletsBuilt | MeshFormat::eProgressive);
+    MeshIO::optimize(asset, options);
+    double cacheMs = elapsed(start);
+
+    report("vertex cache", asset);
+    std::cout << "  took " << cacheMs << "ms" << std::endl;
+
+    options.overdraw = true;
+    start = Clock::now();
+    MeshIO::optimize(asset, options);
+    double overdrawMs = elapsed(start);
+
+    report("overdraw", asset);
+    std::cout << "  took " << overdrawMs << "ms" << std::endl;
+
+    options.vertexFetch = true;
+    start = Clock::now();
+    MeshIO::optimize(asset, options);
+    double fetchMs = elapsed(start);
+
+    report("vertex fetch", asset);
+    std::cout << "  took " << fetchMs << "ms" << std::endl;
+
+    options.levels   = true;
+    options.meshlets = true;
+    start = Clock::now();
+    MeshIO::optimize(asset, options);
+    double levelsMs = elapsed(start);
+
+    std::cout << "  meshlets " << asset.meshlets.size() << std::endl;
+    std::cout << "  levels" << std::endl;
+    for (const MeshLOD& level : asset.lods)
+        std::cout << "    " << level.indexCount / 3 << " triangles, error " << level.error << std::endl;
+    std::cout << "  took " << levelsMs << "ms" << std::endl;
+
+    if (!MeshIO::writeMeshAsset(out, asset))
+        {
+        std::cout << "failed to write " << out << std::endl;
+        return 1;
+        }
+
+    return 0;
+
+    } // optimize
+
+//
+//  benchLoad
+//
+//  times getting a .mesh from disk into a destination buffer
+//  standing in for mapped device memory, once through the
+//  ifstream path and once through the mapped path, with both a
+//  cold and a warm page cache
+//
+static int benchLoad (const char* path, uint32_t runs)
+    { // benchLoad
+
+    MeshView probe;
+    if (!MeshIO::mapMeshFile(path, probe))
+        {
+        std::cout << "failed to map " << path << std::endl;
+        return 1;
+        }
+
+    const size_t vBytes = probe.vertices.bytes();
+    const size_t iBytes = probe.indexBytes();
+    const size_t iCount = probe.indexCount();
+    const double mb     = (double)probe.file.size / (1000.0 * 1000.0);
+    probe.file.close();
+
+    // the stream path always hands back 32 bit indices
+    std::vector<uint8_t> destination (vBytes + sizeof(uint32_t) * iCount);
+
+    for (uint32_t cold = 0; cold < 2; ++cold)
+        { // for each cache state
+
+        double stream = 0.0;
+        double mapped = 0.0;
+
+        for (uint32_t r = 0; r < runs; ++r)
+            { // for each run
+
+            if (cold) MappedFile::evict(path);
+
+            Clock::time_point start = Clock::now();
+                {
+                std::vector<Vertex>   vertices;
+                std::vector<uint32_t> indices;
+                MeshIO::readMeshFile(path, vertices, indices);
+                memcpy(destination.data(),          vertices.data(), vBytes);
+                memcpy(destination.data() + vBytes, indices.data(),  sizeof(uint32_t) * indices.size());
+                }
+            stream += elapsed(start);
+
+            if (cold) MappedFile::evict(path);
+
+            start = Clock::now();
+                {
+                MeshView view;
+                MeshIO::mapMeshFile(path, view);
+                memcpy(destination.data(),          view.vertices.data, vBytes);
+                memcpy(destination.data() + vBytes, view.indexData(), iBytes);
+                }
+            mapped += elapsed(start);
+
+            } // for each run
+
+        stream /= runs;
+        mapped /= runs;
+
+        std::cout << (cold ? "  cold cache" : "  warm cache") << std::endl;
+        std::cout << "    stream : " << stream << "ms (" << mb / (stream / 1000.0) << " MB/s)" << std::endl;
+        std::cout << "    mapped : " << mapped << "ms (" << mb / (mapped / 1000.0) << " MB/s)" << std::endl;
+
+        } // for each cache state
+
+    return 0;
+
+    } // benchLoad
+
+//
+//  outside
+//
+//  counts positions further from the sphere centre than its
+//  radius, allowing for float rounding in the kernels
+//
+static size_t outside (const Bounds::Positions& positions, const Bounds::Sphere& sphere)
+    { // outside
+    size_t count = 0;
+    for (size_t v = 0; v < positions.count; ++v)
+        if (glm::length(positions.at(v) - sphere.center) > sphere.radius * (1.0f + 1e-5f) + 1e-6f)
+            count++;
+    return count;
+    } // outside
+
+//
+//  benchBounds
+//
+//  checks the vectorised bounds kernels against the scalar
+//  reference and every sphere against the positions it should
+//  hold, then times each kernel in vertices per second
+//
+static int benchBounds (const char* path, uint32_t runs)
+    { // benchBounds
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(path, asset, MeshFormat::bit(MeshFormat::eVertices)))
+        {
+        std::cout << "failed to read " << path << std::endl;
+        return 1;
+        }
+
+    const Bounds::Positions positions = Bounds::positions(asset.vertices.data(), asset.vertices.size());
+
+    const Bounds::Extents reference = Bounds::extentsScalar(positions);
+
+    struct Kernel
+        {
+        const char*     name;
+        Bounds::Extents (*extents) (const Bounds::Positions&);
+        };
+
+    std::vector<Kernel> kernels = { { "scalar", Bounds::extentsScalar } };
+#if defined(BOUNDS_SSE2)
+    kernels.push_back({ "sse2  ", Bounds::extentsSSE });
+#endif
+#if defined(BOUNDS_AVX2)
+    if (Cpu::avx2())
+        kernels.push_back({ "avx2  ", Bounds::extentsAVX2 });
+#endif
+
+    bool valid = true;
+
+    for (const Kernel& kernel : kernels)
+        { // for each kernel
+
+        Bounds::Extents result = kernel.extents(positions);
+
+        bool same = result.min == reference.min && result.max == reference.max &&
+                    glm::length(result.centroid - reference.centroid) <= 1e-5f * (1.0f + glm::length(reference.centroid));
+        for (int a = 0; a < 3; ++a)
+            same = same && result.minIndex[a] == reference.minIndex[a] && result.maxIndex[a] == reference.maxIndex[a];
+
+        valid = valid && same;
+
+        Clock::time_point start = Clock::now();
+        for (uint32_t r = 0; r < runs; ++r)
+            result = kernel.extents(positions);
+        double ms = elapsed(start) / runs;
+
+        std::cout << "  extents " << kernel.name << " : " << ms << "ms, "
+                  << (double)positions.count / (ms * 1000.0) << " Mvertices/s"
+                  << (same ? "" : "  MISMATCH") << std::endl;
+
+        } // for each kernel
+
+    Bounds::Spheres scalar = Bounds::spheresScalar(positions, reference);
+
+    Clock::time_point start = Clock::now();
+    for (uint32_t r = 0; r < runs; ++r)
+        Bounds::spheresScalar(positions, reference);
+    double scalarMs = elapsed(start) / runs;
+
+    start = Clock::now();
+    Bounds::Spheres spheres = Bounds::spheres(positions, reference);
+    for (uint32_t r = 1; r < runs; ++r)
+        spheres = Bounds::spheres(positions, reference);
+    double spheresMs = elapsed(start) / runs;
+
+    start = Clock::now();
+    Bounds::Sphere exact = Bounds::welzl(positions);
+    double welzlMs = elapsed(start);
+
+    std::cout << "  spheres scalar : " << scalarMs  << "ms, " << (double)positions.count / (scalarMs  * 1000.0) << " Mvertices/s" << std::endl;
+    std::cout << "  spheres        : " << spheresMs << "ms, " << (double)positions.count / (spheresMs * 1000.0) << " Mvertices/s" << std::endl;
+    std::cout << "  welzl          : " << welzlMs   << "ms, " << (double)positions.count / (welzlMs   * 1000.0) << " Mvertices/s" << std::endl;
+
+    struct Named
+        {
+        const char*    name;
+        Bounds::Sphere sphere;
+        };
+
+    const Named named[] = {
+        { "box   ", spheres.box },
+        { "ritter", spheres.ritter },
+        { "scalar", scalar.ritter },
+        { "welzl ", exact } };
+
+    for (const Named& entry : named)
+        {
+        size_t missed = outside(positions, entry.sphere);
+        valid = valid && missed == 0 && entry.sphere.radius >= exact.radius * (1.0f - 1e-5f);
+
+        std::cout << "  " << entry.name << " : r " << entry.sphere.radius
+                  << " (" << 100.0f * (entry.sphere.radius / exact.radius - 1.0f) << "% over exact)"
+                  << (missed ? "  MISSES " + std::to_string(missed) : std::string()) << std::endl;
+        }
+
+    std::cout << (valid ? "  kernels agree" : "  kernels DISAGREE") << std::endl;
+
+    return valid ? 0 : 1;
+
+    } // benchBounds
+
+//
+//  benchMerge
+//
+//  batches copies of a mesh the way createSceneMesh does, once
+//  an object at a time through merge and assign and once through
+//  the batch merge, and checks both give the same arrays
+//
+static int benchMerge (const char* path, uint32_t objects)
+    { // benchMerge
+
+    MeshView view;
+    if (!MeshIO::mapMeshFile(path, view))
+        {
+        std::cout << "failed to map " << path << std::endl;
+        return 1;
+        }
+
+    // each result is reduced to checksums and freed before the next
+    // merge runs, so neither starts with the other's memory in use
+    uint64_t serialVertices, serialIndices;
+    double   serial;
+        {
+        std::vector<Vertex>   vertices;
+        std::vector<uint32_t> indices;
+
+        Clock::time_point start = Clock::now();
+        for (uint32_t i = 0; i < objects; ++i)
+            {
+            size_t first = vertices.size();
+            if (view.indices16.size)
+                MeshIO::merge(vertices, indices, view.vertices, view.indices16);
+            else
+                MeshIO::merge(vertices, indices, view.vertices, view.indices);
+            MeshIO::assign(vertices, i, first);
+            }
+        serial = elapsed(start);
+
+        serialVertices = MeshIO::checksum(vertices.data(), sizeof(Vertex)   * vertices.size());
+        serialIndices  = MeshIO::checksum(indices.data(),  sizeof(uint32_t) * indices.size());
+        }
+
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+
+    Clock::time_point start = Clock::now();
+    std::vector<MeshBatchItem> items (objects);
+    for (uint32_t i = 0; i < objects; ++i)
+        {
+        items[i].vertices  = view.vertices;
+        items[i].indices   = view.indices;
+        items[i].indices16 = view.indices16;
+        items[i].id        = static_cast<int32_t>(i);
+        }
+    MeshIO::merge(vertices, indices, items);
+    double batch = elapsed(start);
+
+    bool same = serialVertices == MeshIO::checksum(vertices.data(), sizeof(Vertex)   * vertices.size()) &&
+                serialIndices  == MeshIO::checksum(indices.data(),  sizeof(uint32_t) * indices.size());
+
+    const double mb = (double)(sizeof(Vertex) * vertices.size() + sizeof(uint32_t) * indices.size()) / (1000.0 * 1000.0);
+
+    std::cout << "  objects  : " << objects << ", " << vertices.size() << " vertices, " << indices.size() << " indices" << std::endl;
+    std::cout << "  serial   : " << serial << "ms (" << mb / (serial / 1000.0) << " MB/s)" << std::endl;
+    std::cout << "  batch    : " << batch  << "ms (" << mb / (batch  / 1000.0) << " MB/s) on " << Parallel::threads() << " threads" << std::endl;
+    std::cout << (same ? "  results match" : "  results DIFFER") << std::endl;
+
+    return same ? 0 : 1;
+
+    } // benchMerge
+
+//
+//  benchCodec
+//
+//  writes a mesh out raw and compressed and times reading the
+//  geometry back from each, through the stream reader and the
+//  mapping, plus the block decoder alone running out of memory
+//
+static int benchCodec (const char* path, uint32_t runs)
+    { // benchCodec
+
+    MeshAsset asset;
+    if (!MeshIO::readMeshAsset(path, asset))
+        {
+        std::cout << "failed to read " << path << std::endl;
+        return 1;
+        }
+
+    const std::string raw    = std::string(path) + ".raw";
+    const std::string packed = std::string(path) + ".packed";
+
+    if (!MeshIO::writeMeshAsset(raw.c_str(), asset) || !MeshIO::writeMeshAsset(packed.c_str(), asset, true))
+        {
+        std::cout << "failed to write beside " << path << std::endl;
+        return 1;
+        }
+
+    const uint64_t vertices = MeshIO::checksum(asset.vertices.data(), sizeof(Vertex)   * asset.vertices.size());
+    const uint64_t indices  = MeshIO::checksum(asset.indices.data(),  sizeof(uint32_t) * asset.indices.size());
+    const double   gb       = (double)(sizeof(Vertex) * asset.vertices.size() + sizeof(uint32_t) * asset.indices.size()) / 1e9;
+
+    asset = MeshAsset();
+
+    const uint32_t geometry = MeshFormat::bit(MeshFormat::eVertices) | MeshFormat::bit(MeshFormat::eIndices);
+    bool same = true;
+
+    double streamRaw = 0.0, streamPacked = 0.0;
+    double mappedRaw = 0.0, mappedPacked = 0.0;
+
+    for (uint32_t r = 0; r < runs; ++r)
+        { // for each run
+
+        Clock::time_point start = Clock::now();
+        MeshIO::readMeshAsset(raw.c_str(), asset, geometry);
+        streamRaw += elapsed(start);
+
+        start = Clock::now();
+        MeshIO::readMeshAsset(packed.c_str(), asset, geometry);
+        streamPacked += elapsed(start);
+
+        same = same &&
+            MeshIO::checksum(asset.vertices.data(), sizeof(Vertex)   * asset.vertices.size()) == vertices &&
+            MeshIO::checksum(asset.indices.data(),  sizeof(uint32_t) * asset.indices.size())  == indices;
+
+        // the raw mapping is only touched, so copy it out to
+        // make it do the same work as the decode
+        start = Clock::now();
+            {
+            MeshView view;
+            MeshIO::mapMeshFile(raw.c_str(), view);
+            std::vector<uint8_t> copy (view.vertices.bytes() + view.indexBytes());
+            memcpy(copy.data(),                         view.vertices.data, view.vertices.bytes());
+            memcpy(copy.data() + view.vertices.bytes(), view.indexData(),   view.indexBytes());
+            }
+        mappedRaw += elapsed(start);
+
+        start = Clock::now();
+            {
+            MeshView view;
+            MeshIO::mapMeshFile(packed.c_str(), view);
+            }
+        mappedPacked += elapsed(start);
+
+        } // for each run
+
+    // then the codec on its own, from the mapped sections into
+    // buffers allocated up front
+    MeshView view;
+    MeshIO::mapMeshFile(raw.c_str(), view);
+    const uint64_t rawSize = view.file.size;
+    view.file.open(packed.c_str());
+    const uint64_t packedSize = view.file.size;
+
+    double decode = 0.0;
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<const MeshFormat::SectionEntry*> sections;
+
+    const MeshFormat::SectionEntry* table = reinterpret_cast<const MeshFormat::SectionEntry*>(view.file.data + sizeof(MeshFormat::Header));
+    const uint16_t count = reinterpret_cast<const MeshFormat::Header*>(view.file.data)->sectionCount;
+
+    for (uint16_t i = 0; i < count; ++i)
+        if (table[i].flags & MeshFormat::eCompressed)
+            {
+            sections.push_back(&table[i]);
+            buffers.emplace_back((size_t)table[i].count * table[i].stride);
+            }
+
+    uint64_t decodedBytes = 0;
+    for (uint32_t r = 0; r < runs; ++r)
+        {
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < sections.size(); ++i)
+            same = MeshCodec::decode(view.file.data + sections[i]->offset, (size_t)sections[i]->size, buffers[i].data(), buffers[i].size()) && same;
+        decode += elapsed(start);
+        }
+
+    for (const std::vector<uint8_t>& buffer : buffers)
+        decodedBytes += buffer.size();
+
+    view.file.close();
+    std::remove(raw.c_str());
+    std::remove(packed.c_str());
+
+    streamRaw    /= runs;
+    streamPacked /= runs;
+    mappedRaw    /= runs;
+    mappedPacked /= runs;
+    decode       /= runs;
+
+    std::cout << "  size     : " << rawSize << " -> " << packedSize << " bytes (" << (double)rawSize / packedSize << ":1)" << std::endl;
+    std::cout << "  stream   : raw " << streamRaw << "ms (" << gb / (streamRaw / 1000.0) << " GB/s), compressed "
+                                     << streamPacked << "ms (" << gb / (streamPacked / 1000.0) << " GB/s)" << std::endl;
+    std::cout << "  mapped   : raw " << mappedRaw << "ms (" << gb / (mappedRaw / 1000.0) << " GB/s), compressed "
+                                     << mappedPacked << "ms (" << gb / (mappedPacked / 1000.0) << " GB/s)" << std::endl;
+    std::cout << "  decode   : " << decode << "ms (" << decodedBytes / 1e9 / (decode / 1000.0) << " GB/s) on "
+                                 << Parallel::threads() << " threads" << std::endl;
+    std::cout << (same ? "  results match" : "  results DIFFER") << std::endl;
+
+    return same ? 0 : 1;
+
+    } // benchCodec
+
+//
+//  benchCache
+//
+//  loads the optimized form of a mesh through a cache in the
+//  given directory twice, the first normally a miss that runs
+//  MeshIO::optimize and the second a hit that only maps
+//
+static int benchCache (const char* path, const char* directory)
+    { // benchCache
+
+    MeshCache cache (directory);
+
+    for (uint32_t run = 0; run < 2; ++run)
+        {
+        Clock::time_point start = Clock::now();
+
+        MeshView view;
+        if (!MeshIO::mapOptimizedMeshFile(path, view, cache))
+            {
+            std::cout << "failed to load " << path << std::endl;
+            return 1;
+            }
+
+        std::cout << (run == 0 ? "  first    : " : "  second   : ") << elapsed(start) << "ms, "
+                  << view.vertices.size << " vertices, " << view.lods.size << " levels, "
+                  << view.meshlets.size << " meshlets" << std::endl;
+        }
+
+    MappedFile source;
+    source.open(path);
+
+    std::cout << "  entry    : " << cache.entry(MeshIO::checksum(source.data, source.size), MeshIO::fingerprint(MeshOptimizeOptions())) << std::endl;
+
+    return 0;
+
+    } // benchCache
+
+//
+//  depthPass
+//
+//  the vertex work of a depth only pass, transforming the
+//  position of every index by its object's matrix, over any
+//  layout with a position and id. returns the nearest depth
+//  so the work is not optimized away
+//
+template <typename V>
+static float depthPass (const V* vertices, const std::vector<uint32_t>& indices, const std::vector<glm::mat4>& models)
+    { // depthPass
+
+    float nearest = 1.0f;
+    for (uint32_t index : indices)
+        {
+        const V& v = vertices[index];
+        glm::vec4 clip = models[v.id] * glm::vec4(v.position, 1.0f);
+        nearest = std::min(nearest, clip.z / clip.w);
+        }
+
+    return nearest;
+
+    } // depthPass
+
+//
+//  benchStreams
+//
+//  batches copies of a mesh as the renderer does, splits the
+//  vertices into position and attribute streams and compares a
+//  depth only pass over each layout, in time on the cpu and in
+//  bytes fetched through the vertex fetch model
+//
+static int benchStreams (const char* path, uint32_t runs)
+    { // benchStreams
+
+    MeshView view;
+    if (!MeshIO::mapMeshFile(path, view))
+        {
+        std::cout << "failed to map " << path << std::endl;
+        return 1;
+        }
+
+    const uint32_t objects = 64;
+
+    std::vector<MeshBatchItem> items (objects);
+    std::vector<glm::mat4>     models (objects, glm::mat4(1.0f));
+    for (uint32_t i = 0; i < objects; ++i)
+        {
+        items[i].vertices  = view.vertices;
+        items[i].indices   = view.indices;
+        items[i].indices16 = view.indices16;
+        items[i].id        = static_cast<int32_t>(i);
+
+        models[i][3] = glm::vec4((float)(i % 8), 0.0f, 2.0f + (float)(i / 8), 1.0f);
+        models[i][2][3] = 1.0f;
+        }
+
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+    MeshIO::merge(vertices, indices, items);
+
+    std::vector<VertexPosition>   positions;
+    std::vector<VertexAttributes> attributes;
+    MeshIO::splitStreams(vertices.data(), vertices.size(), positions, attributes);
+
+    // the faster of each run, alternating so neither layout
+    // always goes first
+    double interleaved = 1e30, split = 1e30;
+    float  interleavedDepth = 0.0f, splitDepth = 0.0f;
+    for (uint32_t run = 0; run < runs; ++run)
+        {
+        Clock::time_point start = Clock::now();
+        interleavedDepth = depthPass(vertices.data(), indices, models);
+        interleaved = std::min(interleaved, elapsed(start));
+
+        start = Clock::now();
+        splitDepth = depthPass(positions.data(), indices, models);
+        split = std::min(split, elapsed(start));
+        }
+
+    VertexFetchStats interleavedFetch = MeshIO::analyzeVertexFetch(indices.data(), indices.size(), vertices.size(), sizeof(Vertex));
+    VertexFetchStats splitFetch       = MeshIO::analyzeVertexFetch(indices.data(), indices.size(), vertices.size(), sizeof(VertexPosition));
+
+    const bool same = interleavedDepth == splitDepth;
+
+    std::cout << "  objects     : " << objects << ", " << vertices.size() << " vertices, " << indices.size() << " indices" << std::endl;
+    std::cout << "  interleaved : " << interleaved << "ms, " << interleavedFetch.fetched / 1024 << " KB fetched" << std::endl;
+    std::cout << "  split       : " << split       << "ms, " << splitFetch.fetched       / 1024 << " KB fetched ("
+                                    << (float)splitFetch.fetched / (float)interleavedFetch.fetched << "x)" << std::endl;
+    std::cout << (same ? "  results match" : "  results DIFFER") << std::endl;
+
+    return same ? 0 : 1;
+
+    } // benchStreams
+
+//
+//  benchProgressive
+//
+//  times opening a progressive mesh to its coarsest level and
+//  each refinement after, against reading the file whole, and
+//  checks the streamed arrays end up the same
+//
+static int benchProgressive (const char* path, uint32_t runs)
+    { // benchProgressive
+
+    MeshAsset asset;
+    double    whole = 1e30;
+    for (uint32_t run = 0; run < runs; ++run)
+        {
+        Clock::time_point start = Clock::now();
+        if (!MeshIO::readMeshAsset(path, asset))
+            {
+            std::cout << "failed to read " << path << std::endl;
+            return 1;
+            }
+        whole = std::min(whole, elapsed(start));
+        }
+
+    // the fastest of each step over the runs
+    std::vector<double> steps;
+    MeshStream          stream;
+
+    for (uint32_t run = 0; run < runs; ++run)
+        {
+        Clock::time_point start = Clock::now();
+        if (!MeshIO::openMeshStream(path, stream))
+            {
+            std::cout << "failed to open " << path << std::endl;
+            return 1;
+            }
+
+        std::vector<double> times (1, elapsed(start));
+        while (stream.finest > 0)
+            {
+            start = Clock::now();
+            if (!MeshIO::refineMeshStream(stream))
+                {
+                std::cout << "failed to refine " << path << std::endl;
+                return 1;
+                }
+            times.push_back(elapsed(start));
+            }
+
+        steps.resize(times.size(), 1e30);
+        for (size_t i = 0; i < times.size(); ++i)
+            steps[i] = std::min(steps[i], times[i]);
+        }
+
+    if (steps.size() == 1)
+        std::cout << "  not progressive, read whole" << std::endl;
+
+    double total = 0.0;
+    for (size_t i = 0; i < steps.size(); ++i)
+        {
+        total += steps[i];
+        std::cout << "  lod " << steps.size() - 1 - i << " : " << steps[i] << "ms, " << total << "ms in" << std::endl;
+        }
+
+    std::cout << "  whole : " << whole << "ms" << std::endl;
+
+    std::vector<uint32_t> indices (stream.indices16.begin(), stream.indices16.end());
+    indices.insert(indices.end(), stream.indices.begin(), stream.indices.end());
+
+    const bool same =
+        MeshIO::checksum(stream.vertices.data(), sizeof(Vertex) * stream.vertices.size()) ==
+        MeshIO::checksum(asset.vertices.data(),  sizeof(Vertex) * asset.vertices.size()) &&
+        indices == asset.indices;
+
+    std::cout << (same ? "  results match" : "  results DIFFER") << std::endl;
+
+    return same ? 0 : 1;
+
+    } // benchProgressive
+
+//
+//  benchCull
+//
+//  scatters spheres through a cube around the renderer's camera,
+//  checks each culling kernel keeps exactly the spheres the scalar
+//  reference does, in the same order, then times them in objects
+//  culled per microsecond
+//
+static int benchCull (uint32_t objects, uint32_t runs)
+    { // benchCull
+
+    // the camera of the renderer, looking down -y from above the
+    // arrangement and spaced as it spaces objects, so some of the
+    // spheres are in view and the rest are culled
+    const glm::vec3 eye    = { 0.0f, 16.0f, 0.0f };
+    const float     extent = 2.5f * std::sqrt((float)objects);
+
+    glm::mat4 proj = glm::perspective(1.0f, 1.0f, 0.01f, std::max(100.0f, 4.0f * extent));
+    proj[1][1] *= -1;
+    glm::mat4 view = glm::lookAt(eye, eye + glm::vec3 { 0.0f, -1.0f, 0.0f }, glm::vec3 { 0.0f, 0.0f, 1.0f });
+
+    const Frustum::Planes planes = Frustum::planes(proj * view);
+
+    std::default_random_engine            rng    (objects);
+    std::uniform_real_distribution<float> place  (-extent, extent);
+    std::uniform_real_distribution<float> radius (0.1f, 1.0f);
+
+    Frustum::Spheres spheres;
+    spheres.resize(objects);
+    for (uint32_t i = 0; i < objects; ++i)
+        {
+        spheres.x[i]      = place(rng);
+        spheres.y[i]      = place(rng);
+        spheres.z[i]      = place(rng);
+        spheres.radius[i] = radius(rng);
+        }
+
+    std::vector<uint32_t> reference (objects);
+    reference.resize(Frustum::cullScalar(spheres, planes, reference.data()));
+
+    std::cout << "  " << objects << " spheres, " << reference.size() << " in view" << std::endl;
+
+    struct Kernel
+        {
+        const char* name;
+        size_t      (*cull) (const Frustum::Spheres&, const Frustum::Planes&, uint32_t*);
+        };
+
+    std::vector<Kernel> kernels = { { "scalar", Frustum::cullScalar } };
+#if defined(FRUSTUM_SSE2)
+    kernels.push_back({ "sse2  ", Frustum::cullSSE });
+#endif
+#if defined(FRUSTUM_AVX2)
+    if (Cpu::avx2())
+        kernels.push_back({ "avx2  ", Frustum::cullAVX2 });
+#endif
+
+    bool valid = true;
+
+    for (const Kernel& kernel : kernels)
+        { // for each kernel
+
+        std::vector<uint32_t> visible (objects);
+        visible.resize(kernel.cull(spheres, planes, visible.data()));
+
+        const bool same = visible == reference;
+        valid = valid && same;
+
+        visible.resize(objects);
+
+        Clock::time_point start = Clock::now();
+        for (uint32_t r = 0; r < runs; ++r)
+            kernel.cull(spheres, planes, visible.data());
+        double ms = elapsed(start) / runs;
+
+        std::cout << "  cull " << kernel.name << " : " << ms << "ms, "
+                  << (double)objects / (ms * 1000.0) << " objects/us"
+                  << (same ? "" : "  MISMATCH") << std::endl;
+
+        } // for each kernel
+
+    std::cout << (valid ? "  kernels agree" : "  kernels DISAGREE") << std::endl;
+
+    return valid ? 0 : 1;
+
+    } // benchCull
+
+int main (int argc, const char* argv[])
+    { // main
+
+    if (argc < 2)
+        {
+        usage();
+        return 1;
+        }
+
+    std::string command = argv[1];
+
+    if (command == "info" && argc >= 3)
+        return info(argv[2]);
+
+    if (command == "convert" && argc >= 4)
+        return convert(argv[2], argv[3]);
+
+    if (command == "compress" && argc >= 4)
+        return compress(argv[2], argv[3]);
+
+    if (command == "import" && argc >= 4)
+        return import(argv[2], argv[3]);
+
+    if (command == "generate" && argc >= 5)
+        return generate(argv[2], std::stoull(argv[3]), argv[4], argc >= 6 ? (uint32_t)std::stoul(argv[5]) : 0);
+
+    if (command == "quantize" && argc >= 4)
+        return quantize(argv[2], argv[3]);
+
+    if (command == "weld" && argc >= 4)
+        return weld(argv[2], argv[3], argc >= 5 ? std::stof(argv[4]) : 0.0f);
+
+    if (command == "lod" && argc >= 4)
+        return lod(argv[2], argv[3], argc >= 5 ? std::stof(argv[4]) : 0.05f);
+
+    if (command == "meshlets" && argc >= 4)
+        return meshlets(argv[2], argv[3]);
+
+    if (command == "progressive" && argc >= 4)
+        return progressive(argv[2], argv[3]);
+
+    if (command == "optimize" && argc >= 4)
+        return optimize(argv[2], argv[3], argc >= 5 ? std::stof(argv[4]) : 1.05f);
+
+    if (command == "bench-load" && argc >= 3)
+        return benchLoad(argv[2], argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 16);
+
+    if (command == "bench-bounds" && argc >= 3)
+        return benchBounds(argv[2], argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 16);
+
+    if (command == "bench-merge" && argc >= 3)
+        return benchMerge(argv[2], argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 64);
+
+    if (command == "bench-codec" && argc >= 3)
+        return benchCodec(argv[2], argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 16);
+
+    if (command == "bench-cache" && argc >= 4)
+        return benchCache(argv[2], argv[3]);
+
+    if (command == "bench-streams" && argc >= 3)
+        return benchStreams(argv[2], argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 16);
+
+    if (command == "bench-progressive" && argc >= 3)
+        return benchProgressive(argv[2], argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 16);
+
+    if (command == "bench-cull")
+        return benchCull(argc >= 3 ? (uint32_t)std::stoul(argv[2]) : 1000000, argc >= 4 ? (uint32_t)std::stoul(argv[3]) : 64);
+
+    usage();
+    return 1;
+
+    } // main